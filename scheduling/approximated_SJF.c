@@ -1,145 +1,530 @@
 // scheduling/approximated_SJF.c
 // Note that the scheduling mechanism is PREEMPTIVE
+// Tasks are streamed from a workload trace, and only the tasks that have arrived but not
+// completed are kept in memory.
+//
+// A task may alternate CPU and I/O bursts over its lifetime(--bursts). The scheduler cannot know
+// how long the next CPU burst will be, so it predicts it from the previous ones by exponential
+// averaging: after every CPU burst, prediction = alpha * burst + (1 - alpha) * prediction.
+// Ready tasks are kept in a min-heap on their predicted burst, and the tasks that are doing I/O
+// in a min-heap on the time they become ready again.
+//
+// With more than one burst, the bursts of a task are drawn around a typical burst, which starts
+// at the burst time of its record. Every burst is the typical one give or take half of it, and
+// now and then the task moves to a new phase with another typical burst, like an interactive
+// program switching between activities. A small alpha smooths out the noise within a phase, a
+// large alpha follows the phase changes sooner.
+//
+// Switching to another task can cost time(see switch_cost.h): the clock moves past the cost
+// before the task runs, and the task runs for at least one unit(or its whole burst, if shorter) even
+// if the switch took it past the next event, so a preempted task that keeps being switched out still
+// makes progress.
+//
+// Usage: ./approximated_SJF.out          (small demo with a full timeline)
+//        ./approximated_SJF.out <trace> [--alpha alpha] [--bursts burstsPerTask] [--io ioTime] [--metrics]
+//               [--timeline gantt|csv|json] [--timeline-output path]
+//               [--switch-cost ns] [--refill-cost ns] [--warmth-decay ns] [--unit-length ns]
+//               [--calibrate [--working-set bytes]]
+//               (replay a workload trace, summary only. --metrics prints one line of key=value pairs instead.
+//                --timeline records the runs and renders them once the simulation is over(see timeline.h).
+//                The switch cost options charge every context switch, and --calibrate measures the costs on this host.)
+#define _GNU_SOURCE
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <stdbool.h>
+#include <limits.h>
+#include <time.h>
+#include "workload_trace.h"
+#include "scheduling_metrics.h"
+#include "timeline.h"
+#include "burst_prediction.h"
+#include "switch_cost.h"
 
-#define ALPHA 0.5  // Alpha value for exponential averaging
+#define ALPHA 0.5                   // Default alpha value for exponential averaging
+#define BURSTS_PER_TASK 1           // Default number of CPU bursts of a task
+#define IO_TIME 10                  // Default average length of an I/O burst
+#define PHASE_CHANGE_ONE_IN 16      // A task moves to a new phase once every this many bursts on average
 
 typedef struct {
-    unsigned int id;                // Task ID
-    unsigned int cpuBurstTime;      // Actual burst time (remaining time)
-    unsigned int originalBurstTime; // Original burst time for printing
-    double predictedBurst;          // Predicted burst time using exponential decay
-    unsigned int arrivalTime;       // When the task arrives at the CPU scheduler
-    unsigned int waitingTime;       // Time the task has waited in the queue
-    int startTime;                  // Time when the task starts execution (-1 if not started)
-    unsigned int endTime;           // Time when the task finishes execution
-    bool isCompleted;               // Flag to track whether task is done
+    unsigned int id;                        // Task ID
+    unsigned long long cpuBurstTime;        // Time left in the current CPU burst
+    unsigned long long currentBurstTime;    // Length of the current CPU burst
+    double predictedBurst;                  // Predicted length of the current CPU burst
+    unsigned long long arrivalTime;         // When the task arrives at the CPU scheduler
+    unsigned long long waitingTime;         // Time the task has waited in the queue
+    long long startTime;                    // Time when the task starts execution (-1 if not started)
+    unsigned long long endTime;             // Time when the task finishes execution
+    unsigned long long totalCpuTime;        // Sum of the CPU bursts so far
+    unsigned long long totalIoTime;         // Sum of the I/O bursts so far
+    unsigned int burstsLeft;                // CPU bursts left, the current one included
+    unsigned long long recordBurstTime;     // Burst time of the record of the task
+    unsigned long long typicalBurst;        // Around which the bursts of the current phase are drawn
+    unsigned long long randomState;         // State of the generator of the bursts of this task
+    unsigned long long lastRunEnd;          // When the task last left the CPU
 } task;
 
-// Function to find the next task based on predicted burst time
-int findNextTask(task tasks[], unsigned int numberOfTasks, unsigned int currentTimestamp) {
-    int shortestBurstTaskIndex = -1;
-    
-    for (unsigned int index = 0; index < numberOfTasks; index++) {
-        if (!tasks[index].isCompleted && tasks[index].arrivalTime <= currentTimestamp) {
-            if (shortestBurstTaskIndex == -1 ||
-                tasks[index].predictedBurst < tasks[shortestBurstTaskIndex].predictedBurst) {
-                shortestBurstTaskIndex = index;
-            }
+// Tasks that have arrived but not completed yet. The slot of a completed task is reused.
+typedef struct {
+    task* tasks;
+    unsigned int capacity;
+    unsigned int* freeSlots;
+    unsigned int numberOfFreeSlots;
+} taskPool;
+
+// Binary min-heap of pool slots on (key, sequence). The key is a predicted burst in the ready heap
+// and a wake-up time in the I/O heap(times are exact as doubles up to 2^53).
+typedef struct {
+    double key;
+    unsigned long long sequence;    // Order in which the task became ready, used to break ties
+    unsigned int slot;
+} heapEntry;
+
+typedef struct {
+    heapEntry* entries;
+    unsigned int size;
+    unsigned int capacity;
+} taskHeap;
+
+typedef struct {
+    unsigned long long numberOfTasks;       // Number of completed tasks
+    unsigned long long totalWaitingTime;    // Sum of the waiting time of every task
+    unsigned long long totalTime;           // Time when the last task finished
+    schedulingMetrics metrics;
+    unsigned long long numberOfBursts;      // Number of completed CPU bursts
+    double totalPredictionError;            // Sum of |predicted - actual| over the bursts
+    double totalSignedPredictionError;      // Sum of predicted - actual: positive when the predictor overestimates
+    latencyHistogram predictionErrors;      // |predicted - actual|, rounded to the closest unit
+    unsigned long long numberOfDecisions;   // Number of times a task was picked
+    double elapsedSeconds;                  // Host time taken by the simulation
+} schedulingSummary;
+
+// Function to draw the next number of a task's generator(xorshift64*)
+unsigned long long nextRandom(unsigned long long* state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 2685821657736338717ULL;
+}
+
+// Function to draw the length of the next CPU burst of a task with more than one burst
+unsigned long long drawCpuBurst(task* currentTask) {
+    if (currentTask->recordBurstTime == 0)
+        return 0;
+    if (nextRandom(&currentTask->randomState) % PHASE_CHANGE_ONE_IN == 0)
+        currentTask->typicalBurst = 1 + nextRandom(&currentTask->randomState) % (2 * currentTask->recordBurstTime);
+
+    unsigned long long spread = currentTask->typicalBurst / 2;
+    return currentTask->typicalBurst - spread + nextRandom(&currentTask->randomState) % (2 * spread + 1);
+}
+
+// Function to add a newly arrived task to the pool. Returns its slot, or -1 if the pool could not grow.
+// Without any history, the first prediction of a task is the burst time of its record.
+int admitTask(taskPool* pool, const workloadRecord* record, unsigned int burstsPerTask) {
+    if (pool->numberOfFreeSlots == 0) {
+        unsigned int newCapacity = (pool->capacity == 0) ? 64 : pool->capacity * 2;
+        task* newTasks = realloc(pool->tasks, newCapacity * sizeof(task));
+        if (newTasks == NULL) {
+            perror("realloc");
+            return -1;
         }
+        pool->tasks = newTasks;
+        unsigned int* newFreeSlots = realloc(pool->freeSlots, newCapacity * sizeof(unsigned int));
+        if (newFreeSlots == NULL) {
+            perror("realloc");
+            return -1;
+        }
+        pool->freeSlots = newFreeSlots;
+        for (unsigned int slot = newCapacity; slot > pool->capacity; slot--)
+            pool->freeSlots[pool->numberOfFreeSlots++] = slot - 1;
+        pool->capacity = newCapacity;
     }
 
-    return shortestBurstTaskIndex;
+    unsigned int slot = pool->freeSlots[--pool->numberOfFreeSlots];
+    task newTask = {record->id, record->cpuBurstTime, record->cpuBurstTime, (double)record->cpuBurstTime,
+                    record->arrivalTime, 0, -1, 0, 0, 0, burstsPerTask, record->cpuBurstTime,
+                    record->cpuBurstTime, 0x9E3779B97F4A7C15ULL * (record->id + 1ULL), 0};
+    if (burstsPerTask > 1) {
+        newTask.currentBurstTime = drawCpuBurst(&newTask);
+        newTask.cpuBurstTime = newTask.currentBurstTime;
+    }
+    pool->tasks[slot] = newTask;
+    return (int)slot;
 }
 
-// Function to calculate the predicted burst time using exponential averaging
-double calculatePrediction(double alpha, double previousAverage, double newValue) {
-    return (alpha * newValue) + ((1 - alpha) * previousAverage);
+void destroyTaskPool(taskPool* pool) {
+    free(pool->tasks);
+    free(pool->freeSlots);
 }
 
-// Function to perform Approximated Shortest Job First (SJF) Scheduling (Preemptive)
-void approximatedSJF(task tasks[], unsigned int numberOfTasks) {
-    // Initialize original burst times and start times
-    for (unsigned int index = 0; index < numberOfTasks; index++) {
-        tasks[index].originalBurstTime = tasks[index].cpuBurstTime;
-        tasks[index].startTime = -1;  // Not started yet
+bool isEntryBefore(const heapEntry* a, const heapEntry* b) {
+    if (a->key != b->key)
+        return a->key < b->key;
+    return a->sequence < b->sequence;
+}
+
+// Function to add a slot to a heap, O(log n)
+int pushTask(taskHeap* heap, double key, unsigned long long sequence, unsigned int slot) {
+    if (heap->size == heap->capacity) {
+        unsigned int newCapacity = (heap->capacity == 0) ? 64 : heap->capacity * 2;
+        heapEntry* newEntries = realloc(heap->entries, newCapacity * sizeof(heapEntry));
+        if (newEntries == NULL) {
+            perror("realloc");
+            return -1;
+        }
+        heap->entries = newEntries;
+        heap->capacity = newCapacity;
+    }
+
+    heapEntry entry = {key, sequence, slot};
+    unsigned int index = heap->size++;
+    while (index > 0) {
+        unsigned int parent = (index - 1) / 2;
+        if (!isEntryBefore(&entry, &heap->entries[parent]))
+            break;
+        heap->entries[index] = heap->entries[parent];
+        index = parent;
     }
+    heap->entries[index] = entry;
+    return 0;
+}
+
+// Function to take the smallest entry off a heap, O(log n)
+heapEntry popTask(taskHeap* heap) {
+    heapEntry top = heap->entries[0];
+    heapEntry last = heap->entries[--heap->size];
+    unsigned int index = 0;
 
-    unsigned int currentTimestamp = 0;
-    unsigned int totalWaitingTime = 0;
-    unsigned int numberOfCompletedTasks = 0;
-    int previousTaskIndex = -1;
+    while (true) {
+        unsigned int child = 2 * index + 1;
+        if (child >= heap->size)
+            break;
+        if (child + 1 < heap->size && isEntryBefore(&heap->entries[child + 1], &heap->entries[child]))
+            child++;
+        if (!isEntryBefore(&heap->entries[child], &last))
+            break;
+        heap->entries[index] = heap->entries[child];
+        index = child;
+    }
+    if (heap->size > 0)
+        heap->entries[index] = last;
+    return top;
+}
+
+double elapsedSeconds(const struct timespec* start, const struct timespec* end) {
+    return (double)(end->tv_sec - start->tv_sec) + (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// Function to perform Approximated Shortest Job First (SJF) Scheduling (Preemptive)
+// Predictions only change between two CPU bursts, so the choice can only change when a task
+// arrives, comes back from I/O, or finishes a burst. The clock jumps between those events instead
+// of moving tick by tick.
+// If recordedTimeline is not NULL, every run of a task is recorded into it.
+// If finishedTasks is not NULL, every completed task is copied into it.
+// If switchCosts is not NULL, every switch to another task is charged before the task runs.
+int approximatedSJF(workloadTrace* trace, double alpha, unsigned int burstsPerTask, unsigned long long ioTime,
+        bool printTimeline, timeline* recordedTimeline, task finishedTasks[], schedulingSummary* summary,
+        switchCostModel* switchCosts) {
+    taskPool pool = {NULL, 0, NULL, 0};
+    taskHeap readyTasks = {NULL, 0, 0};
+    taskHeap ioTasks = {NULL, 0, 0};
+    unsigned long long currentTimestamp = 0;
+    unsigned long long sequence = 0;
+    int previousTaskSlot = -1;
+    int result = 0;
+    struct timespec start, end;
+
+    summary->numberOfTasks = 0;
+    summary->totalWaitingTime = 0;
+    summary->totalTime = 0;
+    initSchedulingMetrics(&summary->metrics);
+    summary->numberOfBursts = 0;
+    summary->totalPredictionError = 0.0;
+    summary->totalSignedPredictionError = 0.0;
+    initLatencyHistogram(&summary->predictionErrors);
+    summary->numberOfDecisions = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
 
     // To track the timeline of process execution
-    printf("Timeline of process execution:\n");
-
-    while (numberOfCompletedTasks < numberOfTasks) {
-        // Continue scheduling until every task is marked as "completed"
-        int nextTaskIndex = findNextTask(tasks, numberOfTasks, currentTimestamp);
-        if (nextTaskIndex == -1) {
-            // No task is available to execute at the current timestamp
-            currentTimestamp++;
+    if (printTimeline)
+        printf("Timeline of process execution:\n");
+
+    while (true) {
+        // Admit the tasks that have arrived by now
+        while (hasArrivalBy(trace, currentTimestamp)) {
+            int slot = admitTask(&pool, nextWorkloadRecord(trace), burstsPerTask);
+            if (slot == -1 || pushTask(&readyTasks, pool.tasks[slot].predictedBurst, sequence++, slot) == -1) {
+                result = -1;
+                break;
+            }
+        }
+
+        // Tasks whose I/O is over are ready again, with the prediction for their next burst
+        while (result == 0 && ioTasks.size > 0 && ioTasks.entries[0].key <= (double)currentTimestamp) {
+            unsigned int wokenSlot = popTask(&ioTasks).slot;
+            task* wokenTask = &pool.tasks[wokenSlot];
+            wokenTask->predictedBurst = calculatePrediction(alpha, wokenTask->predictedBurst, (double)wokenTask->currentBurstTime);
+            wokenTask->currentBurstTime = drawCpuBurst(wokenTask);
+            wokenTask->cpuBurstTime = wokenTask->currentBurstTime;
+            if (pushTask(&readyTasks, wokenTask->predictedBurst, sequence++, wokenSlot) == -1)
+                result = -1;
+        }
+        if (result == -1)
+            break;
+
+        // The next event that may change the choice: an arrival or the end of an I/O burst
+        const workloadRecord* nextArrival = peekWorkloadRecord(trace);
+        unsigned long long nextEventTime = (nextArrival != NULL) ? nextArrival->arrivalTime : ULLONG_MAX;
+        if (ioTasks.size > 0 && (unsigned long long)ioTasks.entries[0].key < nextEventTime)
+            nextEventTime = (unsigned long long)ioTasks.entries[0].key;
+
+        if (readyTasks.size == 0) {
+            if (nextEventTime == ULLONG_MAX)
+                break;  // Every task is completed
+
+            // No task is available, so jump over the idle gap to the next event
+            currentTimestamp = nextEventTime;
             continue;
         }
 
-        task *nextTask = &tasks[nextTaskIndex];
+        heapEntry nextEntry = popTask(&readyTasks);
+        int nextTaskSlot = (int)nextEntry.slot;
+        task *nextTask = &pool.tasks[nextTaskSlot];
+        summary->numberOfDecisions++;
+
+        // Pay for the switch if the CPU was running another task(or none)
+        if (switchCosts != NULL && (!summary->metrics.hasLastTask || summary->metrics.lastTaskId != nextTask->id))
+            currentTimestamp += chargeSwitch(switchCosts, currentTimestamp, nextTask->startTime != -1, nextTask->lastRunEnd);
 
         // Start time calculation
         if (nextTask->startTime == -1) {
             nextTask->startTime = currentTimestamp;
         }
+        recordDispatch(&summary->metrics, nextTask->id);
 
-        // Update waiting time for all other tasks that have arrived but are not running
-        for (unsigned int index = 0; index < numberOfTasks; index++) {
-            if (!tasks[index].isCompleted && tasks[index].arrivalTime <= currentTimestamp && index != nextTaskIndex) {
-                tasks[index].waitingTime++;
+        // Run the task until its burst ends or the next event, whichever comes first
+        unsigned long long runTime = nextTask->cpuBurstTime;
+        if (nextEventTime <= currentTimestamp)
+            runTime = (nextTask->cpuBurstTime < 1) ? nextTask->cpuBurstTime : 1;    // The switch ran past the next event
+        else if (nextEventTime - currentTimestamp < runTime)
+            runTime = nextEventTime - currentTimestamp;
+
+        if (printTimeline) {
+            if (previousTaskSlot != -1 && previousTaskSlot != nextTaskSlot) {
+                // If
+                // - the previous task is not completed and
+                // - the previous task is not the same as the current task (the task changed)
+                // then the previous task was preempted
+                printf("At timestamp %llu, task %u was preempted by task %u.\n", currentTimestamp, pool.tasks[previousTaskSlot].id, nextTask->id);
             }
+            printf("From timestamp %llu to %llu, task %u was executed.\n", currentTimestamp, currentTimestamp + runTime, nextTask->id);
         }
-
-        // Execute the current task for one unit of time
-        if (previousTaskIndex != -1 && previousTaskIndex != nextTaskIndex && tasks[previousTaskIndex].cpuBurstTime > 0) {
-            // If
-            // - the previous task is not completed and
-            // - the previous task is not the same as the current task (the task changed) and
-            // - the previous task still has some burst time left
-            // then the previous task was preempted
-            printf("At timestamp %u, task %u was preempted by task %u.\n", currentTimestamp, tasks[previousTaskIndex].id, nextTask->id);
-        } else {
-            printf("At timestamp %u, task %u was executed.\n", currentTimestamp, nextTask->id);
+        if (recordedTimeline != NULL && recordRun(recordedTimeline, nextTask->id, currentTimestamp, runTime) == -1) {
+            result = -1;
+            break;
         }
-        currentTimestamp++;
-        nextTask->cpuBurstTime--;
-        previousTaskIndex = nextTaskIndex;      // Transition to the next task
+        currentTimestamp += runTime;
+        nextTask->cpuBurstTime -= runTime;
+        nextTask->lastRunEnd = currentTimestamp;
+        previousTaskSlot = nextTaskSlot;      // Transition to the next task
 
-        // If the current task is completed, update the end time and mark it as completed
-        if (nextTask->cpuBurstTime == 0) {
-            nextTask->endTime = currentTimestamp;
-            nextTask->isCompleted = true;
-            numberOfCompletedTasks++;
+        if (nextTask->cpuBurstTime > 0) {
+            // Preempted: back into the ready heap, in the same place among the ties as before
+            if (pushTask(&readyTasks, nextEntry.key, nextEntry.sequence, nextEntry.slot) == -1) {
+                result = -1;
+                break;
+            }
+            continue;
+        }
 
-            // Update predicted burst time for the next iteration using exponential averaging
-            nextTask->predictedBurst = calculatePrediction(ALPHA, nextTask->predictedBurst, nextTask->originalBurstTime);
+        // The CPU burst is over: score the prediction that was used for it
+        double predictionError = nextTask->predictedBurst - (double)nextTask->currentBurstTime;
+        double absolutePredictionError = (predictionError < 0) ? -predictionError : predictionError;
+        summary->numberOfBursts++;
+        summary->totalPredictionError += absolutePredictionError;
+        summary->totalSignedPredictionError += predictionError;
+        recordLatency(&summary->predictionErrors, (unsigned long long)(absolutePredictionError + 0.5));
+        nextTask->totalCpuTime += nextTask->currentBurstTime;
+        nextTask->burstsLeft--;
+        previousTaskSlot = -1;
 
-            // Update total waiting time
-            totalWaitingTime += nextTask->waitingTime;
+        if (nextTask->burstsLeft > 0) {
+            // Off to I/O. The prediction is updated when the task comes back.
+            unsigned long long ioBurstTime = 1 + nextRandom(&nextTask->randomState) % (2 * ioTime);
+            nextTask->totalIoTime += ioBurstTime;
+            if (printTimeline)
+                printf("At timestamp %llu, task %u started an I/O burst of %llu units.\n", currentTimestamp, nextTask->id, ioBurstTime);
+            if (pushTask(&ioTasks, (double)(currentTimestamp + ioBurstTime), sequence++, nextEntry.slot) == -1) {
+                result = -1;
+                break;
+            }
+            continue;
         }
+
+        // If the current task is completed, update the end time
+        nextTask->endTime = currentTimestamp;
+
+        // Every moment between the arrival and the end that the task was neither running nor doing I/O, it was waiting
+        nextTask->waitingTime = nextTask->endTime - nextTask->arrivalTime - nextTask->totalCpuTime - nextTask->totalIoTime;
+
+        // Update total waiting time
+        summary->totalWaitingTime += nextTask->waitingTime;
+        summary->totalTime = currentTimestamp;
+        recordCompletion(&summary->metrics, nextTask->arrivalTime, (unsigned long long)nextTask->startTime, nextTask->endTime, nextTask->waitingTime);
+        if (finishedTasks != NULL)
+            finishedTasks[summary->numberOfTasks] = *nextTask;
+        summary->numberOfTasks++;
+
+        pool.freeSlots[pool.numberOfFreeSlots++] = nextEntry.slot;
     }
 
-    // Display results and average waiting time
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    summary->elapsedSeconds = elapsedSeconds(&start, &end);
+
+    destroyTaskPool(&pool);
+    free(readyTasks.entries);
+    free(ioTasks.entries);
+    return result;
+}
+
+int compareTaskId(const void* a, const void* b) {
+    const task* taskA = a;
+    const task* taskB = b;
+    return (taskA->id > taskB->id) - (taskA->id < taskB->id);
+}
+
+// Function to display the status of every task
+void displayTaskStatus(task tasks[], unsigned int numberOfTasks) {
+    // Tasks are stored in the order they completed. Show them in the order of their ID.
+    qsort(tasks, numberOfTasks, sizeof(task), compareTaskId);
+
     printf("\nTaskID\tBurstTime\tArrivalTime\tWaitingTime\tStartTime\tEndTime\n");
     for (unsigned int index = 0; index < numberOfTasks; index++) {
         task currentTask = tasks[index];
-        printf("%d\t%d\t\t%d\t\t%d\t\t%d\t\t%d\n",
+        printf("%u\t%llu\t\t%llu\t\t%llu\t\t%lld\t\t%llu\n",
                     currentTask.id,
-                    currentTask.originalBurstTime,
+                    currentTask.totalCpuTime,
                     currentTask.arrivalTime,
                     currentTask.waitingTime,
                     currentTask.startTime,
                     currentTask.endTime);
     }
+}
 
-    printf("Average waiting time: %.2f\n", (double)totalWaitingTime / numberOfTasks);
-    printf("Throughput: %.2f tasks per unit time\n", (double)numberOfTasks / currentTimestamp);
-    printf("Total time taken: %d units\n", currentTimestamp);
+// Function to display the average waiting time and the throughput
+void displaySummary(const schedulingSummary* summary, const switchCostModel* switchCosts) {
+    if (summary->numberOfTasks == 0) {
+        printf("No tasks\n");
+        return;
+    }
+    printf("Average waiting time: %.2f\n", (double)summary->totalWaitingTime / summary->numberOfTasks);
+    printf("Throughput: %.2f tasks per unit time\n", (double)summary->numberOfTasks / summary->totalTime);
+    printf("Total time taken: %llu units\n", summary->totalTime);
+    printLatencyReport(&summary->metrics);
+    if (switchCosts != NULL)
+        printSwitchCostReport(switchCosts, summary->totalTime);
+}
+
+// Function to display how well the bursts were predicted, and what each scheduling decision cost
+void displayPredictionReport(const schedulingSummary* summary) {
+    printf("CPU bursts: %llu\n", summary->numberOfBursts);
+    if (summary->numberOfBursts > 0)
+        printf("Prediction error: mean absolute %.2f, mean signed %+.2f, p50/p99/max %llu / %llu / %llu\n",
+                summary->totalPredictionError / summary->numberOfBursts,
+                summary->totalSignedPredictionError / summary->numberOfBursts,
+                latencyPercentile(&summary->predictionErrors, 50), latencyPercentile(&summary->predictionErrors, 99),
+                summary->predictionErrors.maxValue);
+    printf("Scheduling decisions: %llu, %.1f ns each\n", summary->numberOfDecisions,
+            summary->numberOfDecisions > 0 ? summary->elapsedSeconds * 1e9 / summary->numberOfDecisions : 0.0);
 }
 
 int main(int argc, char* argv[]) {
-    task tasks[] = {
-        {1, 6, 0, 6.0, 0, 0, 0, -1, false},  // Task 1 with an actual CPU burst time of 6 and arrival time of 0
-        {2, 8, 0, 8.0, 2, 0, 0, -1, false},  // Task 2 with an actual CPU burst time of 8 and arrival time of 2
-        {3, 7, 0, 7.0, 4, 0, 0, -1, false},  // Task 3 with an actual CPU burst time of 7 and arrival time of 4
-        {4, 3, 0, 3.0, 6, 0, 0, -1, false},  // Task 4 with an actual CPU burst time of 3 and arrival time of 6
-        {5, 4, 0, 4.0, 8, 0, 0, -1, false},  // Task 5 with an actual CPU burst time of 4 and arrival time of 8
-        {6, 5, 0, 5.0, 10, 0, 0, -1, false}, // Task 6 with an actual CPU burst time of 5 and arrival time of 10
-        {7, 2, 0, 2.0, 12, 0, 0, -1, false}, // Task 7 with an actual CPU burst time of 2 and arrival time of 12
-        {8, 1, 0, 1.0, 14, 0, 0, -1, false}  // Task 8 with an actual CPU burst time of 1 and arrival time of 14
-    };
+    workloadTrace trace;
+    schedulingSummary summary;
+
+    if (argc > 1) {
+        double alpha = ALPHA;
+        unsigned int burstsPerTask = BURSTS_PER_TASK;
+        unsigned long long ioTime = IO_TIME;
+        bool printMetrics = false;
+        bool recordTimeline = false;
+        timelineFormat format = TIMELINE_GANTT;
+        const char* timelinePath = NULL;
+        switchCostModel switchCosts;
+        initSwitchCostModel(&switchCosts);
+        for (int index = 2; index < argc; index++) {
+            int switchCostOption = parseSwitchCostOption(&switchCosts, argc, argv, &index);
+            if (switchCostOption == 1) {
+                continue;
+            } else if (switchCostOption == -1) {
+                burstsPerTask = 0;  // Reported below
+                break;
+            } else if (strcmp(argv[index], "--metrics") == 0) {
+                printMetrics = true;
+            } else if (strcmp(argv[index], "--alpha") == 0 && index + 1 < argc) {
+                alpha = strtod(argv[++index], NULL);
+            } else if (strcmp(argv[index], "--bursts") == 0 && index + 1 < argc) {
+                burstsPerTask = (unsigned int)strtoul(argv[++index], NULL, 10);
+            } else if (strcmp(argv[index], "--io") == 0 && index + 1 < argc) {
+                ioTime = strtoull(argv[++index], NULL, 10);
+            } else if (strcmp(argv[index], "--timeline") == 0 && index + 1 < argc && parseTimelineFormat(argv[index + 1], &format) == 0) {
+                recordTimeline = true;
+                index++;
+            } else if (strcmp(argv[index], "--timeline-output") == 0 && index + 1 < argc) {
+                timelinePath = argv[++index];
+            } else {
+                burstsPerTask = 0;  // Reported below
+                break;
+            }
+        }
+        if (burstsPerTask == 0 || ioTime == 0) {
+            fprintf(stderr, "Usage: %s <trace> [--alpha alpha] [--bursts burstsPerTask] [--io ioTime] [--metrics] [--timeline gantt|csv|json] [--timeline-output path] "
+                    SWITCH_COST_USAGE "\n", argv[0]);
+            return 1;
+        }
+        if (prepareSwitchCostModel(&switchCosts) == -1)
+            return 1;
+        switchCostModel* chargedSwitchCosts = isSwitchCostEnabled(&switchCosts) ? &switchCosts : NULL;
 
-    unsigned int numberOfTasks = sizeof(tasks) / sizeof(tasks[0]);
+        timeline recordedTimeline;
+        initTimeline(&recordedTimeline);
+        if (openWorkloadTrace(&trace, argv[1]) == -1)
+            return 1;
+        int result = approximatedSJF(&trace, alpha, burstsPerTask, ioTime, false, recordTimeline ? &recordedTimeline : NULL, NULL, &summary,
+                chargedSwitchCosts);
+        closeWorkloadTrace(&trace);
+        if (result == 0) {
+            if (printMetrics) {
+                printSchedulingMetrics(&summary.metrics, summary.numberOfTasks, summary.totalWaitingTime, summary.totalTime);
+            } else {
+                displaySummary(&summary, chargedSwitchCosts);
+                displayPredictionReport(&summary);
+            }
+            if (recordTimeline)
+                result = writeTimeline(&recordedTimeline, format, timelinePath);
+        }
+        destroyTimeline(&recordedTimeline);
+        return (result == 0) ? 0 : 1;
+    }
+
+    workloadRecord records[] = {
+        {.arrivalTime = 0, .cpuBurstTime = 6, .id = 1},     // Task 1 with an actual CPU burst time of 6 and arrival time of 0
+        {.arrivalTime = 2, .cpuBurstTime = 8, .id = 2},     // Task 2 with an actual CPU burst time of 8 and arrival time of 2
+        {.arrivalTime = 4, .cpuBurstTime = 7, .id = 3},     // Task 3 with an actual CPU burst time of 7 and arrival time of 4
+        {.arrivalTime = 6, .cpuBurstTime = 3, .id = 4},     // Task 4 with an actual CPU burst time of 3 and arrival time of 6
+        {.arrivalTime = 8, .cpuBurstTime = 4, .id = 5},     // Task 5 with an actual CPU burst time of 4 and arrival time of 8
+        {.arrivalTime = 10, .cpuBurstTime = 5, .id = 6},    // Task 6 with an actual CPU burst time of 5 and arrival time of 10
+        {.arrivalTime = 12, .cpuBurstTime = 2, .id = 7},    // Task 7 with an actual CPU burst time of 2 and arrival time of 12
+        {.arrivalTime = 14, .cpuBurstTime = 1, .id = 8}     // Task 8 with an actual CPU burst time of 1 and arrival time of 14
+    };
+    unsigned int numberOfTasks = sizeof(records) / sizeof(records[0]);
+    task tasks[sizeof(records) / sizeof(records[0])];
 
     // Perform Approximate SJF scheduling
-    approximatedSJF(tasks, numberOfTasks);
+    openWorkloadTraceFromRecords(&trace, records, numberOfTasks);
+    approximatedSJF(&trace, ALPHA, BURSTS_PER_TASK, IO_TIME, true, NULL, tasks, &summary, NULL);
+    displayTaskStatus(tasks, numberOfTasks);
+    displaySummary(&summary, NULL);
 
     return 0;
-}
\ No newline at end of file
+}
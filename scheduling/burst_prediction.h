@@ -0,0 +1,14 @@
+// scheduling/burst_prediction.h
+// Prediction of the next CPU burst of a task by exponential averaging, shared by the simulator that
+// schedules on it(approximated_SJF.c) and the sampler that scores it on the bursts of real threads
+// (burst_sampler.c): prediction = alpha * burst + (1 - alpha) * prediction.
+// A large alpha follows the last burst closely, a small one smooths over many bursts.
+#ifndef BURST_PREDICTION_H
+#define BURST_PREDICTION_H
+
+// Function to calculate the predicted burst time using exponential averaging
+static inline double calculatePrediction(double alpha, double previousAverage, double newValue) {
+    return (alpha * newValue) + ((1 - alpha) * previousAverage);
+}
+
+#endif
@@ -0,0 +1,530 @@
+// scheduling/burst_sampler.c
+// Captures the CPU bursts of the threads of a live process, to score the exponential averaging of
+// approximated_SJF.c on real bursts instead of drawn ones.
+//
+// Every thread of the process has its /proc/<pid>/task/<tid>/schedstat and stat opened once. A sample
+// is one pass over those descriptors with pread at offset 0: nothing is opened, seeked or closed.
+// schedstat gives the CPU time the thread has had so far(ns). A thread that has had CPU time since it
+// last blocked is in a CPU burst, and the burst ends when the thread has made no progress since the
+// last sample and stat shows it is not runnable(its state is not R). A runnable thread waiting for a
+// CPU is still in its burst. stat is only read for threads that are in a burst but made no progress,
+// so most samples cost one pread per thread. A thread that blocks and runs again between two samples
+// has its two bursts merged: the sampling interval is the resolution. The first burst of a thread
+// found already running is dropped, since its start was not seen.
+//
+// Every burst of a thread is scored against the prediction made from its previous ones by
+// calculatePrediction()(burst_prediction.h) at several alpha values, the first burst being the first
+// prediction, so the alpha that would have served this program best can be read off.
+//
+// The sampler keeps its own CPU time under a budget(1% of one CPU by default): every quarter of a
+// second, it measures what a sample cost(the reads and the wake-up) and stretches the interval so that
+// samples of that cost take 80% of the budget, but never samples more often than requested.
+//
+// Usage: ./burst_sampler.out                 (demo: samples a child process whose threads alternate CPU and sleep)
+//        ./burst_sampler.out <pid> [--interval microseconds] [--duration seconds] [--alpha alpha[,alpha...]]
+//               [--budget percent] [--rescan milliseconds]
+//               (sample the threads of a process until it exits or the duration is over. New threads are
+//                found by listing /proc/<pid>/task again every rescan interval.)
+// gcc -o burst_sampler.out burst_sampler.c -lpthread -lm
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <time.h>
+#include <math.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "latency_histogram.h"
+#include "burst_prediction.h"
+
+#define NANOSECONDS_PER_SECOND 1000000000ull
+#define NANOSECONDS_PER_MICROSECOND 1000ull
+#define NANOSECONDS_PER_MILLISECOND 1000000ull
+#define SAMPLING_INTERVAL 1000          // Default time between two samples(us)
+#define MAX_SAMPLING_INTERVAL 100000    // Longest interval the budget may stretch it to(us)
+#define CPU_BUDGET 1.0                  // Default CPU time of the sampler, in percent of one CPU
+#define RESCAN_INTERVAL 100             // Default time between two listings of the threads(ms)
+#define BUDGET_WINDOW (NANOSECONDS_PER_SECOND / 4)  // Time between two checks of the budget
+#define BUDGET_TARGET 0.8               // Fraction of the budget the sampler aims at
+#define DURATION 10                     // Default sampling time(s)
+#define MAX_ALPHAS 8
+#define STAT_BUFFER_SIZE 1024           // stat is one line of ~300 bytes
+
+#define DEMO_THREADS 4
+#define DEMO_SLEEP 20000                // Mean time a demo thread sleeps between two bursts(us)
+#define PHASE_CHANGE_ONE_IN 16          // A demo thread moves to a new phase once every this many bursts on average
+
+// A thread of the sampled process
+typedef struct {
+    pid_t tid;
+    int schedstatFd;
+    int statFd;
+    unsigned long long runTime;         // CPU time at the last sample(ns)
+    unsigned long long burstTime;       // CPU time of the burst in progress(ns)
+    bool partialBurst;                  // Whether the burst in progress started before the thread was found
+    unsigned long long numberOfBursts;  // Complete bursts seen
+    double predictions[MAX_ALPHAS];     // Prediction of the next burst at every alpha(us), once a burst was seen
+} sampledThread;
+
+// How well one alpha predicted the bursts
+typedef struct {
+    double alpha;
+    unsigned long long numberOfPredictions;
+    double totalError;                  // Sum of |prediction - burst|(us)
+    double totalSquaredError;
+    double totalRelativeError;          // Sum of |prediction - burst| / burst
+    latencyHistogram errors;            // |prediction - burst|(us)
+} alphaScore;
+
+typedef struct {
+    pid_t pid;
+    sampledThread* threads;             // Sorted by tid
+    unsigned int numberOfThreads;
+    unsigned int capacity;
+    pid_t* listedTids;                  // Scratch space of rescanThreads()
+    unsigned int listedCapacity;
+    alphaScore scores[MAX_ALPHAS];
+    unsigned int numberOfAlphas;
+    unsigned long long numberOfBursts;
+    unsigned long long totalBurstTime;  // us
+    latencyHistogram bursts;            // us
+    unsigned long long numberOfSamples;
+    unsigned long long numberOfReads;
+    unsigned long long numberOfThreadsSeen;
+} burstSampler;
+
+static inline unsigned long long now(clockid_t clock) {
+    struct timespec time;
+    clock_gettime(clock, &time);
+    return (unsigned long long)time.tv_sec * NANOSECONDS_PER_SECOND + time.tv_nsec;
+}
+
+static inline void sleepUntil(unsigned long long time) {
+    struct timespec wakeUp = {time / NANOSECONDS_PER_SECOND, time % NANOSECONDS_PER_SECOND};
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeUp, NULL) == EINTR)
+        ;
+}
+
+// Function to read the CPU time of a thread from its schedstat("runTime waitTime timeslices").
+// Returns 0 on success, -1 if the thread is gone.
+int readRunTime(burstSampler* sampler, const sampledThread* thread, unsigned long long* runTime) {
+    char buffer[128];
+    ssize_t length = pread(thread->schedstatFd, buffer, sizeof(buffer) - 1, 0);
+    sampler->numberOfReads++;
+    if (length <= 0)
+        return -1;
+    buffer[length] = '\0';
+    *runTime = strtoull(buffer, NULL, 10);
+    return 0;
+}
+
+// Function to read the state of a thread from its stat(R running, S sleeping, D disk sleep...).
+// The name of the thread is in parentheses and may hold anything, so the state is found after the last ')'.
+// Returns the state, or '\0' if the thread is gone.
+char readState(burstSampler* sampler, const sampledThread* thread) {
+    char buffer[STAT_BUFFER_SIZE];
+    ssize_t length = pread(thread->statFd, buffer, sizeof(buffer) - 1, 0);
+    sampler->numberOfReads++;
+    if (length <= 0)
+        return '\0';
+    buffer[length] = '\0';
+
+    char* end = strrchr(buffer, ')');
+    return (end != NULL && end[1] == ' ') ? end[2] : '\0';
+}
+
+// Function to open the files of a new thread. Returns 0 on success, -1 if the thread is gone.
+int openThread(burstSampler* sampler, sampledThread* thread, pid_t tid) {
+    char path[64];
+
+    thread->tid = tid;
+    snprintf(path, sizeof(path), "/proc/%d/task/%d/schedstat", sampler->pid, tid);
+    thread->schedstatFd = open(path, O_RDONLY | O_CLOEXEC);
+    snprintf(path, sizeof(path), "/proc/%d/task/%d/stat", sampler->pid, tid);
+    thread->statFd = open(path, O_RDONLY | O_CLOEXEC);
+
+    char state = '\0';
+    if (thread->schedstatFd == -1 || thread->statFd == -1 || readRunTime(sampler, thread, &thread->runTime) == -1 ||
+            (state = readState(sampler, thread)) == '\0') {
+        if (thread->schedstatFd != -1)
+            close(thread->schedstatFd);
+        if (thread->statFd != -1)
+            close(thread->statFd);
+        return -1;
+    }
+    thread->burstTime = 0;
+    thread->partialBurst = (state == 'R');
+    thread->numberOfBursts = 0;
+    return 0;
+}
+
+// Function to account for the end of the burst in progress of a thread: score the predictions made
+// for it, then fold it into the predictions of the next one
+void endBurst(burstSampler* sampler, sampledThread* thread) {
+    double burst = (double)thread->burstTime / NANOSECONDS_PER_MICROSECOND;
+    bool partialBurst = thread->partialBurst;
+
+    thread->burstTime = 0;
+    thread->partialBurst = false;
+    if (partialBurst || burst <= 0)
+        return;
+
+    sampler->numberOfBursts++;
+    sampler->totalBurstTime += (unsigned long long)burst;
+    recordLatency(&sampler->bursts, (unsigned long long)burst);
+    for (unsigned int index = 0; index < sampler->numberOfAlphas; index++) {
+        alphaScore* score = &sampler->scores[index];
+        if (thread->numberOfBursts == 0) {
+            thread->predictions[index] = burst;     // Nothing to predict the first burst from
+            continue;
+        }
+
+        double error = thread->predictions[index] - burst;
+        if (error < 0)
+            error = -error;
+        score->numberOfPredictions++;
+        score->totalError += error;
+        score->totalSquaredError += error * error;
+        score->totalRelativeError += error / burst;
+        recordLatency(&score->errors, (unsigned long long)error);
+        thread->predictions[index] = calculatePrediction(score->alpha, thread->predictions[index], burst);
+    }
+    thread->numberOfBursts++;
+}
+
+// Function to release a thread that is gone. A burst in progress ends with it.
+void closeThread(burstSampler* sampler, sampledThread* thread) {
+    if (thread->burstTime > 0)
+        endBurst(sampler, thread);
+    close(thread->schedstatFd);
+    close(thread->statFd);
+}
+
+int compareTid(const void* a, const void* b) {
+    pid_t tidA = *(const pid_t*)a;
+    pid_t tidB = *(const pid_t*)b;
+    return (tidA > tidB) - (tidA < tidB);
+}
+
+// Function to list the threads of the process and open the new ones. The threads already open are
+// left alone, gone ones are noticed by sampleThreads() when their files stop reading.
+// Returns the number of threads listed, or -1 if the process is gone.
+int rescanThreads(burstSampler* sampler) {
+    char path[64];
+    unsigned int numberOfListedTids = 0;
+
+    snprintf(path, sizeof(path), "/proc/%d/task", sampler->pid);
+    DIR* directory = opendir(path);
+    if (directory == NULL)
+        return -1;
+    for (struct dirent* entry = readdir(directory); entry != NULL; entry = readdir(directory)) {
+        pid_t tid = (pid_t)strtol(entry->d_name, NULL, 10);
+        if (tid <= 0)
+            continue;   // "." and ".."
+        if (numberOfListedTids == sampler->listedCapacity) {
+            unsigned int newCapacity = (sampler->listedCapacity == 0) ? 64 : sampler->listedCapacity * 2;
+            pid_t* newTids = realloc(sampler->listedTids, newCapacity * sizeof(pid_t));
+            if (newTids == NULL) {
+                perror("realloc");
+                break;  // The threads listed so far are still taken
+            }
+            sampler->listedTids = newTids;
+            sampler->listedCapacity = newCapacity;
+        }
+        sampler->listedTids[numberOfListedTids++] = tid;
+    }
+    closedir(directory);
+    qsort(sampler->listedTids, numberOfListedTids, sizeof(pid_t), compareTid);
+
+    // Both lists are sorted, so the new threads are found in one merge pass
+    unsigned int numberOfKnownThreads = sampler->numberOfThreads;
+    unsigned int known = 0;
+    for (unsigned int index = 0; index < numberOfListedTids; index++) {
+        pid_t tid = sampler->listedTids[index];
+        while (known < numberOfKnownThreads && sampler->threads[known].tid < tid)
+            known++;
+        if (known < numberOfKnownThreads && sampler->threads[known].tid == tid)
+            continue;
+
+        if (sampler->numberOfThreads == sampler->capacity) {
+            unsigned int newCapacity = (sampler->capacity == 0) ? 64 : sampler->capacity * 2;
+            sampledThread* newThreads = realloc(sampler->threads, newCapacity * sizeof(sampledThread));
+            if (newThreads == NULL) {
+                perror("realloc");
+                break;
+            }
+            sampler->threads = newThreads;
+            sampler->capacity = newCapacity;
+        }
+        if (openThread(sampler, &sampler->threads[sampler->numberOfThreads], tid) == 0) {
+            sampler->numberOfThreads++;
+            sampler->numberOfThreadsSeen++;
+        }
+    }
+    if (sampler->numberOfThreads > numberOfKnownThreads)
+        qsort(sampler->threads, sampler->numberOfThreads, sizeof(sampledThread), compareTid);
+    return (int)numberOfListedTids;
+}
+
+// Function to take one sample of every thread. Gone threads are closed and dropped, keeping the order.
+void sampleThreads(burstSampler* sampler) {
+    unsigned int numberOfLiveThreads = 0;
+
+    for (unsigned int index = 0; index < sampler->numberOfThreads; index++) {
+        sampledThread* thread = &sampler->threads[index];
+        unsigned long long runTime;
+        bool alive = (readRunTime(sampler, thread, &runTime) == 0);
+
+        if (alive && runTime > thread->runTime) {
+            // It ran since the last sample, so it is in a burst
+            thread->burstTime += runTime - thread->runTime;
+            thread->runTime = runTime;
+        } else if (alive && thread->burstTime > 0) {
+            // No progress: the burst is over unless the thread is only waiting for a CPU
+            char state = readState(sampler, thread);
+            alive = (state != '\0');
+            if (alive && state != 'R')
+                endBurst(sampler, thread);
+        }
+
+        if (!alive) {
+            closeThread(sampler, thread);
+            continue;
+        }
+        if (numberOfLiveThreads != index)
+            sampler->threads[numberOfLiveThreads] = *thread;
+        numberOfLiveThreads++;
+    }
+    sampler->numberOfThreads = numberOfLiveThreads;
+    sampler->numberOfSamples++;
+}
+
+// Function to sample a process until it exits or the duration is over
+// Returns the CPU time of the sampler in percent of the wall time, or -1 if the process could not be sampled.
+double runSampler(burstSampler* sampler, unsigned long long interval, unsigned long long duration,
+        double budget, unsigned long long rescanInterval, unsigned long long* finalInterval) {
+    unsigned long long requestedInterval = interval;
+    unsigned long long startTime = now(CLOCK_MONOTONIC);
+    unsigned long long startCpuTime = now(CLOCK_PROCESS_CPUTIME_ID);
+    unsigned long long endTime = startTime + duration;
+    unsigned long long nextSample = startTime;
+    unsigned long long nextRescan = startTime;
+    unsigned long long windowStart = startTime;
+    unsigned long long windowCpuStart = startCpuTime;
+    unsigned long long windowSamples = 0;
+
+    if (rescanThreads(sampler) == -1) {
+        fprintf(stderr, "Process %d not found\n", sampler->pid);
+        return -1;
+    }
+
+    unsigned long long currentTime = startTime;
+    while (currentTime < endTime) {
+        if (currentTime >= nextRescan) {
+            if (rescanThreads(sampler) <= 0)
+                break;  // The process is gone
+            nextRescan = currentTime + rescanInterval;
+        }
+        sampleThreads(sampler);
+
+        // Keep the CPU time of the sampler under the budget
+        if (currentTime - windowStart >= BUDGET_WINDOW) {
+            unsigned long long cpuTime = now(CLOCK_PROCESS_CPUTIME_ID);
+            double sampleCost = (double)(cpuTime - windowCpuStart) / (sampler->numberOfSamples - windowSamples);
+            unsigned long long budgetInterval = (unsigned long long)(sampleCost * 100 / (budget * BUDGET_TARGET));
+            interval = (budgetInterval > requestedInterval) ? budgetInterval : requestedInterval;
+            if (interval > MAX_SAMPLING_INTERVAL * NANOSECONDS_PER_MICROSECOND)
+                interval = MAX_SAMPLING_INTERVAL * NANOSECONDS_PER_MICROSECOND;
+            windowStart = currentTime;
+            windowCpuStart = cpuTime;
+            windowSamples = sampler->numberOfSamples;
+        }
+
+        // A sample that came late is not made up for: the next one is an interval after it
+        nextSample += interval;
+        currentTime = now(CLOCK_MONOTONIC);
+        if (nextSample < currentTime)
+            nextSample = currentTime + interval;
+        sleepUntil(nextSample);
+        currentTime = now(CLOCK_MONOTONIC);
+    }
+
+    // The bursts still in progress are not over, so they are not scored
+    for (unsigned int index = 0; index < sampler->numberOfThreads; index++) {
+        close(sampler->threads[index].schedstatFd);
+        close(sampler->threads[index].statFd);
+    }
+    sampler->numberOfThreads = 0;
+    *finalInterval = interval;
+    return 100.0 * (now(CLOCK_PROCESS_CPUTIME_ID) - startCpuTime) / (currentTime - startTime);
+}
+
+// Function to parse a list of alpha values separated by commas. Returns 0 on success, -1 on failure.
+int parseAlphas(burstSampler* sampler, const char* text) {
+    sampler->numberOfAlphas = 0;
+    while (true) {
+        char* end;
+        double alpha = strtod(text, &end);
+        if (end == text || alpha <= 0 || alpha > 1 || sampler->numberOfAlphas == MAX_ALPHAS)
+            return -1;
+        sampler->scores[sampler->numberOfAlphas++].alpha = alpha;
+        if (*end != ',')
+            return (*end == '\0') ? 0 : -1;
+        text = end + 1;
+    }
+}
+
+// Function to display the bursts that were captured and how well every alpha predicted them
+void displayReport(const burstSampler* sampler, double cpuUsage, double budget, unsigned long long interval) {
+    printf("Process %d: %llu threads, %llu samples, %llu reads, sampling interval %llu us at the end\n",
+            sampler->pid, sampler->numberOfThreadsSeen, sampler->numberOfSamples, sampler->numberOfReads,
+            interval / NANOSECONDS_PER_MICROSECOND);
+    printf("Sampler CPU time: %.3f%% of one CPU(budget %.2f%%)\n", cpuUsage, budget);
+    if (sampler->numberOfBursts == 0) {
+        printf("No complete CPU burst was seen\n");
+        return;
+    }
+    printf("CPU bursts: %llu, mean %.1f us, p50/p90/p99/max %llu / %llu / %llu / %llu us\n",
+            sampler->numberOfBursts, (double)sampler->totalBurstTime / sampler->numberOfBursts,
+            latencyPercentile(&sampler->bursts, 50), latencyPercentile(&sampler->bursts, 90),
+            latencyPercentile(&sampler->bursts, 99), sampler->bursts.maxValue);
+
+    int best = -1;
+    printf("\n%-8s%14s%18s%16s%16s%12s%12s\n", "Alpha", "Predictions", "Mean abs error", "RMS error", "Mean rel error", "p50 error", "p99 error");
+    for (unsigned int index = 0; index < sampler->numberOfAlphas; index++) {
+        const alphaScore* score = &sampler->scores[index];
+        if (score->numberOfPredictions == 0) {
+            printf("%-8.3f%14d\n", score->alpha, 0);
+            continue;
+        }
+        double predictions = (double)score->numberOfPredictions;
+        printf("%-8.3f%14llu%15.1f us%13.1f us%15.1f%%%9llu us%9llu us\n", score->alpha, score->numberOfPredictions,
+                score->totalError / predictions, sqrt(score->totalSquaredError / predictions),
+                100.0 * score->totalRelativeError / predictions,
+                latencyPercentile(&score->errors, 50), latencyPercentile(&score->errors, 99));
+        if (best == -1 || score->totalError < sampler->scores[best].totalError)
+            best = (int)index;
+    }
+    if (best != -1)
+        printf("\nBest alpha: %.3f(smallest mean absolute error)\n", sampler->scores[best].alpha);
+}
+
+// A thread of the demo process: CPU bursts drawn around a typical burst that changes now and then,
+// separated by sleeps, like approximated_SJF.c draws the bursts of its tasks
+void* demoThread(void* param) {
+    unsigned long long randomState = (unsigned long long)(uintptr_t)param * 0x9E3779B97F4A7C15ull + 1;
+    unsigned long long typicalBurst = 1000 + (randomState >> 33) % 6000;   // us
+
+    while (true) {
+        randomState ^= randomState << 13;
+        randomState ^= randomState >> 7;
+        randomState ^= randomState << 17;
+        if (randomState % PHASE_CHANGE_ONE_IN == 0)
+            typicalBurst = 1000 + (randomState >> 20) % 6000;
+
+        // The typical burst give or take half of it, burnt on the CPU
+        unsigned long long burst = typicalBurst / 2 + (randomState >> 8) % (typicalBurst + 1);
+        unsigned long long burstEnd = now(CLOCK_THREAD_CPUTIME_ID) + burst * NANOSECONDS_PER_MICROSECOND;
+        while (now(CLOCK_THREAD_CPUTIME_ID) < burstEnd)
+            ;
+
+        unsigned long long sleepTime = DEMO_SLEEP / 2 + (randomState >> 40) % DEMO_SLEEP;
+        struct timespec pause = {0, (long)(sleepTime * NANOSECONDS_PER_MICROSECOND)};
+        nanosleep(&pause, NULL);
+    }
+    return NULL;
+}
+
+// Function to start the demo process. Returns its pid, or -1 on failure.
+pid_t startDemoProcess(void) {
+    pid_t pid = fork();
+    if (pid == -1) {
+        perror("fork");
+        return -1;
+    }
+    if (pid > 0)
+        return pid;
+
+    pthread_t threads[DEMO_THREADS];
+    for (uintptr_t index = 0; index < DEMO_THREADS; index++)
+        pthread_create(&threads[index], NULL, demoThread, (void*)(index + 1));
+    pause();    // Until the sampler kills it
+    _exit(0);
+}
+
+int main(int argc, char* argv[]) {
+    burstSampler sampler;
+    unsigned long long interval = SAMPLING_INTERVAL;
+    unsigned long long duration = DURATION;
+    unsigned long long rescanInterval = RESCAN_INTERVAL;
+    double budget = CPU_BUDGET;
+    const double defaultAlphas[] = {0.125, 0.25, 0.5, 0.75, 1.0};
+    bool validArguments = true;
+
+    memset(&sampler, 0, sizeof(sampler));
+    for (unsigned int index = 0; index < sizeof(defaultAlphas) / sizeof(defaultAlphas[0]); index++)
+        sampler.scores[sampler.numberOfAlphas++].alpha = defaultAlphas[index];
+
+    for (int index = 2; index < argc && validArguments; index++) {
+        if (strcmp(argv[index], "--interval") == 0 && index + 1 < argc)
+            interval = strtoull(argv[++index], NULL, 10);
+        else if (strcmp(argv[index], "--duration") == 0 && index + 1 < argc)
+            duration = strtoull(argv[++index], NULL, 10);
+        else if (strcmp(argv[index], "--alpha") == 0 && index + 1 < argc)
+            validArguments = (parseAlphas(&sampler, argv[++index]) == 0);
+        else if (strcmp(argv[index], "--budget") == 0 && index + 1 < argc)
+            budget = strtod(argv[++index], NULL);
+        else if (strcmp(argv[index], "--rescan") == 0 && index + 1 < argc)
+            rescanInterval = strtoull(argv[++index], NULL, 10);
+        else
+            validArguments = false;
+    }
+    if (argc > 1)
+        sampler.pid = (pid_t)strtol(argv[1], NULL, 10);
+    if (!validArguments || (argc > 1 && sampler.pid <= 0) || interval == 0 || interval > MAX_SAMPLING_INTERVAL ||
+            duration == 0 || rescanInterval == 0 || budget <= 0) {
+        fprintf(stderr, "Usage: %s <pid> [--interval microseconds] [--duration seconds] [--alpha alpha[,alpha...]]\n"
+                "           [--budget percent] [--rescan milliseconds]\n", argv[0]);
+        return 1;
+    }
+
+    // Without a pid, sample a demo process for a few seconds
+    pid_t demoPid = -1;
+    if (argc == 1) {
+        demoPid = startDemoProcess();
+        if (demoPid == -1)
+            return 1;
+        sampler.pid = demoPid;
+        duration = 5;
+        usleep(100000);     // Let the demo start its threads
+        printf("Sampling demo process %d(%d threads alternating CPU bursts and sleeps) for %llu seconds...\n\n",
+                demoPid, DEMO_THREADS, duration);
+    }
+
+    for (unsigned int index = 0; index < sampler.numberOfAlphas; index++)
+        initLatencyHistogram(&sampler.scores[index].errors);
+    initLatencyHistogram(&sampler.bursts);
+
+    unsigned long long finalInterval = 0;
+    double cpuUsage = runSampler(&sampler, interval * NANOSECONDS_PER_MICROSECOND, duration * NANOSECONDS_PER_SECOND,
+                                 budget, rescanInterval * NANOSECONDS_PER_MILLISECOND, &finalInterval);
+    if (demoPid != -1) {
+        kill(demoPid, SIGKILL);
+        waitpid(demoPid, NULL, 0);
+    }
+    free(sampler.threads);
+    free(sampler.listedTids);
+    if (cpuUsage < 0)
+        return 1;
+
+    displayReport(&sampler, cpuUsage, budget, finalInterval);
+    return 0;
+}
@@ -1,128 +1,1815 @@
 // scheduling/completely_fair_scheduling.c
 // A brief implementation of CFS(Completely Fair Scheduling).
+// Like the kernel, runnable tasks are kept in a red-black tree ordered by vruntime,
+// and the leftmost(smallest vruntime) node is cached so that picking the next task is O(1).
+// Like the kernel, vruntime advances by the run time scaled by NICE_0_LOAD / weight, where the weight
+// comes from the nice level(nice_weights.h). Like the kernel, vruntime is a 64-bit integer count of
+// nanoseconds, and the division by the weight is a multiplication by its precomputed inverse, so that
+// the schedule is the same whatever the compiler and the FPU. A newly arrived task is placed just after min_vruntime,
+// and every task gets a share of the targeted latency(sched_latency) proportional to its weight,
+// but never less than min_granularity.
+// The simulation is event-driven: the clock jumps straight to the end of each time slice
+// (or to the next arrival when the CPU is idle) instead of moving one tick at a time.
+// Tasks are streamed from a workload trace, and only the tasks that have arrived but not
+// completed are kept in memory.
+// With more than one CPU, every CPU has its own runqueue and runs on its own host thread, and the
+// runqueues are balanced every --balance-interval units(see load_balance.h).
+//
+// With --eevdf, the runqueue follows EEVDF(Earliest Eligible Virtual Deadline First), which replaced
+// CFS in Linux 6.6. Every task has a virtual deadline: its vruntime plus the virtual length of its
+// next request(the base slice). A task is eligible when its lag is not negative, i.e. when its
+// vruntime is not past the load-weighted average vruntime of the runqueue, and the eligible task
+// with the earliest virtual deadline runs next. Like the kernel, every node of the tree also keeps
+// the earliest deadline of its subtree, so the pick is a single O(log n) walk down the tree.
+// A new task is placed at the average vruntime(lag 0) with half a request as its first deadline,
+// and a task runs until its request is used up(RUN_TO_PARITY).
+// --compare runs CFS and then EEVDF on the same trace and reports the latency of the short
+// (latency-sensitive) tasks under both.
+//
+// With --groups, tasks belong to a hierarchy of task groups(like cgroups with cpu.shares, the
+// kernel's CONFIG_FAIR_GROUP_SCHED). Like the kernel, a group is scheduled as one entity in the
+// runqueue of its parent, with its shares as weight, and has its own runqueue of tasks or child
+// groups. The CPU is divided among the groups of each level by their weight before it is divided
+// among the tasks by theirs: picking the next task walks down from the root, taking the leftmost
+// entity of every level(O(log n) per level), and every entity on the path is charged for the run.
+// --groups 10x100 makes 10 groups with 100 subgroups each, and tasks go to the 1000 leaf groups
+// by ID. --shares gives the shares of the groups, cycling over the siblings of every level.
+//
+// Usage: ./completely_fair_scheduling.out                         (small demo with a full timeline)
+//        ./completely_fair_scheduling.out <trace> [numberOfCpus] [--latency schedLatency] [--granularity minGranularity]
+//               [--eevdf] [--slice baseSlice] [--balance-interval interval] [--metrics]
+//               [--timeline gantt|csv|json] [--timeline-output path]
+//               (replay a workload trace, summary only. --metrics prints one line of key=value pairs
+//                instead, over every CPU. --timeline records the runs and renders them once the
+//                simulation is over(see timeline.h), on one CPU.)
+//        ./completely_fair_scheduling.out <trace> --compare [--short-burst shortTaskBurst] [--slice baseSlice]
+//               (CFS against EEVDF on one CPU, for all tasks and for the tasks with a burst of at most
+//                shortTaskBurst)
+//        ./completely_fair_scheduling.out <trace> --groups fanout[xfanout...] [--shares shares[,shares...]] [--eevdf]
+//               [--metrics] [--timeline gantt|csv|json] [--timeline-output path]
+//               (group scheduling on one CPU, with the CPU time of the top-level groups against their shares)
+//        ./completely_fair_scheduling.out <trace> [--eevdf] [--checkpoint path] [--checkpoint-every events] [--until timestamp]
+//               [--resume path] [--metrics]
+//               (on one CPU, write a snapshot of the simulation every so many events(10^7 by default), and stop
+//                after a last one once the clock reaches timestamp. --resume picks a run up from its snapshot,
+//                on the same trace and with the settings it was started with. See simulation_checkpoint.h.)
+// gcc -o completely_fair_scheduling.out completely_fair_scheduling.c -lpthread -lm
 #include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "workload_trace.h"
+#include "latency_histogram.h"
+#include "scheduling_metrics.h"
+#include "nice_weights.h"
+#include "timeline.h"
+#include "simulation_checkpoint.h"
+#include "load_balance.h"
 
+// A time unit stands for 0.75ms, so the defaults keep the kernel's ratio of 6ms to 0.75ms:
+// up to 8 runnable tasks share one targeted latency.
+#define SCHED_LATENCY 8             // Period in which every runnable task should run once
+#define MIN_GRANULARITY 1           // Shortest time slice
+#define BASE_SLICE 4                // Length of an EEVDF request(3ms, the kernel's base slice on 8 CPUs)
+#define NSEC_PER_UNIT 750000ull     // vruntime is kept in nanoseconds
+#define SHORT_TASK_BURST 2          // Tasks with a burst of at most this many units count as latency-sensitive
+#define MAX_GROUP_LEVELS 4          // Levels of task groups below the root
+#define MAX_GROUPS 10000000         // Task groups at most, over every level
+#define MAX_SHARES 16               // Shares values that --shares accepts
+#define DISPLAYED_GROUPS 16         // Top-level groups shown in the group report
+
+// Tunables, like the kernel's sysctl_sched_latency, sysctl_sched_min_granularity and sysctl_sched_base_slice
+unsigned long long schedLatency = SCHED_LATENCY;
+unsigned long long minGranularity = MIN_GRANULARITY;
+unsigned long long baseSlice = BASE_SLICE;
+bool useEevdf = false;              // Pick by earliest eligible virtual deadline instead of smallest vruntime
+unsigned long long shortTaskBurst = SHORT_TASK_BURST;
+
+// A node of the red-black tree. It is embedded in the task itself(like the kernel's struct rb_node),
+// so enqueueing and dequeueing never allocates.
+typedef struct rbNode {
+    struct rbNode* parent;
+    struct rbNode* left;
+    struct rbNode* right;
+    bool isRed;
+} rbNode;
+
+// The root of the tree with the leftmost node cached(like the kernel's struct rb_root_cached)
 typedef struct {
-    unsigned int id;            // Task ID
-    double vruntime;            // Virtual runtime, representing CPU time consumed by the task
-    unsigned int cpuBurstTime;  // Time the task needs on the CPU
-    unsigned int remainingTime; // Time left for the task to finish
-    unsigned int arrivalTime;   // Time when the task arrives in the system
-    unsigned int startTime;     // Time when the task starts execution
-    unsigned int endTime;       // Time when the task finishes execution
-    unsigned int waitingTime;   // Time the task waited before execution
-    bool started;               // Whether the task has started running
+    rbNode* root;
+    rbNode* leftmost;
+} rbRootCached;
+
+// The fields read while walking the runqueue come first, so that they share one cache line with the tree node
+typedef struct task {
+    rbNode runqueueNode;                // Position of the task in the runqueue(valid while it is runnable)
+    unsigned long long vruntime;        // Virtual runtime: CPU time consumed by the task in ns, scaled by its weight
+    unsigned long long minDeadline;     // Earliest deadline in the subtree of the task's node(EEVDF)
+    unsigned int id;                    // Task ID
+    uint32_t inverseWeight;             // 2^32 / weight
+    unsigned long long deadline;        // Virtual deadline of the current request(EEVDF)
+    int nice;                           // Nice level, from -20(highest priority) to 19
+    unsigned long long weight;          // Load weight of the nice level
+    unsigned long long cpuBurstTime;    // Time the task needs on the CPU
+    unsigned long long remainingTime;   // Time left for the task to finish
+    unsigned long long arrivalTime;     // Time when the task arrives in the system
+    unsigned long long startTime;       // Time when the task starts execution
+    unsigned long long endTime;         // Time when the task finishes execution
+    unsigned long long waitingTime;     // Time the task waited before execution
+    bool started;                       // Whether the task has started running
+    unsigned long long readyTime;       // When the task became runnable on its current CPU
+    struct task* nextArrival;           // Next task in the arrival list of a CPU(multi-CPU simulation only)
+    struct task* parent;                // Entity of the group the task is in, NULL in the root group(like the kernel's se->parent)
+    struct cfsRunqueue* queuedRunqueue; // Runqueue the entity is queued in(group scheduling only, like se->cfs_rq)
+    struct cfsRunqueue* myRunqueue;     // Runqueue of the group, if the entity is a group(like se->my_q)
 } task;
 
-int getNextTask(task tasks[], unsigned int numberOfTasks, unsigned int currentTimestamp) {
-    int minTaskIndex = -1;
+typedef struct {
+    unsigned long long numberOfTasks;       // Number of completed tasks
+    unsigned long long totalWaitingTime;    // Sum of the waiting time of every task
+    unsigned long long totalTime;           // Time when the last task finished
+    schedulingMetrics metrics;
+    unsigned long long numberOfShortTasks;  // Completed tasks with a burst of at most shortTaskBurst
+    unsigned long long totalShortTaskResponseTime;
+    unsigned long long totalShortTaskWaitingTime;
+    latencyHistogram shortTaskResponseTimes;    // From the arrival to the first run of each short task
+    latencyHistogram shortTaskWaitingTimes;
+} schedulingSummary;
 
-    for (unsigned int index = 0; index < numberOfTasks; index++) {
-        if (tasks[index].arrivalTime <= currentTimestamp && tasks[index].remainingTime > 0) {
-            if (minTaskIndex == -1 || tasks[index].vruntime < tasks[minTaskIndex].vruntime) {
-                minTaskIndex = index;
+// A CFS runqueue(like the kernel's struct cfs_rq). The running task is out of the tree,
+// but it still counts towards the load.
+// Like the kernel's avg_vruntime, the average vruntime is kept as a weighted sum of the vruntimes
+// relative to min_vruntime, so that the sum stays small however long the simulation runs.
+typedef struct cfsRunqueue {
+    rbRootCached tasksTimeline;         // Runnable tasks waiting for the CPU, ordered by vruntime
+    struct task* currentTask;           // Task on the CPU(NULL when idle)
+    unsigned long long loadWeight;      // Sum of the weights of the queued tasks and the current task
+    unsigned int numberOfRunningTasks;  // Number of queued tasks and the current task
+    unsigned long long minVruntime;     // Never decreases, even as tasks come and go
+    long long avgVruntimeSum;           // Sum of weight * (vruntime - minVruntime) over the queued tasks
+    unsigned long long avgLoad;         // Sum of the weights of the queued tasks
+} cfsRunqueue;
+
+#define taskOfNode(node) ((task*)((char*)(node) - offsetof(task, runqueueNode)))
+
+// The scalars of a run of runCFS(), the first section of its checkpoints. The second section holds the
+// runnable tasks in the order of the tree, linked together as they will be once the snapshot is mapped.
+typedef struct {
+    unsigned long long currentTimestamp;
+    rbNode* root;                       // Pointers into the snapshot(see simulation_checkpoint.h)
+    rbNode* leftmost;
+    unsigned long long loadWeight;
+    unsigned int numberOfRunningTasks;
+    unsigned long long minVruntime;
+    long long avgVruntimeSum;
+    unsigned long long avgLoad;
+    unsigned long long schedLatency;    // The tunables of the run, which a resumed run keeps
+    unsigned long long minGranularity;
+    unsigned long long baseSlice;
+    unsigned long long shortTaskBurst;
+    bool useEevdf;
+    schedulingSummary summary;
+} cfsCheckpointState;
+
+// Tasks are ordered by vruntime. Ties are broken by the task ID so that the order is deterministic.
+// Both comparisons are evaluated, so that the compiler can combine them without a branch.
+bool isTaskBefore(const task* a, const task* b) {
+    return (a->vruntime < b->vruntime) | ((a->vruntime == b->vruntime) & (a->id < b->id));
+}
+
+// Function to recompute the earliest deadline in the subtree of a node from its own deadline and its children
+void rbAugmentCompute(rbNode* node) {
+    task* nodeTask = taskOfNode(node);
+    unsigned long long minDeadline = nodeTask->deadline;
+
+    if (node->left != NULL && taskOfNode(node->left)->minDeadline < minDeadline)
+        minDeadline = taskOfNode(node->left)->minDeadline;
+    if (node->right != NULL && taskOfNode(node->right)->minDeadline < minDeadline)
+        minDeadline = taskOfNode(node->right)->minDeadline;
+    nodeTask->minDeadline = minDeadline;
+}
+
+// Function to recompute the earliest deadlines on the path from a node up to the root
+void rbAugmentPropagate(rbNode* node) {
+    for (; node != NULL; node = node->parent)
+        rbAugmentCompute(node);
+}
+
+// Function to rotate the subtree rooted at node to the left
+void rbRotateLeft(rbRootCached* tree, rbNode* node) {
+    rbNode* pivot = node->right;
+
+    node->right = pivot->left;
+    if (pivot->left != NULL)
+        pivot->left->parent = node;
+
+    pivot->parent = node->parent;
+    if (node->parent == NULL)
+        tree->root = pivot;
+    else if (node == node->parent->left)
+        node->parent->left = pivot;
+    else
+        node->parent->right = pivot;
+
+    pivot->left = node;
+    node->parent = pivot;
+
+    // node is now the child of pivot, so it is recomputed first
+    rbAugmentCompute(node);
+    rbAugmentCompute(pivot);
+}
+
+// Function to rotate the subtree rooted at node to the right
+void rbRotateRight(rbRootCached* tree, rbNode* node) {
+    rbNode* pivot = node->left;
+
+    node->left = pivot->right;
+    if (pivot->right != NULL)
+        pivot->right->parent = node;
+
+    pivot->parent = node->parent;
+    if (node->parent == NULL)
+        tree->root = pivot;
+    else if (node == node->parent->right)
+        node->parent->right = pivot;
+    else
+        node->parent->left = pivot;
+
+    pivot->right = node;
+    node->parent = pivot;
+
+    rbAugmentCompute(node);
+    rbAugmentCompute(pivot);
+}
+
+// Function to find the in-order successor of a node
+rbNode* rbNext(rbNode* node) {
+    if (node->right != NULL) {
+        node = node->right;
+        while (node->left != NULL)
+            node = node->left;
+        return node;
+    }
+
+    while (node->parent != NULL && node == node->parent->right)
+        node = node->parent;
+    return node->parent;
+}
+
+// Function to enqueue a runnable task into the runqueue, O(log n)
+void enqueueTask(rbRootCached* tree, task* newTask) {
+    rbNode* node = &newTask->runqueueNode;
+    rbNode* parent = NULL;
+    rbNode** link = &tree->root;
+    bool isLeftmost = true;
+
+    // Walk down the tree to find the place to insert the new node
+    while (*link != NULL) {
+        parent = *link;
+        if (isTaskBefore(newTask, taskOfNode(parent))) {
+            link = &parent->left;
+        } else {
+            link = &parent->right;
+            isLeftmost = false;
+        }
+    }
+
+    node->parent = parent;
+    node->left = NULL;
+    node->right = NULL;
+    node->isRed = true;
+    *link = node;
+
+    if (isLeftmost)
+        tree->leftmost = node;
+    rbAugmentPropagate(node);
+
+    // Restore the red-black properties(no red node has a red child)
+    while (node->parent != NULL && node->parent->isRed) {
+        rbNode* grandparent = node->parent->parent;
+
+        if (node->parent == grandparent->left) {
+            rbNode* uncle = grandparent->right;
+            if (uncle != NULL && uncle->isRed) {
+                node->parent->isRed = false;
+                uncle->isRed = false;
+                grandparent->isRed = true;
+                node = grandparent;
+            } else {
+                if (node == node->parent->right) {
+                    node = node->parent;
+                    rbRotateLeft(tree, node);
+                }
+                node->parent->isRed = false;
+                grandparent->isRed = true;
+                rbRotateRight(tree, grandparent);
+            }
+        } else {
+            rbNode* uncle = grandparent->left;
+            if (uncle != NULL && uncle->isRed) {
+                node->parent->isRed = false;
+                uncle->isRed = false;
+                grandparent->isRed = true;
+                node = grandparent;
+            } else {
+                if (node == node->parent->left) {
+                    node = node->parent;
+                    rbRotateRight(tree, node);
+                }
+                node->parent->isRed = false;
+                grandparent->isRed = true;
+                rbRotateLeft(tree, grandparent);
             }
         }
     }
-    return minTaskIndex;
+    tree->root->isRed = false;
 }
 
-void runCFS(task tasks[], unsigned int numberOfTasks, unsigned int timeQuantum) {
-    unsigned int currentTimestamp = 0;
-    unsigned int numberOfCompletedTasks = 0;
-    int currentTaskIndex = -1;
+// Function to replace the subtree rooted at oldNode with the subtree rooted at newNode
+void rbTransplant(rbRootCached* tree, rbNode* oldNode, rbNode* newNode) {
+    if (oldNode->parent == NULL)
+        tree->root = newNode;
+    else if (oldNode == oldNode->parent->left)
+        oldNode->parent->left = newNode;
+    else
+        oldNode->parent->right = newNode;
 
-    while (numberOfCompletedTasks < numberOfTasks) {
-        // Increment the waiting time for all tasks that have arrived but are not running
-        for (unsigned int index = 0; index < numberOfTasks; index++) {
-            if (tasks[index].arrivalTime <= currentTimestamp 
-                    && index != currentTaskIndex 
-                    && tasks[index].remainingTime > 0) {
-                tasks[index].waitingTime++;
+    if (newNode != NULL)
+        newNode->parent = oldNode->parent;
+}
+
+// Function to dequeue a task from the runqueue, O(log n)
+void dequeueTask(rbRootCached* tree, task* oldTask) {
+    rbNode* node = &oldTask->runqueueNode;
+    rbNode* child;          // The node that takes the place of the removed one(may be NULL)
+    rbNode* childParent;    // Parent of child, kept separately because child may be NULL
+    bool removedBlack;
+
+    if (tree->leftmost == node)
+        tree->leftmost = rbNext(node);
+
+    if (node->left == NULL) {
+        child = node->right;
+        childParent = node->parent;
+        removedBlack = !node->isRed;
+        rbTransplant(tree, node, child);
+    } else if (node->right == NULL) {
+        child = node->left;
+        childParent = node->parent;
+        removedBlack = !node->isRed;
+        rbTransplant(tree, node, child);
+    } else {
+        // Two children: the in-order successor takes the place of the removed node
+        rbNode* successor = node->right;
+        while (successor->left != NULL)
+            successor = successor->left;
+
+        removedBlack = !successor->isRed;
+        child = successor->right;
+        if (successor->parent == node) {
+            childParent = successor;
+        } else {
+            childParent = successor->parent;
+            rbTransplant(tree, successor, successor->right);
+            successor->right = node->right;
+            successor->right->parent = successor;
+        }
+        rbTransplant(tree, node, successor);
+        successor->left = node->left;
+        successor->left->parent = successor;
+        successor->isRed = node->isRed;
+    }
+
+    // Every subtree that lost the removed node hangs below childParent. The rotations of the fix-up
+    // below keep the earliest deadlines up to date by themselves.
+    rbAugmentPropagate(childParent);
+
+    if (!removedBlack)
+        return;
+
+    // A black node was removed, so one path is short of a black node. Fix it up.
+    while (child != tree->root && (child == NULL || !child->isRed)) {
+        if (child == childParent->left) {
+            rbNode* sibling = childParent->right;
+            if (sibling->isRed) {
+                sibling->isRed = false;
+                childParent->isRed = true;
+                rbRotateLeft(tree, childParent);
+                sibling = childParent->right;
+            }
+            if ((sibling->left == NULL || !sibling->left->isRed)
+                    && (sibling->right == NULL || !sibling->right->isRed)) {
+                sibling->isRed = true;
+                child = childParent;
+                childParent = child->parent;
+            } else {
+                if (sibling->right == NULL || !sibling->right->isRed) {
+                    sibling->left->isRed = false;
+                    sibling->isRed = true;
+                    rbRotateRight(tree, sibling);
+                    sibling = childParent->right;
+                }
+                sibling->isRed = childParent->isRed;
+                childParent->isRed = false;
+                sibling->right->isRed = false;
+                rbRotateLeft(tree, childParent);
+                child = tree->root;
+            }
+        } else {
+            rbNode* sibling = childParent->left;
+            if (sibling->isRed) {
+                sibling->isRed = false;
+                childParent->isRed = true;
+                rbRotateRight(tree, childParent);
+                sibling = childParent->left;
+            }
+            if ((sibling->left == NULL || !sibling->left->isRed)
+                    && (sibling->right == NULL || !sibling->right->isRed)) {
+                sibling->isRed = true;
+                child = childParent;
+                childParent = child->parent;
+            } else {
+                if (sibling->left == NULL || !sibling->left->isRed) {
+                    sibling->right->isRed = false;
+                    sibling->isRed = true;
+                    rbRotateLeft(tree, sibling);
+                    sibling = childParent->left;
+                }
+                sibling->isRed = childParent->isRed;
+                childParent->isRed = false;
+                sibling->left->isRed = false;
+                rbRotateRight(tree, childParent);
+                child = tree->root;
             }
         }
+    }
+    if (child != NULL)
+        child->isRed = false;
+}
 
-        // Find the next task to run
-        int nextTaskIndex = getNextTask(tasks, numberOfTasks, currentTimestamp);
-        if (nextTaskIndex == -1) {
-            currentTimestamp++;
+// Function to get the next task to run, the one with the lowest vruntime. O(1) thanks to the cached leftmost node.
+task* getNextTask(rbRootCached* tree) {
+    if (tree->leftmost == NULL)
+        return NULL;
+    return taskOfNode(tree->leftmost);
+}
+
+// Function to get the task with the highest vruntime, the one that would run last. O(log n).
+task* getLastTask(rbRootCached* tree) {
+    rbNode* node = tree->root;
+    if (node == NULL)
+        return NULL;
+    while (node->right != NULL)
+        node = node->right;
+    return taskOfNode(node);
+}
+
+// Function to scale the run time of a task into vruntime(like the kernel's calc_delta_fair)
+unsigned long long calcDeltaFair(unsigned long long delta, const task* currentTask) {
+    if (currentTask->weight == NICE_0_LOAD)
+        return delta * NSEC_PER_UNIT;
+    return calcDelta(delta * NSEC_PER_UNIT, NICE_0_LOAD, currentTask->inverseWeight);
+}
+
+// Function to get the period in which every runnable task should run once. Past the number of tasks
+// that fit into schedLatency, the period stretches so that no slice is shorter than minGranularity.
+unsigned long long schedPeriod(unsigned int numberOfRunningTasks) {
+    if (numberOfRunningTasks > schedLatency / minGranularity)
+        return numberOfRunningTasks * minGranularity;
+    return schedLatency;
+}
+
+// Function to get the time slice of a task: its share of the period, in proportion to its weight
+unsigned long long schedSlice(const cfsRunqueue* runqueue, const task* currentTask) {
+    unsigned long long slice = schedPeriod(runqueue->numberOfRunningTasks) * currentTask->weight / runqueue->loadWeight;
+    return (slice < minGranularity) ? minGranularity : slice;
+}
+
+// Function to move min_vruntime up to the smallest vruntime among the current task and the queued ones
+void updateMinVruntime(cfsRunqueue* runqueue) {
+    unsigned long long vruntime = runqueue->minVruntime;
+    task* leftmostTask = getNextTask(&runqueue->tasksTimeline);
+
+    if (runqueue->currentTask != NULL)
+        vruntime = runqueue->currentTask->vruntime;
+    if (leftmostTask != NULL) {
+        if (runqueue->currentTask == NULL || leftmostTask->vruntime < vruntime)
+            vruntime = leftmostTask->vruntime;
+    }
+
+    if (vruntime > runqueue->minVruntime) {
+        // The queued vruntimes are kept relative to min_vruntime, so their sum moves with it
+        runqueue->avgVruntimeSum -= (long long)(vruntime - runqueue->minVruntime) * (long long)runqueue->avgLoad;
+        runqueue->minVruntime = vruntime;
+    }
+}
+
+// Function to queue a task in the tree and add it to the average vruntime(like the kernel's __enqueue_entity)
+void enqueueEntity(cfsRunqueue* runqueue, task* newTask) {
+    runqueue->avgVruntimeSum += (long long)(newTask->vruntime - runqueue->minVruntime) * (long long)newTask->weight;
+    runqueue->avgLoad += newTask->weight;
+    enqueueTask(&runqueue->tasksTimeline, newTask);
+}
+
+// Function to take a task off the tree and out of the average vruntime(like the kernel's __dequeue_entity)
+void dequeueEntity(cfsRunqueue* runqueue, task* oldTask) {
+    runqueue->avgVruntimeSum -= (long long)(oldTask->vruntime - runqueue->minVruntime) * (long long)oldTask->weight;
+    runqueue->avgLoad -= oldTask->weight;
+    dequeueTask(&runqueue->tasksTimeline, oldTask);
+}
+
+// Function to get the load-weighted average vruntime of the queued tasks and the current task
+// (like the kernel's avg_vruntime). A task that has received exactly its share has this vruntime.
+unsigned long long avgVruntime(const cfsRunqueue* runqueue) {
+    long long sum = runqueue->avgVruntimeSum;
+    long long load = (long long)runqueue->avgLoad;
+
+    if (runqueue->currentTask != NULL) {
+        sum += (long long)(runqueue->currentTask->vruntime - runqueue->minVruntime) * (long long)runqueue->currentTask->weight;
+        load += (long long)runqueue->currentTask->weight;
+    }
+    if (load == 0)
+        return runqueue->minVruntime;
+
+    // Rounded down, also when the sum is negative
+    if (sum < 0)
+        sum -= load - 1;
+    return runqueue->minVruntime + (unsigned long long)(sum / load);
+}
+
+// Function to check if a task is eligible: its lag(what it was owed, weight * (average - vruntime))
+// is not negative. Like the kernel's entity_eligible, the check multiplies instead of dividing.
+bool isTaskEligible(const cfsRunqueue* runqueue, const task* checkedTask) {
+    long long sum = runqueue->avgVruntimeSum;
+    long long load = (long long)runqueue->avgLoad;
+
+    if (runqueue->currentTask != NULL) {
+        sum += (long long)(runqueue->currentTask->vruntime - runqueue->minVruntime) * (long long)runqueue->currentTask->weight;
+        load += (long long)runqueue->currentTask->weight;
+    }
+    return (long long)(checkedTask->vruntime - runqueue->minVruntime) * load <= sum;
+}
+
+// Function to find the eligible task with the earliest virtual deadline(like the kernel's pick_eevdf), O(log n).
+// The tree is ordered by vruntime, so when a node is eligible, its whole left subtree is eligible too,
+// and when it is not, neither is its right subtree. The walk goes down one path, remembering the best
+// eligible node seen and the left subtree with the earliest deadline, then descends into that subtree
+// by following the earliest deadlines if it holds a better task.
+task* pickEevdfTask(cfsRunqueue* runqueue) {
+    rbNode* node = runqueue->tasksTimeline.root;
+    task* bestTask = NULL;
+    task* bestLeft = NULL;
+
+    while (node != NULL) {
+        task* nodeTask = taskOfNode(node);
+        if (!isTaskEligible(runqueue, nodeTask)) {
+            node = node->left;
             continue;
         }
 
-        task* nextTask = &tasks[nextTaskIndex];
+        if (bestTask == NULL || nodeTask->deadline < bestTask->deadline)
+            bestTask = nodeTask;
+        if (node->left != NULL) {
+            task* leftTask = taskOfNode(node->left);
+            if (bestLeft == NULL || leftTask->minDeadline < bestLeft->minDeadline)
+                bestLeft = leftTask;
+        }
+
+        // The earliest deadline of this subtree is this node's own, nothing to the right can beat it
+        if (nodeTask->deadline == nodeTask->minDeadline)
+            break;
+        node = node->right;
+    }
+
+    // The leftmost task is always eligible, so there is an eligible task unless rounding hid it
+    if (bestTask == NULL)
+        return getNextTask(&runqueue->tasksTimeline);
+    if (bestLeft == NULL || bestLeft->minDeadline >= bestTask->deadline)
+        return bestTask;
+
+    // Heap search for the node that holds the earliest deadline of the best left subtree
+    node = &bestLeft->runqueueNode;
+    while (true) {
+        task* nodeTask = taskOfNode(node);
+        if (nodeTask->deadline == nodeTask->minDeadline)
+            return nodeTask;
+        if (node->left != NULL && taskOfNode(node->left)->minDeadline == nodeTask->minDeadline)
+            node = node->left;
+        else
+            node = node->right;
+    }
+}
+
+// Function to add a newly arrived task to a runqueue(like the kernel's place_entity).
+// With CFS(START_DEBIT), the task starts one virtual slice after min_vruntime, so that it neither
+// starves the tasks already there nor gets to run first just because it is new.
+// With EEVDF, the task starts at the average vruntime with no lag, and its first request is half
+// the base slice long(PLACE_DEADLINE_INITIAL), so that it gets to run soon without jumping the queue.
+void enqueueNewTask(cfsRunqueue* runqueue, task* newTask) {
+    runqueue->loadWeight += newTask->weight;
+    runqueue->numberOfRunningTasks++;
+    if (useEevdf) {
+        newTask->vruntime = avgVruntime(runqueue);
+        newTask->deadline = newTask->vruntime + calcDeltaFair(baseSlice, newTask) / 2;
+    } else {
+        newTask->vruntime = runqueue->minVruntime + calcDeltaFair(schedSlice(runqueue, newTask), newTask);
+    }
+    enqueueEntity(runqueue, newTask);
+}
+
+// Function to take the next task off the tree and make it the current task: the one with the smallest
+// vruntime with CFS, the eligible one with the earliest virtual deadline with EEVDF
+task* pickNextTask(cfsRunqueue* runqueue) {
+    task* nextTask = useEevdf ? pickEevdfTask(runqueue) : getNextTask(&runqueue->tasksTimeline);
+    if (nextTask != NULL)
+        dequeueEntity(runqueue, nextTask);
+    runqueue->currentTask = nextTask;
+    return nextTask;
+}
+
+// Function to get how long the current task may run: its CFS slice, or with EEVDF the rest of its request
+unsigned long long taskTimeSlice(const cfsRunqueue* runqueue, const task* currentTask) {
+    if (!useEevdf)
+        return schedSlice(runqueue, currentTask);
+
+    // Run time it takes for the vruntime to reach the deadline, rounded up to a whole unit
+    unsigned long long requestTime = (currentTask->deadline - currentTask->vruntime) * currentTask->weight / NICE_0_LOAD;
+    unsigned long long timeSlice = (requestTime + NSEC_PER_UNIT - 1) / NSEC_PER_UNIT;
+    return (timeSlice < 1) ? 1 : timeSlice;
+}
+
+// Function to charge the current task for the time it ran(like the kernel's update_curr).
+// With EEVDF, a task that has used up its request gets a new one(like the kernel's update_deadline).
+void updateCurrentTask(cfsRunqueue* runqueue, unsigned long long runTime) {
+    task* currentTask = runqueue->currentTask;
+    currentTask->vruntime += calcDeltaFair(runTime, currentTask);
+    if (useEevdf && currentTask->vruntime >= currentTask->deadline)
+        currentTask->deadline = currentTask->vruntime + calcDeltaFair(baseSlice, currentTask);
+    updateMinVruntime(runqueue);
+}
+
+// Function to put the current task back into the tree after its time slice
+void putPreviousTask(cfsRunqueue* runqueue) {
+    enqueueEntity(runqueue, runqueue->currentTask);
+    runqueue->currentTask = NULL;
+}
+
+// Function to remove the current task from the runqueue once it has completed
+void dequeueCompletedTask(cfsRunqueue* runqueue) {
+    runqueue->loadWeight -= runqueue->currentTask->weight;
+    runqueue->numberOfRunningTasks--;
+    runqueue->currentTask = NULL;
+    updateMinVruntime(runqueue);
+}
+
+// Function to create a task for a newly arrived record
+task* createTask(const workloadRecord* record) {
+    task* newTask = calloc(1, sizeof(task));
+    if (newTask == NULL) {
+        perror("calloc");
+        return NULL;
+    }
+    newTask->id = record->id;
+    newTask->cpuBurstTime = record->cpuBurstTime;
+    newTask->remainingTime = record->cpuBurstTime;
+    newTask->arrivalTime = record->arrivalTime;
+    newTask->readyTime = record->arrivalTime;
+    newTask->nice = record->nice;
+    newTask->weight = niceToWeight(record->nice);
+    newTask->inverseWeight = niceToInverseWeight(record->nice);
+    return newTask;
+}
+
+// Function to free a task, unless it lives in the snapshot the run resumed from(snapshot may be NULL)
+void releaseTask(task* oldTask, const checkpoint* snapshot) {
+    if (!isInCheckpoint(snapshot, oldTask))
+        free(oldTask);
+}
+
+// Function to release every task still in the runqueue(only needed when the simulation is aborted)
+void destroyRunqueue(rbRootCached* tree, const checkpoint* snapshot) {
+    while (tree->leftmost != NULL) {
+        task* oldTask = taskOfNode(tree->leftmost);
+        dequeueTask(tree, oldTask);
+        releaseTask(oldTask, snapshot);
+    }
+}
+
+// Function to reset the summary before a simulation
+void initSummary(schedulingSummary* summary) {
+    summary->numberOfTasks = 0;
+    summary->totalWaitingTime = 0;
+    summary->totalTime = 0;
+    initSchedulingMetrics(&summary->metrics);
+    summary->numberOfShortTasks = 0;
+    summary->totalShortTaskResponseTime = 0;
+    summary->totalShortTaskWaitingTime = 0;
+    initLatencyHistogram(&summary->shortTaskResponseTimes);
+    initLatencyHistogram(&summary->shortTaskWaitingTimes);
+}
+
+// Function to account for a task that has completed at currentTimestamp.
+// If finishedTasks is not NULL, the task is copied into it.
+void completeTask(schedulingSummary* summary, task* completedTask, unsigned long long currentTimestamp, task finishedTasks[]) {
+    // Every moment between the arrival and the end that the task was not running, it was waiting
+    completedTask->endTime = currentTimestamp;
+    completedTask->waitingTime = completedTask->endTime - completedTask->arrivalTime - completedTask->cpuBurstTime;
+
+    summary->totalWaitingTime += completedTask->waitingTime;
+    summary->totalTime = currentTimestamp;
+    recordCompletion(&summary->metrics, completedTask->arrivalTime, completedTask->startTime, completedTask->endTime, completedTask->waitingTime);
+    if (completedTask->cpuBurstTime <= shortTaskBurst) {
+        unsigned long long responseTime = completedTask->startTime - completedTask->arrivalTime;
+        summary->numberOfShortTasks++;
+        summary->totalShortTaskResponseTime += responseTime;
+        summary->totalShortTaskWaitingTime += completedTask->waitingTime;
+        recordLatency(&summary->shortTaskResponseTimes, responseTime);
+        recordLatency(&summary->shortTaskWaitingTimes, completedTask->waitingTime);
+    }
+    if (finishedTasks != NULL)
+        finishedTasks[summary->numberOfTasks] = *completedTask;
+    summary->numberOfTasks++;
+}
+
+// Function to copy the subtree of node into consecutive task slots of a snapshot, in order, from
+// tasks[*nextIndex]. The links of the copies point to each other as they will once the snapshot is
+// mapped. Returns the node of the copy of the subtree root, at its address in the snapshot being written.
+rbNode* copySubtree(const checkpointWriter* writer, task tasks[], const rbNode* node, unsigned int* nextIndex) {
+    if (node == NULL)
+        return NULL;
+
+    rbNode* left = copySubtree(writer, tasks, node->left, nextIndex);
+    task* copy = &tasks[(*nextIndex)++];
+    *copy = *taskOfNode(node);
+    rbNode* right = copySubtree(writer, tasks, node->right, nextIndex);
+
+    copy->runqueueNode.parent = NULL;   // Set by the caller, which owns the parent
+    copy->runqueueNode.left = checkpointPointer(writer, left);
+    copy->runqueueNode.right = checkpointPointer(writer, right);
+    if (left != NULL)
+        left->parent = checkpointPointer(writer, &copy->runqueueNode);
+    if (right != NULL)
+        right->parent = checkpointPointer(writer, &copy->runqueueNode);
+    copy->nextArrival = NULL;
+    copy->parent = NULL;
+    copy->queuedRunqueue = NULL;
+    copy->myRunqueue = NULL;
+    return &copy->runqueueNode;
+}
+
+// Function to write a snapshot of a run of runCFS(), between two events(no task is on the CPU).
+// Returns 0 on success, -1 on failure.
+int saveCFSCheckpoint(const char* path, const workloadTrace* trace, const cfsRunqueue* runqueue,
+        unsigned long long currentTimestamp, const schedulingSummary* summary, unsigned long long numberOfEvents) {
+    checkpointWriter writer;
+    size_t sectionLengths[2] = {sizeof(cfsCheckpointState), runqueue->numberOfRunningTasks * sizeof(task)};
+    if (beginCheckpoint(&writer, path, "cfs", sectionLengths, 2) == -1)
+        return -1;
+
+    cfsCheckpointState* state = checkpointWriterSection(&writer, 0);
+    task* tasks = checkpointWriterSection(&writer, 1);
+    unsigned int numberOfTasks = 0;
+    rbNode* root = copySubtree(&writer, tasks, runqueue->tasksTimeline.root, &numberOfTasks);
+
+    state->currentTimestamp = currentTimestamp;
+    state->root = checkpointPointer(&writer, root);
+    state->leftmost = (numberOfTasks > 0) ? checkpointPointer(&writer, &tasks[0].runqueueNode) : NULL;
+    state->loadWeight = runqueue->loadWeight;
+    state->numberOfRunningTasks = runqueue->numberOfRunningTasks;
+    state->minVruntime = runqueue->minVruntime;
+    state->avgVruntimeSum = runqueue->avgVruntimeSum;
+    state->avgLoad = runqueue->avgLoad;
+    state->schedLatency = schedLatency;
+    state->minGranularity = minGranularity;
+    state->baseSlice = baseSlice;
+    state->shortTaskBurst = shortTaskBurst;
+    state->useEevdf = useEevdf;
+    state->summary = *summary;
+    return commitCheckpoint(&writer, trace, currentTimestamp, numberOfEvents);
+}
+
+// Moves a pointer stored in a snapshot that could not be mapped where it asked to be
+#define relocateNode(node, relocation) ((node) = ((node) == NULL) ? NULL : (rbNode*)((char*)(node) + (relocation)))
+
+// Function to pick a run of runCFS() up from a snapshot. The tasks stay in the mapping of the snapshot,
+// already linked into the tree, so nothing is copied or rebuilt. Returns 0 on success, -1 on failure.
+int resumeCFS(checkpoint* snapshot, const char* path, workloadTrace* trace, cfsRunqueue* runqueue,
+        unsigned long long* currentTimestamp, schedulingSummary* summary) {
+    if (openCheckpoint(snapshot, path, "cfs") == -1)
+        return -1;
+
+    cfsCheckpointState* state = checkpointSectionData(snapshot, 0);
+    if (state == NULL || checkpointSectionLength(snapshot, 0) != sizeof(*state) ||
+            checkpointSectionLength(snapshot, 1) != state->numberOfRunningTasks * sizeof(task)) {
+        fprintf(stderr, "%s is not a valid cfs checkpoint\n", path);
+        closeCheckpoint(snapshot);
+        return -1;
+    }
+    if (resumeWorkloadTrace(trace, snapshot) == -1) {
+        closeCheckpoint(snapshot);
+        return -1;
+    }
+
+    // Only if the address range was taken: every link moves by the same amount
+    intptr_t relocation = checkpointRelocation(snapshot);
+    if (relocation != 0) {
+        task* tasks = checkpointSectionData(snapshot, 1);
+        for (unsigned int index = 0; index < state->numberOfRunningTasks; index++) {
+            relocateNode(tasks[index].runqueueNode.parent, relocation);
+            relocateNode(tasks[index].runqueueNode.left, relocation);
+            relocateNode(tasks[index].runqueueNode.right, relocation);
+        }
+        relocateNode(state->root, relocation);
+        relocateNode(state->leftmost, relocation);
+    }
+
+    runqueue->tasksTimeline.root = state->root;
+    runqueue->tasksTimeline.leftmost = state->leftmost;
+    runqueue->currentTask = NULL;
+    runqueue->loadWeight = state->loadWeight;
+    runqueue->numberOfRunningTasks = state->numberOfRunningTasks;
+    runqueue->minVruntime = state->minVruntime;
+    runqueue->avgVruntimeSum = state->avgVruntimeSum;
+    runqueue->avgLoad = state->avgLoad;
+    schedLatency = state->schedLatency;
+    minGranularity = state->minGranularity;
+    baseSlice = state->baseSlice;
+    shortTaskBurst = state->shortTaskBurst;
+    useEevdf = state->useEevdf;
+    *currentTimestamp = state->currentTimestamp;
+    *summary = state->summary;
+    return 0;
+}
+
+// Function to release the tasks left in the runqueue, and the snapshot the run resumed from(if any)
+void finishCFSRun(cfsRunqueue* runqueue, checkpoint* snapshot) {
+    destroyRunqueue(&runqueue->tasksTimeline, snapshot);
+    if (snapshot->mapping != NULL)
+        closeCheckpoint(snapshot);
+}
+
+// Function to run CFS scheduling
+// If recordedTimeline is not NULL, every run of a task is recorded into it.
+// If finishedTasks is not NULL, every completed task is copied into it.
+// If checkpoints is not NULL, the run may start from a snapshot and write snapshots as it goes(see
+// checkpointOptions). Returns 1 if the run stopped at checkpoints->stopTime(summary->totalTime is then the
+// clock where it stopped, which may be past stopTime if a run was under way), 0 once every task is completed.
+int runCFS(workloadTrace* trace, bool printTimeline, timeline* recordedTimeline, task finishedTasks[], schedulingSummary* summary,
+        const checkpointOptions* checkpoints) {
+    cfsRunqueue runqueue = {{NULL, NULL}, NULL, 0, 0, 0, 0, 0};
+    checkpoint snapshot = {NULL, 0, NULL};
+    unsigned long long currentTimestamp = 0;
+    unsigned long long numberOfEvents = 0;
+    task* previousTask = NULL;
+
+    initSummary(summary);
+    if (checkpoints != NULL && checkpoints->resumePath != NULL) {
+        if (resumeCFS(&snapshot, checkpoints->resumePath, trace, &runqueue, &currentTimestamp, summary) == -1)
+            return -1;
+        numberOfEvents = snapshot.header->numberOfEvents;
+    }
+    unsigned long long nextCheckpoint = (checkpoints != NULL) ? numberOfEvents + checkpoints->interval : ULLONG_MAX;
+
+    while (true) {
+        // Between two events, every task is in the tree and the CPU is free
+        if (checkpoints != NULL && checkpoints->path != NULL &&
+                (numberOfEvents >= nextCheckpoint || currentTimestamp >= checkpoints->stopTime)) {
+            if (saveCFSCheckpoint(checkpoints->path, trace, &runqueue, currentTimestamp, summary, numberOfEvents) == -1) {
+                finishCFSRun(&runqueue, &snapshot);
+                return -1;
+            }
+            nextCheckpoint = numberOfEvents + checkpoints->interval;
+            if (currentTimestamp >= checkpoints->stopTime) {
+                summary->totalTime = currentTimestamp;
+                finishCFSRun(&runqueue, &snapshot);
+                return 1;
+            }
+        }
+
+        // Admit every task that has arrived by now into the runqueue
+        while (hasArrivalBy(trace, currentTimestamp)) {
+            task* newTask = createTask(nextWorkloadRecord(trace));
+            if (newTask == NULL) {
+                finishCFSRun(&runqueue, &snapshot);
+                return -1;
+            }
+            enqueueNewTask(&runqueue, newTask);
+        }
+
+        // Find the next task to run
+        task* nextTask = pickNextTask(&runqueue);
+        if (nextTask == NULL) {
+            // The CPU is idle until the next task arrives
+            const workloadRecord* nextArrival = peekWorkloadRecord(trace);
+            if (nextArrival == NULL)
+                break;  // Every task is completed
+            currentTimestamp = nextArrival->arrivalTime;
+            continue;
+        }
 
         if (!nextTask->started) {
             // First time the task is running
             nextTask->startTime = currentTimestamp;
-            nextTask->waitingTime = currentTimestamp - nextTask->arrivalTime;
             nextTask->started = true;
         }
+        recordDispatch(&summary->metrics, nextTask->id);
 
         // Check if the task is preempted
-        if (currentTaskIndex != -1 && currentTaskIndex != nextTaskIndex && tasks[currentTaskIndex].remainingTime > 0) {
-            printf("At timestamp %u, task %u was preempted by task %u.\n", currentTimestamp, tasks[currentTaskIndex].id, nextTask->id);
-            printf(" - vruntime of task %u(old): %.4f\n", tasks[currentTaskIndex].id, tasks[currentTaskIndex].vruntime);
-            printf(" - vruntime of task %u(new): %.4f\n", nextTask->id, nextTask->vruntime);
+        if (printTimeline && previousTask != NULL && previousTask != nextTask) {
+            printf("At timestamp %llu, task %u was preempted by task %u.\n", currentTimestamp, previousTask->id, nextTask->id);
+            printf(" - vruntime of task %u(old): %.4f\n", previousTask->id, (double)previousTask->vruntime / NSEC_PER_UNIT);
+            printf(" - vruntime of task %u(new): %.4f\n", nextTask->id, (double)nextTask->vruntime / NSEC_PER_UNIT);
         }
 
-        currentTaskIndex = nextTaskIndex;
-        unsigned int runTime = (nextTask->remainingTime > timeQuantum) ? timeQuantum : nextTask->remainingTime;
+        unsigned long long timeSlice = taskTimeSlice(&runqueue, nextTask);
+        unsigned long long runTime = (nextTask->remainingTime > timeSlice) ? timeSlice : nextTask->remainingTime;
 
-        // Print timeline as the task runs. Also, the current timestamp is incremented.
-        for (unsigned int t = 0; t < runTime; t++) {
-            printf("At timestamp %u, task %u is running.\n", currentTimestamp, nextTask->id);
-            currentTimestamp++;
+        // Print timeline as the task runs, then jump to the end of the time slice
+        if (printTimeline)
+            printf("From timestamp %llu to %llu, task %u is running.\n", currentTimestamp, currentTimestamp + runTime, nextTask->id);
+        if (recordedTimeline != NULL && recordRun(recordedTimeline, nextTask->id, currentTimestamp, runTime) == -1) {
+            releaseTask(nextTask, &snapshot);
+            finishCFSRun(&runqueue, &snapshot);
+            return -1;
         }
+        currentTimestamp += runTime;
 
         // Update the task's remaining time and vruntime
-        // It's calculated as the ratio of the time the task has run to the total time it needs to run
         nextTask->remainingTime -= runTime;
-        nextTask->vruntime += (double)runTime / nextTask->cpuBurstTime;
+        updateCurrentTask(&runqueue, runTime);
+
+        if (nextTask->remainingTime == 0) {
+            completeTask(summary, nextTask, currentTimestamp, finishedTasks);
+            dequeueCompletedTask(&runqueue);
+            releaseTask(nextTask, &snapshot);
+            previousTask = NULL;
+        } else {
+            // Put the task back into the runqueue with its new vruntime
+            putPreviousTask(&runqueue);
+            previousTask = nextTask;
+        }
+        numberOfEvents++;
+    }
+
+    finishCFSRun(&runqueue, &snapshot);
+    return 0;
+}
+
+// A task group on one CPU(like the kernel's struct task_group). The group is queued in the runqueue
+// of its parent as one entity whose weight is the shares of the group, and its own runqueue holds
+// the tasks of the group, or its child groups.
+typedef struct {
+    task entity;                        // Entity of the group in the runqueue of its parent(like tg->se)
+    cfsRunqueue runqueue;               // Entities queued in the group(like tg->cfs_rq)
+    unsigned long long shares;          // Weight of the group(like cpu.shares)
+    unsigned long long runTime;         // CPU time used by the tasks of the group
+    unsigned long long numberOfCompletedTasks;
+    double fairShareTime;               // CPU time of a top-level group under perfectly fair sharing
+    double fairShareClockAtEnqueue;     // Fair share clock when the top-level group became runnable
+} taskGroup;
+
+// A tree of task groups. Groups are stored level by level: the root first, then the groups of the
+// first level, and so on. Group k of a level has fanout children, groups k * fanout to k * fanout + fanout - 1
+// of the next level.
+typedef struct {
+    taskGroup* groups;
+    unsigned int numberOfGroups;
+    unsigned int numberOfLevels;                        // Levels below the root
+    unsigned int fanouts[MAX_GROUP_LEVELS];             // Children of every group of the level above
+    unsigned int levelStarts[MAX_GROUP_LEVELS + 2];     // Index of the first group of every level, and the end
+    double fairShareClock;              // Sum of run time / weight of the root runqueue: a top-level group that
+                                        // is runnable for a clock tick of 1 is owed its shares in CPU time
+} groupHierarchy;
+
+#define groupOfEntity(groupEntity) ((taskGroup*)((char*)(groupEntity) - offsetof(taskGroup, entity)))
+
+// Function to build the groups. fanouts is "10x100" for 10 groups with 100 subgroups each,
+// and shares cycles over the siblings of every level. Returns 0 on success, -1 on failure.
+int createGroupHierarchy(groupHierarchy* hierarchy, const char* fanouts, const unsigned long long shares[], unsigned int numberOfShares) {
+    unsigned long long numberOfGroups = 1, levelSize = 1;
+    const char* text = fanouts;
+
+    memset(hierarchy, 0, sizeof(*hierarchy));
+    while (true) {
+        char* end;
+        unsigned long fanout = strtoul(text, &end, 10);
+        if (end == text || fanout == 0 || fanout > MAX_GROUPS || hierarchy->numberOfLevels == MAX_GROUP_LEVELS)
+            return -1;
+        hierarchy->fanouts[hierarchy->numberOfLevels++] = (unsigned int)fanout;
+        hierarchy->levelStarts[hierarchy->numberOfLevels] = (unsigned int)numberOfGroups;
+        levelSize *= fanout;
+        numberOfGroups += levelSize;
+        if (numberOfGroups > MAX_GROUPS)
+            return -1;
+        if (*end == '\0')
+            break;
+        if (*end != 'x')
+            return -1;
+        text = end + 1;
+    }
+    hierarchy->levelStarts[hierarchy->numberOfLevels + 1] = (unsigned int)numberOfGroups;
+    hierarchy->numberOfGroups = (unsigned int)numberOfGroups;
+
+    hierarchy->groups = calloc(numberOfGroups, sizeof(taskGroup));
+    if (hierarchy->groups == NULL) {
+        perror("calloc");
+        return -1;
+    }
+
+    hierarchy->groups[0].shares = NICE_0_LOAD;
+    for (unsigned int level = 1; level <= hierarchy->numberOfLevels; level++) {
+        unsigned int fanout = hierarchy->fanouts[level - 1];
+        for (unsigned int index = hierarchy->levelStarts[level]; index < hierarchy->levelStarts[level + 1]; index++) {
+            unsigned int positionInLevel = index - hierarchy->levelStarts[level];
+            taskGroup* parent = &hierarchy->groups[hierarchy->levelStarts[level - 1] + positionInLevel / fanout];
+            taskGroup* group = &hierarchy->groups[index];
+
+            group->shares = (numberOfShares > 0) ? shares[(positionInLevel % fanout) % numberOfShares] : NICE_0_LOAD;
+            group->entity.id = index;
+            group->entity.weight = group->shares;
+            group->entity.inverseWeight = inverseWeight(group->shares);
+            group->entity.parent = (parent == &hierarchy->groups[0]) ? NULL : &parent->entity;
+            group->entity.queuedRunqueue = &parent->runqueue;
+            group->entity.myRunqueue = &group->runqueue;
+        }
+    }
+    return 0;
+}
+
+// Function to find the leaf group of a task, by its ID
+taskGroup* leafGroupOf(groupHierarchy* hierarchy, unsigned int id) {
+    unsigned int firstLeaf = hierarchy->levelStarts[hierarchy->numberOfLevels];
+    return &hierarchy->groups[firstLeaf + id % (hierarchy->numberOfGroups - firstLeaf)];
+}
+
+// Function to queue a group that has become runnable in the runqueue of its parent(like the kernel's
+// place_entity on wake-up). With CFS, the group keeps its vruntime unless it slept long enough to fall
+// more than half a targeted latency behind min_vruntime(GENTLE_FAIR_SLEEPERS). With EEVDF, it
+// comes back with no lag.
+void enqueueGroupEntity(cfsRunqueue* runqueue, task* groupEntity) {
+    runqueue->loadWeight += groupEntity->weight;
+    runqueue->numberOfRunningTasks++;
+    if (useEevdf) {
+        groupEntity->vruntime = avgVruntime(runqueue);
+        groupEntity->deadline = groupEntity->vruntime + calcDeltaFair(baseSlice, groupEntity);
+    } else {
+        unsigned long long threshold = schedLatency * NSEC_PER_UNIT / 2;
+        if (runqueue->minVruntime > threshold && groupEntity->vruntime < runqueue->minVruntime - threshold)
+            groupEntity->vruntime = runqueue->minVruntime - threshold;
+    }
+    enqueueEntity(runqueue, groupEntity);
+}
+
+// Function to add a newly arrived task to its group, and every group above it that was not runnable yet
+// (like the kernel's enqueue_task_fair, which stops at the first entity already queued)
+void enqueueNewGroupTask(groupHierarchy* hierarchy, task* newTask) {
+    enqueueNewTask(newTask->queuedRunqueue, newTask);
+    for (task* entity = newTask->parent; entity != NULL && entity->myRunqueue->numberOfRunningTasks == 1; entity = entity->parent) {
+        enqueueGroupEntity(entity->queuedRunqueue, entity);
+        if (entity->parent == NULL)
+            groupOfEntity(entity)->fairShareClockAtEnqueue = hierarchy->fairShareClock;
+    }
+}
+
+// Function to pick the next task: the next entity of the root runqueue, then the next entity of its
+// runqueue, down to a task. A queued group always has an entity to pick.
+task* pickNextGroupTask(cfsRunqueue* rootRunqueue) {
+    task* entity = pickNextTask(rootRunqueue);
+    while (entity != NULL && entity->myRunqueue != NULL)
+        entity = pickNextTask(entity->myRunqueue);
+    return entity;
+}
+
+// Function to get the time slice of a task in a hierarchy: the period, scaled by the share of the
+// weight of every entity on the path in its runqueue(like the kernel's sched_slice). The period
+// stretches with every runnable task, whatever its group(ALT_PERIOD).
+unsigned long long groupTimeSlice(const task* currentTask, unsigned int numberOfRunnableTasks) {
+    if (useEevdf)
+        return taskTimeSlice(currentTask->queuedRunqueue, currentTask);
+
+    // In nanoseconds, so that the shares of the levels are not rounded down to whole units one by one
+    unsigned long long slice = schedPeriod(numberOfRunnableTasks) * NSEC_PER_UNIT;
+    for (const task* entity = currentTask; entity != NULL; entity = entity->parent)
+        slice = slice * entity->weight / entity->queuedRunqueue->loadWeight;
+    slice /= NSEC_PER_UNIT;
+    return (slice < minGranularity) ? minGranularity : slice;
+}
+
+// Function to charge the task that ran, and every group on its path
+void updateCurrentGroupTask(task* currentTask, unsigned long long runTime) {
+    for (task* entity = currentTask; entity != NULL; entity = entity->parent) {
+        updateCurrentTask(entity->queuedRunqueue, runTime);
+        if (entity->myRunqueue != NULL)
+            groupOfEntity(entity)->runTime += runTime;
+    }
+}
+
+// Function to put the task that ran back into its runqueue, and its groups into theirs. A completed
+// task leaves its group, and a group left with nothing to run leaves its parent(like dequeue_task_fair).
+void putPreviousGroupTask(groupHierarchy* hierarchy, task* currentTask, bool completed) {
+    for (task* entity = currentTask; entity != NULL; entity = entity->parent) {
+        cfsRunqueue* runqueue = entity->queuedRunqueue;
+        if (completed) {
+            if (entity->parent == NULL && entity->myRunqueue != NULL) {
+                taskGroup* group = groupOfEntity(entity);
+                group->fairShareTime += group->shares * (hierarchy->fairShareClock - group->fairShareClockAtEnqueue);
+            }
+            dequeueCompletedTask(runqueue);
+            completed = (runqueue->numberOfRunningTasks == 0);
+        } else {
+            putPreviousTask(runqueue);
+        }
+    }
+}
+
+// Function to release every task still in the hierarchy(only needed when the simulation is aborted)
+void destroyGroupHierarchy(groupHierarchy* hierarchy) {
+    unsigned int firstLeaf = hierarchy->levelStarts[hierarchy->numberOfLevels];
+    for (unsigned int index = firstLeaf; index < hierarchy->numberOfGroups; index++)
+        destroyRunqueue(&hierarchy->groups[index].runqueue.tasksTimeline, NULL);
+    free(hierarchy->groups);
+    hierarchy->groups = NULL;
+}
+
+// Function to run CFS with group scheduling on one CPU
+// If recordedTimeline is not NULL, every run of a task is recorded into it.
+// If finishedTasks is not NULL, every completed task is copied into it.
+int runGroupCFS(workloadTrace* trace, groupHierarchy* hierarchy, bool printTimeline, timeline* recordedTimeline,
+        task finishedTasks[], schedulingSummary* summary) {
+    taskGroup* root = &hierarchy->groups[0];
+    unsigned long long currentTimestamp = 0;
+    unsigned int numberOfRunnableTasks = 0;
+    task* previousTask = NULL;
+
+    initSummary(summary);
+
+    while (true) {
+        // Admit every task that has arrived by now into its group
+        while (hasArrivalBy(trace, currentTimestamp)) {
+            task* newTask = createTask(nextWorkloadRecord(trace));
+            if (newTask == NULL)
+                return -1;
+            taskGroup* group = leafGroupOf(hierarchy, newTask->id);
+            newTask->parent = &group->entity;
+            newTask->queuedRunqueue = &group->runqueue;
+            enqueueNewGroupTask(hierarchy, newTask);
+            numberOfRunnableTasks++;
+        }
+
+        task* nextTask = pickNextGroupTask(&root->runqueue);
+        if (nextTask == NULL) {
+            // The CPU is idle until the next task arrives
+            const workloadRecord* nextArrival = peekWorkloadRecord(trace);
+            if (nextArrival == NULL)
+                break;  // Every task is completed
+            currentTimestamp = nextArrival->arrivalTime;
+            continue;
+        }
+
+        if (!nextTask->started) {
+            nextTask->startTime = currentTimestamp;
+            nextTask->started = true;
+        }
+        recordDispatch(&summary->metrics, nextTask->id);
+        if (printTimeline && previousTask != NULL && previousTask != nextTask)
+            printf("At timestamp %llu, task %u(group %u) was preempted by task %u(group %u).\n", currentTimestamp,
+                    previousTask->id, previousTask->parent->id, nextTask->id, nextTask->parent->id);
+
+        unsigned long long timeSlice = groupTimeSlice(nextTask, numberOfRunnableTasks);
+        unsigned long long runTime = (nextTask->remainingTime > timeSlice) ? timeSlice : nextTask->remainingTime;
+        if (printTimeline)
+            printf("From timestamp %llu to %llu, task %u(group %u) is running.\n", currentTimestamp,
+                    currentTimestamp + runTime, nextTask->id, nextTask->parent->id);
+        if (recordedTimeline != NULL && recordRun(recordedTimeline, nextTask->id, currentTimestamp, runTime) == -1) {
+            putPreviousGroupTask(hierarchy, nextTask, false);
+            return -1;
+        }
+        currentTimestamp += runTime;
+        root->runTime += runTime;
+        hierarchy->fairShareClock += (double)runTime / root->runqueue.loadWeight;
+
+        nextTask->remainingTime -= runTime;
+        updateCurrentGroupTask(nextTask, runTime);
 
         if (nextTask->remainingTime == 0) {
-            nextTask->endTime = currentTimestamp;
-            numberOfCompletedTasks++;
+            completeTask(summary, nextTask, currentTimestamp, finishedTasks);
+            groupOfEntity(nextTask->parent)->numberOfCompletedTasks++;
+            putPreviousGroupTask(hierarchy, nextTask, true);
+            numberOfRunnableTasks--;
+            free(nextTask);
+            previousTask = NULL;
+        } else {
+            putPreviousGroupTask(hierarchy, nextTask, false);
+            previousTask = nextTask;
+        }
+    }
+
+    return 0;
+}
+
+// Function to display how the CPU time was shared by the top-level groups, against their fair share:
+// the CPU time they would have had if, at every moment, the CPU had been divided among the runnable
+// top-level groups exactly in proportion to their shares.
+void displayGroupSummary(const groupHierarchy* hierarchy) {
+    unsigned int firstGroup = hierarchy->levelStarts[1], lastGroup = hierarchy->levelStarts[2];
+    unsigned int firstLeaf = hierarchy->levelStarts[hierarchy->numberOfLevels];
+    unsigned int leavesPerGroup = (hierarchy->numberOfGroups - firstLeaf) / hierarchy->fanouts[0];
+    double largestError = 0, totalError = 0;
+    unsigned int largestErrorGroup = firstGroup;
+
+    printf("\nGroup\tShares\tCPU time\tFair share\tError\t\tCompleted\n");
+    for (unsigned int index = firstGroup; index < lastGroup; index++) {
+        const taskGroup* group = &hierarchy->groups[index];
+        double error = group->runTime - group->fairShareTime;
+        double absoluteError = (error < 0) ? -error : error;
+        totalError += absoluteError;
+        if (absoluteError > largestError) {
+            largestError = absoluteError;
+            largestErrorGroup = index;
         }
+
+        // Tasks are counted by their leaf group: add up the leaves below the top-level group
+        unsigned long long numberOfCompletedTasks = 0;
+        for (unsigned int leaf = 0; leaf < leavesPerGroup; leaf++)
+            numberOfCompletedTasks += hierarchy->groups[firstLeaf + (index - firstGroup) * leavesPerGroup + leaf].numberOfCompletedTasks;
+
+        if (index - firstGroup < DISPLAYED_GROUPS)
+            printf("%u\t%llu\t%llu\t\t%.1f\t\t%+.1f\t\t%llu\n", index, group->shares, group->runTime,
+                    group->fairShareTime, error, numberOfCompletedTasks);
     }
+    if (hierarchy->fanouts[0] > DISPLAYED_GROUPS)
+        printf("... and %u more groups\n", hierarchy->fanouts[0] - DISPLAYED_GROUPS);
+    printf("Largest error: %.1f units(group %u), average error: %.1f units, %.4f%% of the CPU time\n", largestError,
+            largestErrorGroup, totalError / hierarchy->fanouts[0],
+            hierarchy->groups[0].runTime > 0 ? 100.0 * totalError / hierarchy->groups[0].runTime : 0.0);
+}
+
+// The state of one CPU of the multi-CPU simulation
+typedef struct {
+    cfsRunqueue runqueue;                   // Tasks waiting for this CPU
+    task* firstArrival;                     // Tasks placed on this CPU that arrive during the current period,
+    task* lastArrival;                      // in the order of their arrival
+    unsigned int numberOfArrivals;
+    unsigned long long clock;               // Local time of this CPU
+    unsigned long long busyTime;            // Time spent running tasks
+    unsigned long long numberOfCompletedTasks;
+    unsigned long long totalWaitingTime;
+    unsigned long long lastEndTime;         // When the last task on this CPU finished
+    unsigned long long migrationsIn;        // Tasks pulled from other CPUs by the load balancer
+    unsigned long long migrationsOut;       // Tasks pushed to other CPUs by the load balancer
+    schedulingMetrics metrics;
+} cpuState;
+
+// The multi-CPU simulation runs in periods between the balance points that matter(see load_balance.h).
+// During a period, every CPU simulates its own runqueue on its own thread. Between two periods, one
+// thread balances the runqueues and places the tasks arriving before the next balance point.
+typedef struct {
+    cpuState* cpus;
+    unsigned int numberOfCpus;
+    workloadTrace* trace;
+    unsigned long long balanceInterval;     // Time between two balance points
+    unsigned long long periodEnd;           // End of the current period
+    unsigned int lastPlacedCpu;             // CPU that got the last arrival
+    bool finished;
+    bool failed;                            // Set when a task could not be allocated
+} multiCpuSimulation;
+
+typedef struct {
+    multiCpuSimulation* simulation;
+    cpuState* cpu;
+    pthread_barrier_t* barrier;
+} cpuThreadArgument;
+
+// Function to get the longest slice any task of a runqueue can get while its tasks stay the same
+unsigned long long longestTimeSlice(const cfsRunqueue* runqueue) {
+    // An EEVDF request is at most baseSlice long, plus the rounding up to a whole unit
+    if (useEevdf)
+        return baseSlice + 1;
+    unsigned long long period = schedPeriod(runqueue->numberOfRunningTasks);
+    return (period < minGranularity) ? minGranularity : period;
+}
+
+// Function to get the earliest time a CPU may start the slice that completes one of its tasks
+// (ULLONG_MAX if it has none)
+unsigned long long earliestCompletion(const cpuState* cpu) {
+    unsigned long long longestSlice = longestTimeSlice(&cpu->runqueue);
+    unsigned long long completionTime = ULLONG_MAX;
+    for (rbNode* node = cpu->runqueue.tasksTimeline.leftmost; node != NULL; node = rbNext(node)) {
+        unsigned long long time = earliestCompletingSlice(cpu->clock, taskOfNode(node)->remainingTime, longestSlice);
+        if (time < completionTime)
+            completionTime = time;
+    }
+    return completionTime;
+}
+
+// Function to simulate one CPU from its clock to the end of the current period
+void runCpuPeriod(multiCpuSimulation* simulation, cpuState* cpu) {
+    while (cpu->clock < simulation->periodEnd) {
+        // Admit the tasks placed on this CPU that have arrived by now
+        while (cpu->firstArrival != NULL && cpu->firstArrival->arrivalTime <= cpu->clock) {
+            task* arrivedTask = cpu->firstArrival;
+            cpu->firstArrival = arrivedTask->nextArrival;
+            cpu->numberOfArrivals--;
+            enqueueNewTask(&cpu->runqueue, arrivedTask);
+        }
+
+        task* nextTask = pickNextTask(&cpu->runqueue);
+        if (nextTask == NULL) {
+            // Idle until the next task placed on this CPU arrives, or until the period ends
+            cpu->clock = (cpu->firstArrival != NULL) ? cpu->firstArrival->arrivalTime : simulation->periodEnd;
+            continue;
+        }
+
+        // A migrated task cannot run here before it stopped running on its previous CPU
+        if (nextTask->readyTime > cpu->clock)
+            cpu->clock = nextTask->readyTime;
+        if (!nextTask->started) {
+            nextTask->startTime = cpu->clock;
+            nextTask->started = true;
+        }
+        recordDispatch(&cpu->metrics, nextTask->id);
+
+        unsigned long long timeSlice = taskTimeSlice(&cpu->runqueue, nextTask);
+        unsigned long long runTime = (nextTask->remainingTime > timeSlice) ? timeSlice : nextTask->remainingTime;
+        cpu->clock += runTime;
+        cpu->busyTime += runTime;
+        nextTask->remainingTime -= runTime;
+        updateCurrentTask(&cpu->runqueue, runTime);
+
+        if (nextTask->remainingTime == 0) {
+            nextTask->endTime = cpu->clock;
+            nextTask->waitingTime = nextTask->endTime - nextTask->arrivalTime - nextTask->cpuBurstTime;
+            cpu->numberOfCompletedTasks++;
+            cpu->totalWaitingTime += nextTask->waitingTime;
+            cpu->lastEndTime = cpu->clock;
+            recordCompletion(&cpu->metrics, nextTask->arrivalTime, nextTask->startTime, nextTask->endTime, nextTask->waitingTime);
+            dequeueCompletedTask(&cpu->runqueue);
+            free(nextTask);
+        } else {
+            nextTask->readyTime = cpu->clock;
+            putPreviousTask(&cpu->runqueue);
+        }
+    }
+}
+
+// Function to even out the runqueues. Tasks are moved from the longest runqueue to the shortest one
+// until they differ by at most one task, which also lets an idle CPU steal work from a busy one.
+// Every runqueue has its own min_vruntime, so a migrated task keeps its lag relative to it
+// (and, with EEVDF, the distance from its vruntime to its deadline).
+void balanceLoad(multiCpuSimulation* simulation) {
+    while (true) {
+        cpuState* busiest = &simulation->cpus[0];
+        cpuState* idlest = &simulation->cpus[0];
+        for (unsigned int index = 1; index < simulation->numberOfCpus; index++) {
+            cpuState* cpu = &simulation->cpus[index];
+            if (cpu->runqueue.numberOfRunningTasks > busiest->runqueue.numberOfRunningTasks)
+                busiest = cpu;
+            if (cpu->runqueue.numberOfRunningTasks < idlest->runqueue.numberOfRunningTasks)
+                idlest = cpu;
+        }
+        if (busiest->runqueue.numberOfRunningTasks <= idlest->runqueue.numberOfRunningTasks + 1)
+            return;
+
+        // The task with the highest vruntime would wait the longest where it is
+        task* migratedTask = getLastTask(&busiest->runqueue.tasksTimeline);
+        dequeueEntity(&busiest->runqueue, migratedTask);
+        busiest->runqueue.loadWeight -= migratedTask->weight;
+        busiest->runqueue.numberOfRunningTasks--;
+        updateMinVruntime(&busiest->runqueue);
+
+        // Unsigned arithmetic wraps around, so this also works when the shift is negative
+        migratedTask->vruntime = migratedTask->vruntime - busiest->runqueue.minVruntime + idlest->runqueue.minVruntime;
+        migratedTask->deadline = migratedTask->deadline - busiest->runqueue.minVruntime + idlest->runqueue.minVruntime;
+        enqueueEntity(&idlest->runqueue, migratedTask);
+        idlest->runqueue.loadWeight += migratedTask->weight;
+        idlest->runqueue.numberOfRunningTasks++;
+        busiest->migrationsOut++;
+        idlest->migrationsIn++;
+    }
+}
+
+// Function to prepare the next period: balance the runqueues, skip over idle gaps, place the tasks
+// arriving before the next balance point on the CPU with the fewest tasks, and skip the balance
+// points where nothing can change.
+void startNextPeriod(multiCpuSimulation* simulation) {
+    balanceLoad(simulation);
+
+    bool isIdle = true;
+    for (unsigned int index = 0; index < simulation->numberOfCpus; index++) {
+        if (simulation->cpus[index].runqueue.numberOfRunningTasks > 0 || simulation->cpus[index].numberOfArrivals > 0)
+            isIdle = false;
+    }
+
+    unsigned long long periodStart = simulation->periodEnd;
+    if (isIdle) {
+        const workloadRecord* nextArrival = peekWorkloadRecord(simulation->trace);
+        if (nextArrival == NULL) {
+            simulation->finished = true;    // Every task is completed
+            return;
+        }
+        if (nextArrival->arrivalTime > periodStart)
+            periodStart = nextArrival->arrivalTime;
+    }
+    simulation->periodEnd = periodStart + simulation->balanceInterval;
+
+    for (unsigned int index = 0; index < simulation->numberOfCpus; index++) {
+        if (simulation->cpus[index].clock < periodStart)
+            simulation->cpus[index].clock = periodStart;
+    }
+
+    while (hasArrivalBy(simulation->trace, simulation->periodEnd - 1)) {
+        task* newTask = createTask(nextWorkloadRecord(simulation->trace));
+        if (newTask == NULL) {
+            simulation->failed = true;
+            simulation->finished = true;
+            return;
+        }
+
+        // Ties go to the CPU after the one that got the previous task, so they are spread evenly
+        unsigned int targetIndex = (simulation->lastPlacedCpu + 1) % simulation->numberOfCpus;
+        for (unsigned int offset = 1; offset < simulation->numberOfCpus; offset++) {
+            unsigned int index = (simulation->lastPlacedCpu + 1 + offset) % simulation->numberOfCpus;
+            cpuState* cpu = &simulation->cpus[index];
+            cpuState* target = &simulation->cpus[targetIndex];
+            if (cpu->runqueue.numberOfRunningTasks + cpu->numberOfArrivals < target->runqueue.numberOfRunningTasks + target->numberOfArrivals)
+                targetIndex = index;
+        }
+        simulation->lastPlacedCpu = targetIndex;
+
+        cpuState* target = &simulation->cpus[targetIndex];
+        if (target->firstArrival == NULL)
+            target->firstArrival = newTask;
+        else
+            target->lastArrival->nextArrival = newTask;
+        target->lastArrival = newTask;
+        target->numberOfArrivals++;
+    }
+
+    // Tasks that are yet to arrive on a CPU change its runqueue during this period
+    unsigned long long completionTime = ULLONG_MAX;
+    for (unsigned int index = 0; index < simulation->numberOfCpus; index++) {
+        cpuState* cpu = &simulation->cpus[index];
+        if (cpu->numberOfArrivals > 0)
+            return;
+        unsigned long long time = earliestCompletion(cpu);
+        if (time < completionTime)
+            completionTime = time;
+    }
+    const workloadRecord* nextArrival = peekWorkloadRecord(simulation->trace);
+    simulation->periodEnd = nextBalancePoint(periodStart, simulation->balanceInterval, completionTime,
+                                             (nextArrival != NULL) ? nextArrival->arrivalTime : ULLONG_MAX);
+}
+
+void* cpuThread(void* param) {
+    cpuThreadArgument* argument = param;
+    multiCpuSimulation* simulation = argument->simulation;
+
+    while (true) {
+        runCpuPeriod(simulation, argument->cpu);
+
+        // Wait for every CPU to reach the end of the period. One of them prepares the next one.
+        if (pthread_barrier_wait(argument->barrier) == PTHREAD_BARRIER_SERIAL_THREAD)
+            startNextPeriod(simulation);
+        pthread_barrier_wait(argument->barrier);
+
+        if (simulation->finished)
+            break;
+    }
+    return NULL;
+}
+
+// Function to release every task still held by a CPU(only needed when the simulation is aborted)
+void releaseCpuTasks(cpuState* cpu) {
+    destroyRunqueue(&cpu->runqueue.tasksTimeline, NULL);
+    while (cpu->firstArrival != NULL) {
+        task* oldTask = cpu->firstArrival;
+        cpu->firstArrival = oldTask->nextArrival;
+        free(oldTask);
+    }
+}
+
+// Function to run CFS on several CPUs, each with its own runqueue
+int runMultiCpuCFS(workloadTrace* trace, unsigned int numberOfCpus, unsigned long long balanceInterval, bool printMetrics) {
+    multiCpuSimulation simulation = {NULL, numberOfCpus, trace, balanceInterval, 0, numberOfCpus - 1, false, false};
+    pthread_barrier_t barrier;
+    pthread_t* threads = malloc(numberOfCpus * sizeof(pthread_t));
+    cpuThreadArgument* arguments = malloc(numberOfCpus * sizeof(cpuThreadArgument));
+    simulation.cpus = calloc(numberOfCpus, sizeof(cpuState));
+    if (threads == NULL || arguments == NULL || simulation.cpus == NULL) {
+        perror("malloc");
+        free(threads);
+        free(arguments);
+        free(simulation.cpus);
+        return -1;
+    }
+
+    pthread_barrier_init(&barrier, NULL, numberOfCpus);
+    startNextPeriod(&simulation);
+
+    if (!simulation.finished) {
+        for (unsigned int index = 0; index < numberOfCpus; index++) {
+            arguments[index].simulation = &simulation;
+            arguments[index].cpu = &simulation.cpus[index];
+            arguments[index].barrier = &barrier;
+            pthread_create(&threads[index], NULL, cpuThread, &arguments[index]);
+        }
+        for (unsigned int index = 0; index < numberOfCpus; index++)
+            pthread_join(threads[index], NULL);
+    }
+
+    // Report how each CPU was used, and the latencies over every task
+    unsigned long long totalTime = 0, numberOfTasks = 0, totalWaitingTime = 0, numberOfMigrations = 0;
+    schedulingMetrics metrics;
+    initSchedulingMetrics(&metrics);
+    for (unsigned int index = 0; index < numberOfCpus; index++) {
+        cpuState* cpu = &simulation.cpus[index];
+        if (cpu->lastEndTime > totalTime)
+            totalTime = cpu->lastEndTime;
+        numberOfTasks += cpu->numberOfCompletedTasks;
+        totalWaitingTime += cpu->totalWaitingTime;
+        numberOfMigrations += cpu->migrationsIn;
+        mergeSchedulingMetrics(&metrics, &cpu->metrics);
+    }
+
+    if (!simulation.failed && printMetrics) {
+        printSchedulingMetrics(&metrics, numberOfTasks, totalWaitingTime, totalTime);
+    } else if (!simulation.failed) {
+        printf("CPU\tUtilization\tCompleted\tMigrated in\tMigrated out\n");
+        for (unsigned int index = 0; index < numberOfCpus; index++) {
+            cpuState* cpu = &simulation.cpus[index];
+            printf("%u\t%.2f%%\t\t%llu\t\t%llu\t\t%llu\n", index,
+                    totalTime > 0 ? 100.0 * cpu->busyTime / totalTime : 0.0,
+                    cpu->numberOfCompletedTasks, cpu->migrationsIn, cpu->migrationsOut);
+        }
+        printf("\nMigrations: %llu\n", numberOfMigrations);
+        if (numberOfTasks == 0) {
+            printf("No tasks\n");
+        } else {
+            printf("Average waiting time: %.2f\n", (double)totalWaitingTime / numberOfTasks);
+            printf("Throughput: %.2f tasks per unit time\n", (double)numberOfTasks / totalTime);
+            printf("Total time taken: %llu units\n", totalTime);
+            printLatencyReport(&metrics);
+        }
+    }
+
+    for (unsigned int index = 0; index < numberOfCpus; index++)
+        releaseCpuTasks(&simulation.cpus[index]);
+    pthread_barrier_destroy(&barrier);
+    free(simulation.cpus);
+    free(arguments);
+    free(threads);
+    return simulation.failed ? -1 : 0;
+}
+
+int compareTaskId(const void* a, const void* b) {
+    const task* taskA = a;
+    const task* taskB = b;
+    return (taskA->id > taskB->id) - (taskA->id < taskB->id);
 }
 
 // Function to display task status information after scheduling
-void displayTaskStatus(task tasks[], int numberOfTasks) {
-    unsigned int totalWaitingTime = 0;
-    printf("\nTaskID  BurstTime       ArrivalTime     WaitingTime     StartTime       EndTime\n");
-    for (int index = 0; index < numberOfTasks; index++) {
-        printf("%d\t%d\t\t%d\t\t%d\t\t%d\t\t%d\n", 
-                    tasks[index].id, 
-                    tasks[index].cpuBurstTime, 
-                    tasks[index].arrivalTime, 
-                    tasks[index].waitingTime, 
-                    tasks[index].startTime, 
+void displayTaskStatus(task tasks[], unsigned int numberOfTasks) {
+    // Tasks are stored in the order they completed. Show them in the order of their ID.
+    qsort(tasks, numberOfTasks, sizeof(task), compareTaskId);
+
+    printf("\nTaskID  Nice    BurstTime       ArrivalTime     WaitingTime     StartTime       EndTime\n");
+    for (unsigned int index = 0; index < numberOfTasks; index++) {
+        printf("%u\t%d\t%llu\t\t%llu\t\t%llu\t\t%llu\t\t%llu\n",
+                    tasks[index].id,
+                    tasks[index].nice,
+                    tasks[index].cpuBurstTime,
+                    tasks[index].arrivalTime,
+                    tasks[index].waitingTime,
+                    tasks[index].startTime,
                     tasks[index].endTime);
-        totalWaitingTime += tasks[index].waitingTime;
     }
-    double averageWaitingTime = (double)totalWaitingTime / numberOfTasks;
-    double throughput = (double)numberOfTasks / tasks[numberOfTasks - 1].endTime;
+}
+
+// Function to display the summary of the scheduling
+void displaySummary(const schedulingSummary* summary) {
+    if (summary->numberOfTasks == 0) {
+        printf("No tasks\n");
+        return;
+    }
+    double averageWaitingTime = (double)summary->totalWaitingTime / summary->numberOfTasks;
+    double throughput = (double)summary->numberOfTasks / summary->totalTime;
 
     printf("Average waiting time: %.2f\n", averageWaitingTime);
     printf("Throughput: %.2f tasks per unit time\n", throughput);
-    printf("Total time taken: %u units\n", tasks[numberOfTasks - 1].endTime);
+    printf("Total time taken: %llu units\n", summary->totalTime);
+    printLatencyReport(&summary->metrics);
+}
+
+// Function to print one row of the comparison, with the relative change from CFS to EEVDF
+void printComparisonRow(const char* metric, double cfsValue, double eevdfValue) {
+    printf("%-30s%14.2f%14.2f", metric, cfsValue, eevdfValue);
+    if (cfsValue > 0)
+        printf("%+13.1f%%\n", 100.0 * (eevdfValue - cfsValue) / cfsValue);
+    else
+        printf("%14s\n", "-");
 }
 
-int main(void) {
-    int numberOfTasks = 5;
-    unsigned int quantum = 1;
+// Function to display CFS and EEVDF side by side, over every task and over the short tasks only
+void displayComparison(const schedulingSummary* cfsSummary, const schedulingSummary* eevdfSummary) {
+    const schedulingSummary* summaries[2] = {cfsSummary, eevdfSummary};
+    double values[9][2];
+
+    for (int rule = 0; rule < 2; rule++) {
+        const schedulingSummary* summary = summaries[rule];
+        unsigned long long numberOfShortTasks = summary->numberOfShortTasks;
+        values[0][rule] = summary->numberOfTasks > 0 ? (double)summary->totalWaitingTime / summary->numberOfTasks : 0.0;
+        values[1][rule] = (double)latencyPercentile(&summary->metrics.waitingTimes, 99);
+        values[2][rule] = summary->numberOfTasks > 0 ? (double)summary->metrics.totalTurnaroundTime / summary->numberOfTasks : 0.0;
+        values[3][rule] = numberOfShortTasks > 0 ? (double)summary->totalShortTaskResponseTime / numberOfShortTasks : 0.0;
+        values[4][rule] = (double)latencyPercentile(&summary->shortTaskResponseTimes, 99);
+        values[5][rule] = (double)latencyPercentile(&summary->shortTaskResponseTimes, 99.9);
+        values[6][rule] = numberOfShortTasks > 0 ? (double)summary->totalShortTaskWaitingTime / numberOfShortTasks : 0.0;
+        values[7][rule] = (double)latencyPercentile(&summary->shortTaskWaitingTimes, 99);
+        values[8][rule] = (double)summary->metrics.numberOfContextSwitches;
+    }
+
+    printf("Short tasks: burst of at most %llu units, %llu of %llu tasks\n\n",
+            shortTaskBurst, cfsSummary->numberOfShortTasks, cfsSummary->numberOfTasks);
+    printf("%-30s%14s%14s%14s\n", "Metric", "CFS", "EEVDF", "Change");
+    printComparisonRow("All tasks, avg waiting", values[0][0], values[0][1]);
+    printComparisonRow("All tasks, p99 waiting", values[1][0], values[1][1]);
+    printComparisonRow("All tasks, avg turnaround", values[2][0], values[2][1]);
+    printComparisonRow("Short tasks, avg response", values[3][0], values[3][1]);
+    printComparisonRow("Short tasks, p99 response", values[4][0], values[4][1]);
+    printComparisonRow("Short tasks, p99.9 response", values[5][0], values[5][1]);
+    printComparisonRow("Short tasks, avg waiting", values[6][0], values[6][1]);
+    printComparisonRow("Short tasks, p99 waiting", values[7][0], values[7][1]);
+    printComparisonRow("Context switches", values[8][0], values[8][1]);
+    printf("\nTotal time taken: %llu units(CFS), %llu units(EEVDF)\n", cfsSummary->totalTime, eevdfSummary->totalTime);
+}
+
+// Function to run CFS and then EEVDF on the same trace, on one CPU
+int compareWithEevdf(const char* path) {
+    workloadTrace trace;
+    schedulingSummary cfsSummary, eevdfSummary;
+
+    useEevdf = false;
+    if (openWorkloadTrace(&trace, path) == -1)
+        return -1;
+    int result = runCFS(&trace, false, NULL, NULL, &cfsSummary, NULL);
+    closeWorkloadTrace(&trace);
+    if (result == -1)
+        return -1;
+
+    useEevdf = true;
+    if (openWorkloadTrace(&trace, path) == -1)
+        return -1;
+    result = runCFS(&trace, false, NULL, NULL, &eevdfSummary, NULL);
+    closeWorkloadTrace(&trace);
+    if (result == -1)
+        return -1;
+
+    displayComparison(&cfsSummary, &eevdfSummary);
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    workloadTrace trace;
+    schedulingSummary summary;
+
+    if (argc > 1) {
+        unsigned int numberOfCpus = 1;
+        unsigned long long balanceInterval = LOAD_BALANCE_INTERVAL;
+        bool printMetrics = false;
+        bool compareRules = false;
+        bool recordTimeline = false;
+        bool validArguments = true;
+        timelineFormat format = TIMELINE_GANTT;
+        const char* timelinePath = NULL;
+        const char* groupFanouts = NULL;
+        unsigned long long shares[MAX_SHARES];
+        unsigned int numberOfShares = 0;
+        checkpointOptions checkpoints;
+        initCheckpointOptions(&checkpoints);
+        for (int index = 2; index < argc; index++) {
+            if (strcmp(argv[index], "--metrics") == 0)
+                printMetrics = true;
+            else if (strcmp(argv[index], "--eevdf") == 0)
+                useEevdf = true;
+            else if (strcmp(argv[index], "--compare") == 0)
+                compareRules = true;
+            else if (strcmp(argv[index], "--latency") == 0 && index + 1 < argc)
+                schedLatency = strtoull(argv[++index], NULL, 10);
+            else if (strcmp(argv[index], "--granularity") == 0 && index + 1 < argc)
+                minGranularity = strtoull(argv[++index], NULL, 10);
+            else if (strcmp(argv[index], "--slice") == 0 && index + 1 < argc)
+                baseSlice = strtoull(argv[++index], NULL, 10);
+            else if (strcmp(argv[index], "--short-burst") == 0 && index + 1 < argc)
+                shortTaskBurst = strtoull(argv[++index], NULL, 10);
+            else if (strcmp(argv[index], "--balance-interval") == 0 && index + 1 < argc)
+                balanceInterval = strtoull(argv[++index], NULL, 10);
+            else if (strcmp(argv[index], "--timeline") == 0 && index + 1 < argc) {
+                recordTimeline = true;
+                validArguments = (parseTimelineFormat(argv[++index], &format) == 0);
+            } else if (strcmp(argv[index], "--timeline-output") == 0 && index + 1 < argc)
+                timelinePath = argv[++index];
+            else if (strcmp(argv[index], "--groups") == 0 && index + 1 < argc)
+                groupFanouts = argv[++index];
+            else if (strcmp(argv[index], "--checkpoint") == 0 && index + 1 < argc)
+                checkpoints.path = argv[++index];
+            else if (strcmp(argv[index], "--checkpoint-every") == 0 && index + 1 < argc)
+                checkpoints.interval = strtoull(argv[++index], NULL, 10);
+            else if (strcmp(argv[index], "--until") == 0 && index + 1 < argc)
+                checkpoints.stopTime = strtoull(argv[++index], NULL, 10);
+            else if (strcmp(argv[index], "--resume") == 0 && index + 1 < argc)
+                checkpoints.resumePath = argv[++index];
+            else if (strcmp(argv[index], "--shares") == 0 && index + 1 < argc) {
+                char* text = argv[++index];
+                while (validArguments) {
+                    char* end;
+                    unsigned long long value = strtoull(text, &end, 10);
+                    validArguments = (end != text && value > 0 && numberOfShares < MAX_SHARES);
+                    if (validArguments)
+                        shares[numberOfShares++] = value;
+                    if (*end != ',')
+                        break;
+                    text = end + 1;
+                }
+            } else
+                numberOfCpus = (unsigned int)strtoul(argv[index], NULL, 10);
+        }
+        if (!validArguments || numberOfCpus == 0 || minGranularity == 0 || schedLatency < minGranularity || baseSlice == 0 ||
+                balanceInterval == 0 || ((compareRules || recordTimeline) && numberOfCpus > 1) ||
+                (compareRules && (printMetrics || useEevdf || recordTimeline)) ||
+                (groupFanouts != NULL && (numberOfCpus > 1 || compareRules)) || (groupFanouts == NULL && numberOfShares > 0) ||
+                checkpoints.interval == 0 || (checkpoints.stopTime != ULLONG_MAX && checkpoints.path == NULL) ||
+                ((checkpoints.path != NULL || checkpoints.resumePath != NULL) && (numberOfCpus > 1 || compareRules || groupFanouts != NULL))) {
+            fprintf(stderr, "Usage: %s <trace> [numberOfCpus] [--latency schedLatency] [--granularity minGranularity] [--eevdf] [--slice baseSlice]\n"
+                    "           [--balance-interval interval] [--metrics] [--timeline gantt|csv|json] [--timeline-output path]\n", argv[0]);
+            fprintf(stderr, "       %s <trace> --compare [--short-burst shortTaskBurst] [--slice baseSlice]\n", argv[0]);
+            fprintf(stderr, "       %s <trace> --groups fanout[xfanout...] [--shares shares[,shares...]] [--eevdf]\n"
+                    "           [--metrics] [--timeline gantt|csv|json] [--timeline-output path]\n", argv[0]);
+            fprintf(stderr, "       %s <trace> [--eevdf] [--checkpoint path] [--checkpoint-every events] [--until timestamp] [--resume path]\n"
+                    "           [--metrics] [--timeline gantt|csv|json] [--timeline-output path]\n", argv[0]);
+            return 1;
+        }
+
+        groupHierarchy hierarchy;
+        if (groupFanouts != NULL && createGroupHierarchy(&hierarchy, groupFanouts, shares, numberOfShares) == -1) {
+            fprintf(stderr, "Invalid task groups %s(at most %d levels and %d groups)\n", groupFanouts, MAX_GROUP_LEVELS, MAX_GROUPS);
+            return 1;
+        }
+        if (compareRules)
+            return (compareWithEevdf(argv[1]) == 0) ? 0 : 1;
+        if (openWorkloadTrace(&trace, argv[1]) == -1) {
+            if (groupFanouts != NULL)
+                destroyGroupHierarchy(&hierarchy);
+            return 1;
+        }
+
+        int result;
+        if (numberOfCpus > 1) {
+            result = runMultiCpuCFS(&trace, numberOfCpus, balanceInterval, printMetrics);
+        } else {
+            timeline recordedTimeline;
+            initTimeline(&recordedTimeline);
+            if (groupFanouts != NULL)
+                result = runGroupCFS(&trace, &hierarchy, false, recordTimeline ? &recordedTimeline : NULL, NULL, &summary);
+            else
+                result = runCFS(&trace, false, recordTimeline ? &recordedTimeline : NULL, NULL, &summary, &checkpoints);
+            if (result == 1) {
+                // Stopped at the end of the time window: only the runs so far are reported
+                printf("Stopped at timestamp %llu with %llu tasks completed. Resume with --resume %s\n",
+                       summary.totalTime, summary.numberOfTasks, checkpoints.path);
+                result = 0;
+            } else if (result == 0 && printMetrics)
+                printSchedulingMetrics(&summary.metrics, summary.numberOfTasks, summary.totalWaitingTime, summary.totalTime);
+            else if (result == 0)
+                displaySummary(&summary);
+            if (result == 0 && !printMetrics && groupFanouts != NULL)
+                displayGroupSummary(&hierarchy);
+            if (result == 0 && recordTimeline)
+                result = writeTimeline(&recordedTimeline, format, timelinePath);
+            destroyTimeline(&recordedTimeline);
+            if (groupFanouts != NULL)
+                destroyGroupHierarchy(&hierarchy);
+        }
+        closeWorkloadTrace(&trace);
+        return (result == 0) ? 0 : 1;
+    }
 
-    task tasks[] = {
-        {1, 0, 6, 6, 0, 0, 0, false},  // Task 1: Burst Time = 6, Arrival Time = 0
-        {2, 0, 8, 8, 2, 0, 0, false},  // Task 2: Burst Time = 8, Arrival Time = 2
-        {3, 0, 7, 7, 4, 0, 0, false},  // Task 3: Burst Time = 7, Arrival Time = 4
-        {4, 0, 3, 3, 6, 0, 0, false},  // Task 4: Burst Time = 3, Arrival Time = 6
-        {5, 0, 4, 4, 8, 0, 0, false}   // Task 5: Burst Time = 4, Arrival Time = 8
+    workloadRecord records[] = {
+        {.arrivalTime = 0, .cpuBurstTime = 6, .id = 1},                // Task 1: Burst Time = 6, Arrival Time = 0
+        {.arrivalTime = 2, .cpuBurstTime = 8, .id = 2, .nice = -5},    // Task 2: Burst Time = 8, Arrival Time = 2, Nice = -5(~3 times the weight of nice 0)
+        {.arrivalTime = 4, .cpuBurstTime = 7, .id = 3},                // Task 3: Burst Time = 7, Arrival Time = 4
+        {.arrivalTime = 6, .cpuBurstTime = 3, .id = 4, .nice = 5},     // Task 4: Burst Time = 3, Arrival Time = 6, Nice = 5(~1/3 of the weight of nice 0)
+        {.arrivalTime = 8, .cpuBurstTime = 4, .id = 5}                 // Task 5: Burst Time = 4, Arrival Time = 8
     };
+    unsigned int numberOfTasks = sizeof(records) / sizeof(records[0]);
+    task tasks[sizeof(records) / sizeof(records[0])];
 
-    runCFS(tasks, numberOfTasks, quantum);
+    openWorkloadTraceFromRecords(&trace, records, numberOfTasks);
+    runCFS(&trace, true, NULL, tasks, &summary, NULL);
     displayTaskStatus(tasks, numberOfTasks);
+    displaySummary(&summary);
 
     return 0;
 }
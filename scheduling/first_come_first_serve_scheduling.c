@@ -1,23 +1,60 @@
 // scheduling/first_come_first_serve_scheduling.c
+// Usage: ./first_come_first_serve_scheduling.out          (small demo with a Gantt chart)
+//        ./first_come_first_serve_scheduling.out <trace> [--metrics]
+//               (replay a workload trace, summary only. --metrics prints one line of key=value pairs instead.)
 #include <stdio.h>
+#include <string.h>
+#include "workload_trace.h"
+#include "scheduling_metrics.h"
 
 typedef struct {
-    unsigned int id;            // Task ID
-    unsigned int cpuBurstTime;  // Time the task needs on the CPU
-    unsigned int waitingTime;   // Time the task has waited in the queue
-    unsigned int startTime;     // Time when the task starts execution
-    unsigned int endTime;       // Time when the task finishes execution
+    unsigned int id;                    // Task ID
+    unsigned long long cpuBurstTime;    // Time the task needs on the CPU
+    unsigned long long arrivalTime;     // Time when the task arrives in the system
+    unsigned long long waitingTime;     // Time the task has waited in the queue
+    unsigned long long startTime;       // Time when the task starts execution
+    unsigned long long endTime;         // Time when the task finishes execution
 } task;
 
-void calculateTimes(task tasks[], int numberOfTasks) {
-    unsigned int currentTime = 0;
+typedef struct {
+    unsigned long long numberOfTasks;       // Number of completed tasks
+    unsigned long long totalWaitingTime;    // Sum of the waiting time of every task
+    unsigned long long totalTime;           // Time when the last task finished
+    schedulingMetrics metrics;
+} schedulingSummary;
+
+// Function to serve the tasks of the trace in the order of their arrival.
+// Each task is only needed until it completes, so the trace is streamed and never stored as a whole.
+// If finishedTasks is not NULL, every completed task is copied into it.
+void calculateTimes(workloadTrace* trace, task finishedTasks[], schedulingSummary* summary) {
+    unsigned long long currentTime = 0;
+    const workloadRecord* record;
+
+    summary->numberOfTasks = 0;
+    summary->totalWaitingTime = 0;
+    summary->totalTime = 0;
+    initSchedulingMetrics(&summary->metrics);
 
     // We assume this scheduling is not preemptive.
-    for (int index = 0; index < numberOfTasks; index++) {
-        tasks[index].startTime = currentTime;
-        tasks[index].waitingTime = currentTime;
-        currentTime += tasks[index].cpuBurstTime;
-        tasks[index].endTime = currentTime;
+    while ((record = nextWorkloadRecord(trace)) != NULL) {
+        task currentTask = {record->id, record->cpuBurstTime, record->arrivalTime, 0, 0, 0};
+
+        // The CPU stays idle until the task arrives
+        if (currentTime < currentTask.arrivalTime)
+            currentTime = currentTask.arrivalTime;
+
+        currentTask.startTime = currentTime;
+        currentTask.waitingTime = currentTime - currentTask.arrivalTime;
+        currentTime += currentTask.cpuBurstTime;
+        currentTask.endTime = currentTime;
+        recordDispatch(&summary->metrics, currentTask.id);
+        recordCompletion(&summary->metrics, currentTask.arrivalTime, currentTask.startTime, currentTask.endTime, currentTask.waitingTime);
+
+        summary->totalWaitingTime += currentTask.waitingTime;
+        summary->totalTime = currentTime;
+        if (finishedTasks != NULL)
+            finishedTasks[summary->numberOfTasks] = currentTask;
+        summary->numberOfTasks++;
     }
 }
 
@@ -28,8 +65,8 @@ void displayGanttChart(task tasks[], int numberOfTasks) {
     // Display the task IDs in Gantt chart format
     printf("Task ID:   ");
     for (int index = 0; index < numberOfTasks; index++) {
-        printf("T%d ", tasks[index].id);
-        for (int time = 1; time < tasks[index].cpuBurstTime; time++) {
+        printf("T%u ", tasks[index].id);
+        for (unsigned long long time = 1; time < tasks[index].cpuBurstTime; time++) {
             printf("  ");  // Add spaces for the duration of the task
         }
     }
@@ -38,30 +75,46 @@ void displayGanttChart(task tasks[], int numberOfTasks) {
     // Display the timeline (start and end times) beneath the task IDs
     printf("Time:      ");
     for (int index = 0; index < numberOfTasks; index++) {
-        printf("%d", tasks[index].startTime);
-        for (int time = 1; time <= tasks[index].cpuBurstTime; time++) {
+        printf("%llu", tasks[index].startTime);
+        for (unsigned long long time = 1; time <= tasks[index].cpuBurstTime; time++) {
             printf("--");
         }
     }
-    printf("%d\n", tasks[numberOfTasks - 1].endTime);
+    printf("%llu\n", tasks[numberOfTasks - 1].endTime);
 }
 
-int main() {
-    // Assume the tasks are sorted based on their arrival time
-    task tasks[] = {
-        {1, 5, 0, 0, 0},
-        {2, 3, 0, 0, 0},
-        {3, 8, 0, 0, 0},
-        {4, 6, 0, 0, 0} 
-    };
+int main(int argc, char* argv[]) {
+    workloadTrace trace;
+    schedulingSummary summary;
 
-    unsigned int numberOfTasks = sizeof(tasks) / sizeof(tasks[0]);
+    if (argc > 1) {
+        if (openWorkloadTrace(&trace, argv[1]) == -1)
+            return 1;
+        calculateTimes(&trace, NULL, &summary);
+        closeWorkloadTrace(&trace);
+        if (argc > 2 && strcmp(argv[2], "--metrics") == 0) {
+            printSchedulingMetrics(&summary.metrics, summary.numberOfTasks, summary.totalWaitingTime, summary.totalTime);
+            return 0;
+        }
+    } else {
+        // Assume the tasks are sorted based on their arrival time
+        workloadRecord records[] = {
+            {.arrivalTime = 0, .cpuBurstTime = 5, .id = 1},
+            {.arrivalTime = 0, .cpuBurstTime = 3, .id = 2},
+            {.arrivalTime = 0, .cpuBurstTime = 8, .id = 3},
+            {.arrivalTime = 0, .cpuBurstTime = 6, .id = 4}
+        };
+        unsigned int numberOfTasks = sizeof(records) / sizeof(records[0]);
+        task tasks[sizeof(records) / sizeof(records[0])];
 
-    calculateTimes(tasks, numberOfTasks);
-    displayGanttChart(tasks, numberOfTasks);
+        openWorkloadTraceFromRecords(&trace, records, numberOfTasks);
+        calculateTimes(&trace, tasks, &summary);
+        displayGanttChart(tasks, numberOfTasks);
+    }
 
-    printf("Total Waiting Time: %f\n", (float)tasks[numberOfTasks - 1].endTime);
-    printf("Average Waiting Time: %f\n", (float)tasks[numberOfTasks - 1].endTime / numberOfTasks);
+    printf("Total Waiting Time: %llu\n", summary.totalWaitingTime);
+    printf("Average Waiting Time: %f\n", summary.numberOfTasks > 0 ? (double)summary.totalWaitingTime / summary.numberOfTasks : 0.0);
+    printLatencyReport(&summary.metrics);
 
     return 0;
 }
@@ -0,0 +1,86 @@
+// scheduling/latency_histogram.h
+// A log-bucketed histogram for latencies(e.g. waiting time), used to report tail percentiles
+// without storing every value.
+//
+// Values below 2^LATENCY_HISTOGRAM_SUB_BUCKET_BITS get a bucket each. Above that, every power of two
+// is split into 2^LATENCY_HISTOGRAM_SUB_BUCKET_BITS equal buckets, so a reported percentile is at
+// most ~3% above the real value, for any value up to 2^64, in a fixed 15KiB.
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <string.h>
+
+#define LATENCY_HISTOGRAM_SUB_BUCKET_BITS 5
+#define LATENCY_HISTOGRAM_SUB_BUCKETS (1u << LATENCY_HISTOGRAM_SUB_BUCKET_BITS)
+#define LATENCY_HISTOGRAM_BUCKETS ((64 - LATENCY_HISTOGRAM_SUB_BUCKET_BITS + 1) * LATENCY_HISTOGRAM_SUB_BUCKETS)
+
+typedef struct {
+    unsigned long long counts[LATENCY_HISTOGRAM_BUCKETS];
+    unsigned long long numberOfValues;
+    unsigned long long maxValue;
+} latencyHistogram;
+
+static inline void initLatencyHistogram(latencyHistogram* histogram) {
+    memset(histogram, 0, sizeof(*histogram));
+}
+
+// Function to find the bucket of a value
+static inline unsigned int latencyBucketOf(unsigned long long value) {
+    if (value < LATENCY_HISTOGRAM_SUB_BUCKETS)
+        return (unsigned int)value;
+
+    unsigned int highestBit = 63 - __builtin_clzll(value);
+    unsigned int shift = highestBit - LATENCY_HISTOGRAM_SUB_BUCKET_BITS;
+    unsigned int subBucket = (unsigned int)(value >> shift) & (LATENCY_HISTOGRAM_SUB_BUCKETS - 1);
+    return (shift + 1) * LATENCY_HISTOGRAM_SUB_BUCKETS + subBucket;
+}
+
+// Function to get the largest value that falls into a bucket
+static inline unsigned long long latencyBucketHighestValue(unsigned int bucket) {
+    if (bucket < LATENCY_HISTOGRAM_SUB_BUCKETS)
+        return bucket;
+
+    unsigned int shift = bucket / LATENCY_HISTOGRAM_SUB_BUCKETS - 1;
+    unsigned long long subBucket = bucket % LATENCY_HISTOGRAM_SUB_BUCKETS;
+    unsigned long long lowestValue = (LATENCY_HISTOGRAM_SUB_BUCKETS + subBucket) << shift;
+    return lowestValue + ((1ull << shift) - 1);
+}
+
+static inline void recordLatency(latencyHistogram* histogram, unsigned long long value) {
+    histogram->counts[latencyBucketOf(value)]++;
+    histogram->numberOfValues++;
+    if (value > histogram->maxValue)
+        histogram->maxValue = value;
+}
+
+// Function to add every value of source into destination
+static inline void mergeLatencyHistogram(latencyHistogram* destination, const latencyHistogram* source) {
+    for (unsigned int bucket = 0; bucket < LATENCY_HISTOGRAM_BUCKETS; bucket++)
+        destination->counts[bucket] += source->counts[bucket];
+    destination->numberOfValues += source->numberOfValues;
+    if (source->maxValue > destination->maxValue)
+        destination->maxValue = source->maxValue;
+}
+
+// Function to get the value below which the given percentage(0 to 100) of the values fall.
+// The result is the upper edge of the bucket, but never more than the largest recorded value.
+static inline unsigned long long latencyPercentile(const latencyHistogram* histogram, double percentile) {
+    if (histogram->numberOfValues == 0)
+        return 0;
+
+    unsigned long long rank = (unsigned long long)(percentile / 100.0 * histogram->numberOfValues + 0.5);
+    if (rank == 0)
+        rank = 1;
+
+    unsigned long long seen = 0;
+    for (unsigned int bucket = 0; bucket < LATENCY_HISTOGRAM_BUCKETS; bucket++) {
+        seen += histogram->counts[bucket];
+        if (seen >= rank) {
+            unsigned long long value = latencyBucketHighestValue(bucket);
+            return (value < histogram->maxValue) ? value : histogram->maxValue;
+        }
+    }
+    return histogram->maxValue;
+}
+
+#endif
@@ -0,0 +1,61 @@
+// scheduling/load_balance.h
+// Balance points of the multi-CPU simulations(completely_fair_scheduling.c and round_robin.c).
+//
+// Every CPU simulates its own runqueue on its own thread. At balance points, every
+// LOAD_BALANCE_INTERVAL units(or --balance-interval) after the first arrival, the threads stop, one
+// of them balances the runqueues and places the tasks arriving before the next balance point, and
+// they all carry on. Balancing only moves tasks when two CPUs are more than one task apart, which
+// is never the case right after a pass, so a balance point only matters if tasks were placed at the
+// previous one, or if a CPU completed a task since then.
+//
+// A CPU completes a task in a slice that starts when the remaining time of the task is at most the
+// longest slice. A CPU runs one task at a time, so that cannot happen before
+//   clock + remaining time - longest slice
+// for any of its tasks. The threads only stop at the first balance point that an arrival or such a
+// completion may reach, and skip the others: the simulation takes time in proportion to its events
+// instead of the simulated time, and gives the same schedule as stopping at every balance point.
+#ifndef LOAD_BALANCE_H
+#define LOAD_BALANCE_H
+
+#include <limits.h>
+
+// Default time between two balance points: one CFS targeted latency(6ms at 0.75ms per unit),
+// the same order as the kernel's balance interval for a domain of a few CPUs
+#define LOAD_BALANCE_INTERVAL 8
+
+// Function to get the earliest time a CPU at clock can start the slice that completes a task
+// with remainingTime left, when no slice is longer than longestSlice
+static inline unsigned long long earliestCompletingSlice(unsigned long long clock, unsigned long long remainingTime,
+        unsigned long long longestSlice) {
+    return (remainingTime > longestSlice) ? clock + (remainingTime - longestSlice) : clock;
+}
+
+// Function to get the first balance point after time(ULLONG_MAX if time is)
+static inline unsigned long long balancePointAfter(unsigned long long periodStart, unsigned long long interval,
+        unsigned long long time) {
+    if (time == ULLONG_MAX)
+        return ULLONG_MAX;
+    if (time < periodStart)
+        return periodStart;
+    unsigned long long elapsedPeriods = (time - periodStart) / interval + 1;
+    if (elapsedPeriods > (ULLONG_MAX - periodStart) / interval)
+        return ULLONG_MAX;
+    return periodStart + elapsedPeriods * interval;
+}
+
+// Function to get the next balance point that matters, the current period being
+// [periodStart, periodStart + interval). A task arriving at nextArrivalTime is placed at the last
+// balance point before it, and a task completed in a slice that starts at completionTime is seen
+// at the first one after it. Both are ULLONG_MAX if there is none.
+static inline unsigned long long nextBalancePoint(unsigned long long periodStart, unsigned long long interval,
+        unsigned long long completionTime, unsigned long long nextArrivalTime) {
+    unsigned long long balancePoint = balancePointAfter(periodStart, interval, completionTime);
+    unsigned long long placementPoint = balancePointAfter(periodStart, interval, nextArrivalTime);
+    if (placementPoint != ULLONG_MAX)
+        placementPoint -= interval;
+    if (placementPoint < balancePoint)
+        balancePoint = placementPoint;
+    return (balancePoint > periodStart + interval) ? balancePoint : periodStart + interval;
+}
+
+#endif
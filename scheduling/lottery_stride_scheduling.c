@@ -0,0 +1,491 @@
+// scheduling/lottery_stride_scheduling.c
+// Proportional-share scheduling: lottery and stride scheduling(Waldspurger & Weihl).
+// Every task holds tickets, as many as the weight of its nice level(nice_weights.h), and is entitled
+// to the share of the CPU that its tickets are of the tickets of every runnable task. The CPU is
+// handed out one time quantum at a time.
+//  - Lottery: every quantum goes to the holder of a ticket drawn at random. The tickets of the tasks
+//    are kept in a Fenwick tree indexed by the slot of the task, so that the draw is one O(log n)
+//    walk down the tree instead of a walk over every task, and a task joins or leaves in O(log n).
+//  - Stride: every task advances its pass by its stride(STRIDE1 / tickets) for every unit of time
+//    it runs, and the task with the lowest pass runs next. Tasks are kept in a min-heap on the pass.
+//    A task joins one stride after the global pass, the pass of a task that would have held its
+//    tickets from the start.
+// The simulation is event-driven: the clock jumps from one quantum to the next.
+//
+// How fair a policy is shows in the difference between the CPU time a task received and the time it
+// was entitled to: its share, integrated over the time it was runnable. Like a fair share clock,
+// the sum of run time / tickets of every runnable task advances once for every run, and a task is
+// entitled to tickets * (clock now - clock when it arrived), so no task is visited when nothing
+// is reported. The error is reported at times that double(or every --report-interval), over every
+// runnable task, and for every task when it completes. Lottery errors grow with the square root of
+// the number of quanta; stride errors stay within a few quanta.
+//
+// Usage: ./lottery_stride_scheduling.out                  (small demo with a full timeline, both policies)
+//        ./lottery_stride_scheduling.out <trace> [--policy lottery|stride|both] [--quantum timeQuantum] [--seed seed]
+//               [--report-interval time] [--metrics] [--timeline gantt|csv|json] [--timeline-output path]
+//               (replay a workload trace, or a generator spec such as gen:tasks=100000,load=20,mean=1000,
+//                with the fairness error over time. --metrics prints one line of key=value pairs instead,
+//                for a single policy.)
+// gcc -o lottery_stride_scheduling.out lottery_stride_scheduling.c -lm
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "workload_trace.h"
+#include "latency_histogram.h"
+#include "scheduling_metrics.h"
+#include "nice_weights.h"
+#include "timeline.h"
+
+#define TIME_QUANTUM 2                  // Default time quantum
+#define STRIDE1 (1ull << 32)            // Stride of a task with a single ticket
+#define FIRST_REPORT_TIME 1000          // Reports are at times that double from this one(without --report-interval)
+#define RANDOM_SEED 42
+
+typedef enum {
+    POLICY_LOTTERY,
+    POLICY_STRIDE
+} proportionalSharePolicy;
+
+typedef struct {
+    unsigned int id;                    // Task ID
+    int nice;
+    unsigned long long tickets;         // 0 while the slot is free
+    unsigned long long stride;          // STRIDE1 / tickets
+    unsigned long long pass;            // Virtual time of the task(stride)
+    unsigned long long cpuBurstTime;    // Time the task needs on the CPU
+    unsigned long long remainingTime;   // Time left for the task to finish
+    unsigned long long arrivalTime;     // Time when the task arrives in the system
+    unsigned long long startTime;       // Time when the task starts execution
+    bool started;                       // Whether the task has started running
+    double fairShareClockAtArrival;
+} task;
+
+typedef struct {
+    unsigned long long pass;
+    unsigned int id;                    // Breaks ties, so that the order is deterministic
+    unsigned int slot;
+} passHeapEntry;
+
+// Runnable tasks, by slot. A completed task frees its slot for a later arrival.
+typedef struct {
+    task* tasks;
+    unsigned int capacity;              // Always a power of two, so that the Fenwick tree can be walked down
+    unsigned int* freeSlots;
+    unsigned int numberOfFreeSlots;
+    unsigned int numberOfTasks;
+    unsigned long long totalTickets;    // Tickets of every runnable task
+    unsigned long long* ticketTree;     // Fenwick tree over the tickets of the slots(lottery), 1-based
+    passHeapEntry* passHeap;            // Min-heap on the pass(stride)
+    unsigned int passHeapSize;
+    unsigned long long globalPass;      // Pass of a task that would hold the tickets of every task(stride)
+    double fairShareClock;              // Sum of run time / totalTickets(see above)
+    unsigned long long randomState;
+} taskTable;
+
+typedef struct {
+    unsigned long long numberOfTasks;       // Number of completed tasks
+    unsigned long long totalWaitingTime;    // Sum of the waiting time of every task
+    unsigned long long totalTime;           // Time when the last task finished
+    schedulingMetrics metrics;
+    latencyHistogram completionErrors;      // |CPU time - entitled CPU time| of every task when it completes
+    double totalCompletionError;
+} schedulingSummary;
+
+// Function to get the next random number(xorshift64*)
+unsigned long long nextRandom(unsigned long long* state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545F4914F6CDD1Dull;
+}
+
+// Function to add delta tickets to a slot in the Fenwick tree, O(log n)
+void updateTickets(taskTable* table, unsigned int slot, long long delta) {
+    for (unsigned int index = slot + 1; index <= table->capacity; index += index & (0u - index))
+        table->ticketTree[index] += (unsigned long long)delta;
+}
+
+// Function to find the slot that holds a ticket, numbered from 0 over the slots in order, O(log n).
+// Walks down the tree, skipping every subtree whose tickets all come before the ticket.
+unsigned int findTicketHolder(const taskTable* table, unsigned long long ticket) {
+    unsigned int position = 0;
+    for (unsigned int step = table->capacity; step > 0; step /= 2) {
+        if (position + step <= table->capacity && table->ticketTree[position + step] <= ticket) {
+            position += step;
+            ticket -= table->ticketTree[position];
+        }
+    }
+    return position;    // The tree is 1-based, so this is the 0-based slot that follows the skipped ones
+}
+
+bool isPassBefore(const passHeapEntry* a, const passHeapEntry* b) {
+    if (a->pass != b->pass)
+        return a->pass < b->pass;
+    return a->id < b->id;
+}
+
+void pushPass(taskTable* table, unsigned int slot) {
+    passHeapEntry entry = {table->tasks[slot].pass, table->tasks[slot].id, slot};
+    unsigned int index = table->passHeapSize++;
+    while (index > 0) {
+        unsigned int parent = (index - 1) / 2;
+        if (!isPassBefore(&entry, &table->passHeap[parent]))
+            break;
+        table->passHeap[index] = table->passHeap[parent];
+        index = parent;
+    }
+    table->passHeap[index] = entry;
+}
+
+int popPass(taskTable* table) {
+    if (table->passHeapSize == 0)
+        return -1;
+
+    unsigned int slot = table->passHeap[0].slot;
+    passHeapEntry last = table->passHeap[--table->passHeapSize];
+    unsigned int index = 0;
+    while (true) {
+        unsigned int child = 2 * index + 1;
+        if (child >= table->passHeapSize)
+            break;
+        if (child + 1 < table->passHeapSize && isPassBefore(&table->passHeap[child + 1], &table->passHeap[child]))
+            child++;
+        if (!isPassBefore(&table->passHeap[child], &last))
+            break;
+        table->passHeap[index] = table->passHeap[child];
+        index = child;
+    }
+    if (table->passHeapSize > 0)
+        table->passHeap[index] = last;
+    return (int)slot;
+}
+
+// Function to double the number of slots. The Fenwick tree is rebuilt for the new size.
+int growTaskTable(taskTable* table) {
+    unsigned int newCapacity = (table->capacity == 0) ? 64 : table->capacity * 2;
+    task* newTasks = realloc(table->tasks, newCapacity * sizeof(task));
+    unsigned int* newFreeSlots = realloc(table->freeSlots, newCapacity * sizeof(unsigned int));
+    unsigned long long* newTicketTree = realloc(table->ticketTree, (newCapacity + 1) * sizeof(unsigned long long));
+    passHeapEntry* newPassHeap = realloc(table->passHeap, newCapacity * sizeof(passHeapEntry));
+    if (newTasks != NULL)
+        table->tasks = newTasks;
+    if (newFreeSlots != NULL)
+        table->freeSlots = newFreeSlots;
+    if (newTicketTree != NULL)
+        table->ticketTree = newTicketTree;
+    if (newPassHeap != NULL)
+        table->passHeap = newPassHeap;
+    if (newTasks == NULL || newFreeSlots == NULL || newTicketTree == NULL || newPassHeap == NULL) {
+        perror("realloc");
+        return -1;
+    }
+
+    memset(&table->tasks[table->capacity], 0, (newCapacity - table->capacity) * sizeof(task));
+    for (unsigned int slot = newCapacity; slot > table->capacity; slot--)
+        table->freeSlots[table->numberOfFreeSlots++] = slot - 1;
+    table->capacity = newCapacity;
+
+    // Every node covers the slots (index - lowest bit of index, index]: add each slot, then pass its sum up
+    memset(table->ticketTree, 0, (newCapacity + 1) * sizeof(unsigned long long));
+    for (unsigned int index = 1; index <= newCapacity; index++) {
+        table->ticketTree[index] += table->tasks[index - 1].tickets;
+        unsigned int parent = index + (index & (0u - index));
+        if (parent <= newCapacity)
+            table->ticketTree[parent] += table->ticketTree[index];
+    }
+    return 0;
+}
+
+// Function to admit a newly arrived task. Returns its slot, or -1 if the table could not grow.
+int addTask(taskTable* table, proportionalSharePolicy policy, const workloadRecord* record) {
+    if (table->numberOfFreeSlots == 0 && growTaskTable(table) == -1)
+        return -1;
+
+    unsigned int slot = table->freeSlots[--table->numberOfFreeSlots];
+    task* newTask = &table->tasks[slot];
+    memset(newTask, 0, sizeof(*newTask));
+    newTask->id = record->id;
+    newTask->nice = record->nice;
+    newTask->tickets = niceToWeight(record->nice);
+    newTask->stride = STRIDE1 / newTask->tickets;
+    newTask->cpuBurstTime = record->cpuBurstTime;
+    newTask->remainingTime = record->cpuBurstTime;
+    newTask->arrivalTime = record->arrivalTime;
+    newTask->fairShareClockAtArrival = table->fairShareClock;
+
+    table->numberOfTasks++;
+    table->totalTickets += newTask->tickets;
+    if (policy == POLICY_LOTTERY) {
+        updateTickets(table, slot, (long long)newTask->tickets);
+    } else {
+        newTask->pass = table->globalPass + newTask->stride;
+        pushPass(table, slot);
+    }
+    return (int)slot;
+}
+
+// Function to release the slot of a completed task
+void removeTask(taskTable* table, proportionalSharePolicy policy, unsigned int slot) {
+    task* oldTask = &table->tasks[slot];
+    if (policy == POLICY_LOTTERY)
+        updateTickets(table, slot, -(long long)oldTask->tickets);
+    table->totalTickets -= oldTask->tickets;
+    table->numberOfTasks--;
+    oldTask->tickets = 0;
+    table->freeSlots[table->numberOfFreeSlots++] = slot;
+}
+
+// Function to pick the task that gets the next quantum(it leaves the heap until it is put back, with stride)
+int pickNextTask(taskTable* table, proportionalSharePolicy policy) {
+    if (table->numberOfTasks == 0)
+        return -1;
+    if (policy == POLICY_STRIDE)
+        return popPass(table);
+    return (int)findTicketHolder(table, nextRandom(&table->randomState) % table->totalTickets);
+}
+
+// Function to charge a task for the time it ran, while it still holds its tickets
+void chargeTask(taskTable* table, unsigned int slot, unsigned long long runTime) {
+    task* currentTask = &table->tasks[slot];
+    currentTask->remainingTime -= runTime;
+    currentTask->pass += currentTask->stride * runTime;
+    table->globalPass += STRIDE1 / table->totalTickets * runTime;
+    table->fairShareClock += (double)runTime / table->totalTickets;
+}
+
+// Function to get how far a task is from its entitled CPU time: positive when it got more
+double fairnessError(const taskTable* table, const task* checkedTask) {
+    double entitledTime = checkedTask->tickets * (table->fairShareClock - checkedTask->fairShareClockAtArrival);
+    return (double)(checkedTask->cpuBurstTime - checkedTask->remainingTime) - entitledTime;
+}
+
+// Function to print one row of the fairness report: the error of every runnable task, O(n)
+void reportFairness(const taskTable* table, unsigned long long currentTimestamp) {
+    latencyHistogram errors;
+    double totalError = 0, largestError = 0;
+
+    initLatencyHistogram(&errors);
+    for (unsigned int slot = 0; slot < table->capacity; slot++) {
+        const task* checkedTask = &table->tasks[slot];
+        if (checkedTask->tickets == 0)
+            continue;
+        double error = fairnessError(table, checkedTask);
+        if (error < 0)
+            error = -error;
+        totalError += error;
+        if (error > largestError)
+            largestError = error;
+        recordLatency(&errors, (unsigned long long)(error + 0.5));
+    }
+
+    printf("%-14llu%10u%14.2f%14llu%14.2f\n", currentTimestamp, table->numberOfTasks,
+            table->numberOfTasks > 0 ? totalError / table->numberOfTasks : 0.0,
+            latencyPercentile(&errors, 99), largestError);
+}
+
+void destroyTaskTable(taskTable* table) {
+    free(table->tasks);
+    free(table->freeSlots);
+    free(table->ticketTree);
+    free(table->passHeap);
+    memset(table, 0, sizeof(*table));
+}
+
+// Function to run lottery or stride scheduling
+// If reportInterval is not 0, the fairness is reported every reportInterval, otherwise at times that double.
+// If printReport is false, nothing is reported while the simulation runs.
+int runProportionalShare(workloadTrace* trace, proportionalSharePolicy policy, unsigned long long timeQuantum,
+        unsigned long long seed, bool printReport, unsigned long long reportInterval, bool printTimeline,
+        timeline* recordedTimeline, schedulingSummary* summary) {
+    taskTable table;
+    unsigned long long currentTimestamp = 0;
+    unsigned long long nextReport = (reportInterval != 0) ? reportInterval : FIRST_REPORT_TIME;
+    int result = 0;
+
+    memset(&table, 0, sizeof(table));
+    table.randomState = seed | 1;
+    memset(summary, 0, sizeof(*summary));
+    initSchedulingMetrics(&summary->metrics);
+    initLatencyHistogram(&summary->completionErrors);
+
+    if (printReport)
+        printf("%-14s%10s%14s%14s%14s\n", "Time", "Tasks", "Mean |error|", "p99 |error|", "Max |error|");
+
+    while (true) {
+        // Admit every task that has arrived by now
+        while (hasArrivalBy(trace, currentTimestamp)) {
+            if (addTask(&table, policy, nextWorkloadRecord(trace)) == -1) {
+                destroyTaskTable(&table);
+                return -1;
+            }
+        }
+
+        int slot = pickNextTask(&table, policy);
+        if (slot == -1) {
+            // The CPU is idle until the next task arrives
+            const workloadRecord* nextArrival = peekWorkloadRecord(trace);
+            if (nextArrival == NULL)
+                break;  // Every task is completed
+            currentTimestamp = nextArrival->arrivalTime;
+            continue;
+        }
+
+        task* nextTask = &table.tasks[slot];
+        if (!nextTask->started) {
+            nextTask->startTime = currentTimestamp;
+            nextTask->started = true;
+        }
+        recordDispatch(&summary->metrics, nextTask->id);
+
+        unsigned long long runTime = (nextTask->remainingTime > timeQuantum) ? timeQuantum : nextTask->remainingTime;
+        if (printTimeline)
+            printf("From timestamp %llu to %llu, task %u is running.\n", currentTimestamp, currentTimestamp + runTime, nextTask->id);
+        if (recordedTimeline != NULL && recordRun(recordedTimeline, nextTask->id, currentTimestamp, runTime) == -1) {
+            result = -1;
+            break;
+        }
+        currentTimestamp += runTime;
+        chargeTask(&table, slot, runTime);
+
+        if (nextTask->remainingTime == 0) {
+            // Every moment between the arrival and the end that the task was not running, it was waiting
+            unsigned long long waitingTime = currentTimestamp - nextTask->arrivalTime - nextTask->cpuBurstTime;
+            double error = fairnessError(&table, nextTask);
+            if (error < 0)
+                error = -error;
+
+            summary->numberOfTasks++;
+            summary->totalWaitingTime += waitingTime;
+            summary->totalTime = currentTimestamp;
+            summary->totalCompletionError += error;
+            recordLatency(&summary->completionErrors, (unsigned long long)(error + 0.5));
+            recordCompletion(&summary->metrics, nextTask->arrivalTime, nextTask->startTime, currentTimestamp, waitingTime);
+            removeTask(&table, policy, slot);
+        } else if (policy == POLICY_STRIDE) {
+            pushPass(&table, slot);
+        }
+
+        if (printReport && currentTimestamp >= nextReport) {
+            reportFairness(&table, currentTimestamp);
+            while (nextReport <= currentTimestamp)
+                nextReport = (reportInterval != 0) ? nextReport + reportInterval : nextReport * 2;
+        }
+    }
+
+    destroyTaskTable(&table);
+    return result;
+}
+
+const char* policyName(proportionalSharePolicy policy) {
+    return (policy == POLICY_LOTTERY) ? "Lottery" : "Stride";
+}
+
+// Function to display the summary of the scheduling
+void displaySummary(const schedulingSummary* summary) {
+    if (summary->numberOfTasks == 0) {
+        printf("No tasks\n");
+        return;
+    }
+    double averageWaitingTime = (double)summary->totalWaitingTime / summary->numberOfTasks;
+    double throughput = (double)summary->numberOfTasks / summary->totalTime;
+
+    printf("Average waiting time: %.2f\n", averageWaitingTime);
+    printf("Throughput: %.2f tasks per unit time\n", throughput);
+    printf("Total time taken: %llu units\n", summary->totalTime);
+    printf("Fairness error at completion(|CPU time - entitled CPU time|) mean/p50/p99/max: %.2f / %llu / %llu / %llu\n",
+            summary->totalCompletionError / summary->numberOfTasks, latencyPercentile(&summary->completionErrors, 50),
+            latencyPercentile(&summary->completionErrors, 99), summary->completionErrors.maxValue);
+    printLatencyReport(&summary->metrics);
+}
+
+void printUsage(const char* program) {
+    fprintf(stderr, "Usage: %s <trace> [--policy lottery|stride|both] [--quantum timeQuantum] [--seed seed]\n"
+            "           [--report-interval time] [--metrics] [--timeline gantt|csv|json] [--timeline-output path]\n", program);
+}
+
+int main(int argc, char* argv[]) {
+    bool policies[2] = {true, true};
+    unsigned long long timeQuantum = TIME_QUANTUM, seed = RANDOM_SEED, reportInterval = 0;
+    bool printMetrics = false, recordTimeline = false, validArguments = true;
+    timelineFormat format = TIMELINE_GANTT;
+    const char* timelinePath = NULL;
+    workloadTrace trace;
+    schedulingSummary summary;
+
+    if (argc == 1) {
+        workloadRecord records[] = {
+            {.arrivalTime = 0, .cpuBurstTime = 12, .id = 1},                // Task 1: 1024 tickets
+            {.arrivalTime = 0, .cpuBurstTime = 12, .id = 2, .nice = -5},    // Task 2: 3121 tickets(~3 times task 1)
+            {.arrivalTime = 0, .cpuBurstTime = 12, .id = 3, .nice = 5},     // Task 3: 335 tickets(~1/3 of task 1)
+            {.arrivalTime = 6, .cpuBurstTime = 6, .id = 4}                  // Task 4: 1024 tickets, arrives later
+        };
+
+        for (int policy = POLICY_LOTTERY; policy <= POLICY_STRIDE; policy++) {
+            printf("%s:\n", policyName((proportionalSharePolicy)policy));
+            openWorkloadTraceFromRecords(&trace, records, sizeof(records) / sizeof(records[0]));
+            runProportionalShare(&trace, (proportionalSharePolicy)policy, timeQuantum, seed, false, 0, true, NULL, &summary);
+            closeWorkloadTrace(&trace);
+            displaySummary(&summary);
+            printf("\n");
+        }
+        return 0;
+    }
+
+    for (int index = 2; index < argc && validArguments; index++) {
+        if (strcmp(argv[index], "--policy") == 0 && index + 1 < argc) {
+            index++;
+            policies[POLICY_LOTTERY] = (strcmp(argv[index], "lottery") == 0 || strcmp(argv[index], "both") == 0);
+            policies[POLICY_STRIDE] = (strcmp(argv[index], "stride") == 0 || strcmp(argv[index], "both") == 0);
+            validArguments = (policies[POLICY_LOTTERY] || policies[POLICY_STRIDE]);
+        } else if (strcmp(argv[index], "--quantum") == 0 && index + 1 < argc) {
+            timeQuantum = strtoull(argv[++index], NULL, 10);
+            validArguments = (timeQuantum > 0);
+        } else if (strcmp(argv[index], "--seed") == 0 && index + 1 < argc) {
+            seed = strtoull(argv[++index], NULL, 10);
+        } else if (strcmp(argv[index], "--report-interval") == 0 && index + 1 < argc) {
+            reportInterval = strtoull(argv[++index], NULL, 10);
+        } else if (strcmp(argv[index], "--metrics") == 0) {
+            printMetrics = true;
+        } else if (strcmp(argv[index], "--timeline") == 0 && index + 1 < argc) {
+            recordTimeline = true;
+            validArguments = (parseTimelineFormat(argv[++index], &format) == 0);
+        } else if (strcmp(argv[index], "--timeline-output") == 0 && index + 1 < argc) {
+            timelinePath = argv[++index];
+        } else {
+            validArguments = false;
+        }
+    }
+    if (!validArguments || ((printMetrics || recordTimeline) && policies[POLICY_LOTTERY] && policies[POLICY_STRIDE])) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    for (int policy = POLICY_LOTTERY; policy <= POLICY_STRIDE; policy++) {
+        if (!policies[policy])
+            continue;
+        if (openWorkloadTrace(&trace, argv[1]) == -1)
+            return 1;
+
+        timeline recordedTimeline;
+        initTimeline(&recordedTimeline);
+        if (!printMetrics)
+            printf("%s, time quantum %llu:\n", policyName((proportionalSharePolicy)policy), timeQuantum);
+        int result = runProportionalShare(&trace, (proportionalSharePolicy)policy, timeQuantum, seed, !printMetrics,
+                reportInterval, false, recordTimeline ? &recordedTimeline : NULL, &summary);
+        closeWorkloadTrace(&trace);
+        if (result == 0 && printMetrics) {
+            printSchedulingMetrics(&summary.metrics, summary.numberOfTasks, summary.totalWaitingTime, summary.totalTime);
+        } else if (result == 0) {
+            printf("\n");
+            displaySummary(&summary);
+            printf("\n");
+        }
+        if (result == 0 && recordTimeline)
+            result = writeTimeline(&recordedTimeline, format, timelinePath);
+        destroyTimeline(&recordedTimeline);
+        if (result == -1)
+            return 1;
+    }
+    return 0;
+}
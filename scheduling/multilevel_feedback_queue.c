@@ -0,0 +1,529 @@
+// scheduling/multilevel_feedback_queue.c
+// Multi-level feedback queue(MLFQ) scheduling:
+//  - there are numberOfLevels ready queues, level 0 being the most important
+//  - the task at the head of the most important non-empty level runs(round robin within a level)
+//  - a newly arrived task enters level 0, and preempts a task running on a lower level
+//  - a task that uses up the quantum of its level is demoted one level(the last level keeps it)
+//  - every boostPeriod, every task is moved back to level 0, so that long tasks cannot starve
+//
+// Every level is a FIFO ring buffer, and a bitmap tells which levels have tasks, so picking the
+// next task is O(1). The simulation is event-driven: the clock jumps to the next quantum expiry,
+// completion, arrival(that preempts) or boost.
+//
+// Besides the usual summary, the report splits the tasks into short ones(that complete within the
+// first quantum) and long ones(that reach the last level). Short tasks show what MLFQ is for:
+// response time. Long tasks show what it costs: the longest time each one waited for the CPU in
+// one go(starvation). Several boost periods can be given to see how the two trade against each other.
+//
+// Usage: ./multilevel_feedback_queue.out                          (small demo with a full timeline)
+//        ./multilevel_feedback_queue.out <trace> [--levels numberOfLevels] [--quanta q0,q1,...]
+//               [--boost boostPeriod[,boostPeriod...]] [--metrics] [--timeline gantt|csv|json] [--timeline-output path]
+//               (replay a workload trace, summary only. A boost period of 0 never boosts. With several
+//                boost periods, the trace is replayed once per period and one row is printed for each.
+//                Without --quanta, the quantum starts at 2 and doubles at every level. Without --levels,
+//                there is one level per quantum given.)
+// gcc -o multilevel_feedback_queue.out multilevel_feedback_queue.c -lm
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "workload_trace.h"
+#include "latency_histogram.h"
+#include "scheduling_metrics.h"
+#include "timeline.h"
+
+#define MAX_LEVELS 32               // Levels are tracked in a 32-bit bitmap
+#define MAX_BOOST_PERIODS 16
+#define DEFAULT_LEVELS 3
+#define DEFAULT_BASE_QUANTUM 2
+#define DEFAULT_BOOST_PERIOD 200
+
+typedef struct {
+    unsigned int id;                    // Task ID
+    unsigned long long cpuBurstTime;    // Total CPU time required by the task
+    unsigned long long remainingTime;   // Time left for the task to finish
+    unsigned long long arrivalTime;     // Time when the task arrives in the system
+    unsigned long long startTime;       // Time when the task starts execution
+    unsigned long long endTime;         // Time when the task finishes execution
+    unsigned long long waitingTime;     // Total time the task has been waiting
+    bool started;                       // Whether the task has started running
+    unsigned int level;                 // Ready queue the task belongs to
+    unsigned long long usedQuantum;     // CPU time used at the current level
+    unsigned long long readyTime;       // When the task last became ready
+    unsigned long long longestWait;     // Longest time the task was ready without running
+} task;
+
+// One level: a ring buffer of tasks in FIFO order. The capacity is a power of two, so wrapping is a mask.
+typedef struct {
+    task* tasks;
+    unsigned int head;
+    unsigned int numberOfTasks;
+    unsigned int capacity;
+} readyQueue;
+
+typedef struct {
+    readyQueue levels[MAX_LEVELS];
+    uint32_t nonEmptyLevels;            // Bit i is set if level i has a task
+    unsigned int numberOfLevels;
+} multilevelQueue;
+
+typedef struct {
+    unsigned int numberOfLevels;
+    unsigned long long quanta[MAX_LEVELS];
+    unsigned long long boostPeriod;     // 0 never boosts
+} mlfqParameters;
+
+typedef struct {
+    unsigned long long numberOfTasks;       // Number of completed tasks
+    unsigned long long totalWaitingTime;    // Sum of the waiting time of every task
+    unsigned long long totalTime;           // Time when the last task finished
+    schedulingMetrics metrics;
+    unsigned long long numberOfDemotions;
+    unsigned long long numberOfBoosts;
+    unsigned long long completedAtLevel[MAX_LEVELS];
+    unsigned long long numberOfShortTasks;  // Completed within the quantum of level 0
+    unsigned long long totalShortTaskResponseTime;
+    latencyHistogram shortTaskResponseTimes;
+    unsigned long long numberOfLongTasks;   // Needed more than every quantum above the last level
+    unsigned long long totalLongTaskWaitingTime;
+    latencyHistogram longTaskWaitingTimes;
+    latencyHistogram longTaskLongestWaits;  // Longest single wait of every long task
+} schedulingSummary;
+
+// Function to make room for one more task in a level
+int growQueue(readyQueue* queue) {
+    if (queue->numberOfTasks < queue->capacity)
+        return 0;
+
+    // Double the buffer and unwrap the tasks to the start of it
+    unsigned int newCapacity = (queue->capacity == 0) ? 64 : queue->capacity * 2;
+    task* newTasks = malloc(newCapacity * sizeof(task));
+    if (newTasks == NULL) {
+        perror("malloc");
+        return -1;
+    }
+    for (unsigned int i = 0; i < queue->numberOfTasks; i++)
+        newTasks[i] = queue->tasks[(queue->head + i) & (queue->capacity - 1)];
+    free(queue->tasks);
+    queue->tasks = newTasks;
+    queue->head = 0;
+    queue->capacity = newCapacity;
+    return 0;
+}
+
+// Function to add a task at the tail of its level
+int enqueueTask(multilevelQueue* queue, const task* newTask) {
+    readyQueue* level = &queue->levels[newTask->level];
+    if (growQueue(level) == -1)
+        return -1;
+
+    level->tasks[(level->head + level->numberOfTasks) & (level->capacity - 1)] = *newTask;
+    level->numberOfTasks++;
+    queue->nonEmptyLevels |= 1u << newTask->level;
+    return 0;
+}
+
+// Function to add a task at the head of its level, so that a preempted task resumes before the others
+int enqueueTaskAtHead(multilevelQueue* queue, const task* preemptedTask) {
+    readyQueue* level = &queue->levels[preemptedTask->level];
+    if (growQueue(level) == -1)
+        return -1;
+
+    level->head = (level->head - 1) & (level->capacity - 1);
+    level->tasks[level->head] = *preemptedTask;
+    level->numberOfTasks++;
+    queue->nonEmptyLevels |= 1u << preemptedTask->level;
+    return 0;
+}
+
+// Function to take the task at the head of a level. Returns false if the level is empty.
+bool dequeueFromLevel(multilevelQueue* queue, unsigned int levelIndex, task* nextTask) {
+    readyQueue* level = &queue->levels[levelIndex];
+    if (level->numberOfTasks == 0)
+        return false;
+
+    *nextTask = level->tasks[level->head];
+    level->head = (level->head + 1) & (level->capacity - 1);
+    if (--level->numberOfTasks == 0)
+        queue->nonEmptyLevels &= ~(1u << levelIndex);
+    return true;
+}
+
+// Function to take the next task to run: the head of the most important non-empty level
+bool dequeueTask(multilevelQueue* queue, task* nextTask) {
+    if (queue->nonEmptyLevels == 0)
+        return false;
+    return dequeueFromLevel(queue, (unsigned int)__builtin_ctz(queue->nonEmptyLevels), nextTask);
+}
+
+void destroyMultilevelQueue(multilevelQueue* queue) {
+    for (unsigned int level = 0; level < queue->numberOfLevels; level++)
+        free(queue->levels[level].tasks);
+}
+
+// Function to move every task of the lower levels to the tail of level 0, most important level first
+int boostTasks(multilevelQueue* queue) {
+    task boostedTask;
+
+    for (unsigned int level = 1; level < queue->numberOfLevels; level++) {
+        while (dequeueFromLevel(queue, level, &boostedTask)) {
+            boostedTask.level = 0;
+            boostedTask.usedQuantum = 0;
+            if (enqueueTask(queue, &boostedTask) == -1)
+                return -1;
+        }
+    }
+    return 0;
+}
+
+// Function to move every task that has arrived by now to level 0
+int admitArrivedTasks(multilevelQueue* queue, workloadTrace* trace, unsigned long long currentTimestamp) {
+    while (hasArrivalBy(trace, currentTimestamp)) {
+        const workloadRecord* record = nextWorkloadRecord(trace);
+        task newTask = {record->id, record->cpuBurstTime, record->cpuBurstTime, record->arrivalTime, 0, 0, 0, false,
+                0, 0, record->arrivalTime, 0};
+        if (enqueueTask(queue, &newTask) == -1)
+            return -1;
+    }
+    return 0;
+}
+
+// Function to account a completed task in the summary
+void recordCompletedTask(const mlfqParameters* parameters, const task* completedTask, schedulingSummary* summary) {
+    unsigned long long aboveLastLevel = 0;
+    for (unsigned int level = 0; level + 1 < parameters->numberOfLevels; level++)
+        aboveLastLevel += parameters->quanta[level];
+
+    summary->totalWaitingTime += completedTask->waitingTime;
+    summary->totalTime = completedTask->endTime;
+    summary->completedAtLevel[completedTask->level]++;
+    recordCompletion(&summary->metrics, completedTask->arrivalTime, completedTask->startTime,
+            completedTask->endTime, completedTask->waitingTime);
+
+    if (completedTask->cpuBurstTime <= parameters->quanta[0]) {
+        unsigned long long responseTime = completedTask->startTime - completedTask->arrivalTime;
+        summary->numberOfShortTasks++;
+        summary->totalShortTaskResponseTime += responseTime;
+        recordLatency(&summary->shortTaskResponseTimes, responseTime);
+    }
+    if (parameters->numberOfLevels > 1 && completedTask->cpuBurstTime > aboveLastLevel) {
+        summary->numberOfLongTasks++;
+        summary->totalLongTaskWaitingTime += completedTask->waitingTime;
+        recordLatency(&summary->longTaskWaitingTimes, completedTask->waitingTime);
+        recordLatency(&summary->longTaskLongestWaits, completedTask->longestWait);
+    }
+}
+
+// Function to run MLFQ scheduling
+// If recordedTimeline is not NULL, every run of a task is recorded into it.
+// If finishedTasks is not NULL, every completed task is copied into it.
+int runMLFQ(workloadTrace* trace, const mlfqParameters* parameters, bool printTimeline,
+        timeline* recordedTimeline, task finishedTasks[], schedulingSummary* summary) {
+    multilevelQueue queue;
+    unsigned long long currentTimestamp = 0;
+    unsigned long long nextBoost = parameters->boostPeriod;
+    int result = 0;
+    task currentTask;
+
+    memset(&queue, 0, sizeof(queue));
+    queue.numberOfLevels = parameters->numberOfLevels;
+    memset(summary, 0, sizeof(*summary));
+    initSchedulingMetrics(&summary->metrics);
+    initLatencyHistogram(&summary->shortTaskResponseTimes);
+    initLatencyHistogram(&summary->longTaskWaitingTimes);
+    initLatencyHistogram(&summary->longTaskLongestWaits);
+
+    while (true) {
+        // Admit the tasks that have arrived by now
+        if (admitArrivedTasks(&queue, trace, currentTimestamp) == -1) {
+            result = -1;
+            break;
+        }
+
+        // Boost once the period is over. Boosts that fall into an idle gap have nothing to move.
+        if (parameters->boostPeriod > 0 && currentTimestamp >= nextBoost) {
+            if (boostTasks(&queue) == -1) {
+                result = -1;
+                break;
+            }
+            if (printTimeline)
+                printf("At timestamp %llu, every task is boosted to level 0\n", currentTimestamp);
+            summary->numberOfBoosts++;
+            nextBoost = (currentTimestamp / parameters->boostPeriod + 1) * parameters->boostPeriod;
+        }
+
+        if (!dequeueTask(&queue, &currentTask)) {
+            // Nothing is ready, so jump over the idle gap to the next arrival
+            const workloadRecord* nextArrival = peekWorkloadRecord(trace);
+            if (nextArrival == NULL)
+                break;      // Every task is completed
+            currentTimestamp = nextArrival->arrivalTime;
+            continue;
+        }
+
+        // Start the task
+        if (!currentTask.started) {
+            currentTask.started = true;
+            currentTask.startTime = currentTimestamp;
+        }
+        if (currentTimestamp - currentTask.readyTime > currentTask.longestWait)
+            currentTask.longestWait = currentTimestamp - currentTask.readyTime;
+        recordDispatch(&summary->metrics, currentTask.id);
+
+        // Run until the quantum of the level is used up or the task completes, but stop early
+        // for an arrival(which enters a more important level) or for the next boost
+        unsigned long long quantumLeft = parameters->quanta[currentTask.level] - currentTask.usedQuantum;
+        unsigned long long runTime = (currentTask.remainingTime < quantumLeft) ? currentTask.remainingTime : quantumLeft;
+        const workloadRecord* nextArrival = peekWorkloadRecord(trace);
+        if (currentTask.level > 0 && nextArrival != NULL && nextArrival->arrivalTime - currentTimestamp < runTime)
+            runTime = nextArrival->arrivalTime - currentTimestamp;
+        if (parameters->boostPeriod > 0 && nextBoost - currentTimestamp < runTime)
+            runTime = nextBoost - currentTimestamp;
+
+        if (printTimeline)
+            printf("From timestamp %llu to %llu, task %u is running at level %u\n", currentTimestamp,
+                    currentTimestamp + runTime, currentTask.id, currentTask.level);
+        if (recordedTimeline != NULL && recordRun(recordedTimeline, currentTask.id, currentTimestamp, runTime) == -1) {
+            result = -1;
+            break;
+        }
+        currentTimestamp += runTime;
+        currentTask.remainingTime -= runTime;
+        currentTask.usedQuantum += runTime;
+
+        if (currentTask.remainingTime == 0) {
+            // Every moment between the arrival and the end that the task was not running, it was waiting
+            currentTask.endTime = currentTimestamp;
+            currentTask.waitingTime = currentTask.endTime - currentTask.arrivalTime - currentTask.cpuBurstTime;
+            if (printTimeline)
+                printf("At timestamp %llu, task %u is completed\n", currentTimestamp, currentTask.id);
+
+            recordCompletedTask(parameters, &currentTask, summary);
+            if (finishedTasks != NULL)
+                finishedTasks[summary->numberOfTasks] = currentTask;
+            summary->numberOfTasks++;
+            continue;
+        }
+
+        // Tasks that arrived while this one was running are admitted before it goes back
+        if (admitArrivedTasks(&queue, trace, currentTimestamp) == -1) {
+            result = -1;
+            break;
+        }
+        currentTask.readyTime = currentTimestamp;
+        if (currentTask.usedQuantum == parameters->quanta[currentTask.level]) {
+            // The quantum is used up: one level down(the last level is plain round robin)
+            if (currentTask.level + 1 < parameters->numberOfLevels) {
+                currentTask.level++;
+                summary->numberOfDemotions++;
+                if (printTimeline)
+                    printf("At timestamp %llu, task %u is demoted to level %u\n", currentTimestamp, currentTask.id, currentTask.level);
+            }
+            currentTask.usedQuantum = 0;
+            result = enqueueTask(&queue, &currentTask);
+        } else {
+            // Preempted by an arrival or a boost, with some of its quantum left
+            result = enqueueTaskAtHead(&queue, &currentTask);
+        }
+        if (result == -1)
+            break;
+    }
+
+    destroyMultilevelQueue(&queue);
+    return result;
+}
+
+// Function to compare two tasks by their ID (for qsort)
+int compareTaskId(const void* a, const void* b) {
+    const task* taskA = a;
+    const task* taskB = b;
+    return (taskA->id > taskB->id) - (taskA->id < taskB->id);
+}
+
+// Function to display the task status information after the scheduling
+void displayTaskStatus(task tasks[], int numberOfTasks) {
+    // Tasks are stored in the order they completed. Show them in the order of their ID.
+    qsort(tasks, numberOfTasks, sizeof(task), compareTaskId);
+
+    printf("\nTaskID\tCPU Burst Time\tArrival Time\tWaiting Time\tStart Time\tEnd Time\tLevel\n");
+    for (int index = 0; index < numberOfTasks; index++) {
+        printf("%u\t%llu\t\t%llu\t\t%llu\t\t%llu\t\t%llu\t\t%u\n",
+                tasks[index].id,
+                tasks[index].cpuBurstTime,
+                tasks[index].arrivalTime,
+                tasks[index].waitingTime,
+                tasks[index].startTime,
+                tasks[index].endTime,
+                tasks[index].level);
+    }
+}
+
+// Function to display the summary of the scheduling
+void displaySummary(const mlfqParameters* parameters, const schedulingSummary* summary) {
+    if (summary->numberOfTasks == 0) {
+        printf("\nNo tasks\n");
+        return;
+    }
+    printf("\nAverage waiting time: %.2f\n", (double)summary->totalWaitingTime / summary->numberOfTasks);
+    printf("Throughput: %.2f tasks per unit time\n", (double)summary->numberOfTasks / summary->totalTime);
+    printf("Total time taken: %llu units\n", summary->totalTime);
+    printf("Demotions: %llu, boosts: %llu\n", summary->numberOfDemotions, summary->numberOfBoosts);
+    printf("Completed at level:");
+    for (unsigned int level = 0; level < parameters->numberOfLevels; level++)
+        printf(" %u: %llu", level, summary->completedAtLevel[level]);
+    printf("\n");
+    printLatencyReport(&summary->metrics);
+}
+
+// Function to display the header of the boost period table
+void displayTradeOffHeader() {
+    printf("Boost\tShort tasks\tAvg response\tp99 response\tLong tasks\tAvg waiting\tp99 waiting\tp99 longest wait\tMax longest wait\tSwitches\n");
+}
+
+// Function to display one row of the boost period table: short task response against long task starvation
+void displayTradeOff(const mlfqParameters* parameters, const schedulingSummary* summary) {
+    printf("%llu\t%llu\t\t%.2f\t\t%llu\t\t%llu\t\t%.2f\t\t%llu\t\t%llu\t\t\t%llu\t\t\t%llu\n",
+            parameters->boostPeriod,
+            summary->numberOfShortTasks,
+            summary->numberOfShortTasks > 0 ? (double)summary->totalShortTaskResponseTime / summary->numberOfShortTasks : 0.0,
+            latencyPercentile(&summary->shortTaskResponseTimes, 99),
+            summary->numberOfLongTasks,
+            summary->numberOfLongTasks > 0 ? (double)summary->totalLongTaskWaitingTime / summary->numberOfLongTasks : 0.0,
+            latencyPercentile(&summary->longTaskWaitingTimes, 99),
+            latencyPercentile(&summary->longTaskLongestWaits, 99),
+            summary->longTaskLongestWaits.maxValue,
+            summary->metrics.numberOfContextSwitches);
+}
+
+// Function to parse a comma-separated list of numbers. Returns the number of values, or -1 if invalid.
+int parseList(const char* text, unsigned long long values[], int maxValues) {
+    int numberOfValues = 0;
+    const char* current = text;
+
+    while (numberOfValues < maxValues) {
+        char* end;
+        values[numberOfValues++] = strtoull(current, &end, 10);
+        if (end == current)
+            return -1;
+        if (*end == '\0')
+            return numberOfValues;
+        if (*end != ',')
+            return -1;
+        current = end + 1;
+    }
+    return -1;
+}
+
+void printUsage(const char* program) {
+    fprintf(stderr, "Usage: %s <trace> [--levels numberOfLevels] [--quanta q0,q1,...] [--boost boostPeriod[,boostPeriod...]] "
+            "[--metrics] [--timeline gantt|csv|json] [--timeline-output path]\n", program);
+}
+
+int main(int argc, char* argv[]) {
+    mlfqParameters parameters = {DEFAULT_LEVELS, {0}, DEFAULT_BOOST_PERIOD};
+    unsigned long long boostPeriods[MAX_BOOST_PERIODS] = {DEFAULT_BOOST_PERIOD};
+    int numberOfBoostPeriods = 1;
+    int numberOfQuanta = 0;
+    bool levelsGiven = false;
+    workloadTrace trace;
+    schedulingSummary summary;
+
+    if (argc > 1) {
+        bool printMetrics = false;
+        bool recordTimeline = false;
+        bool validArguments = true;
+        timelineFormat format = TIMELINE_GANTT;
+        const char* timelinePath = NULL;
+        for (int index = 2; index < argc && validArguments; index++) {
+            if (strcmp(argv[index], "--metrics") == 0) {
+                printMetrics = true;
+            } else if (strcmp(argv[index], "--levels") == 0 && index + 1 < argc) {
+                parameters.numberOfLevels = (unsigned int)strtoul(argv[++index], NULL, 10);
+                levelsGiven = true;
+            } else if (strcmp(argv[index], "--quanta") == 0 && index + 1 < argc) {
+                numberOfQuanta = parseList(argv[++index], parameters.quanta, MAX_LEVELS);
+                validArguments = (numberOfQuanta > 0);
+            } else if (strcmp(argv[index], "--boost") == 0 && index + 1 < argc) {
+                numberOfBoostPeriods = parseList(argv[++index], boostPeriods, MAX_BOOST_PERIODS);
+                validArguments = (numberOfBoostPeriods > 0);
+            } else if (strcmp(argv[index], "--timeline") == 0 && index + 1 < argc) {
+                recordTimeline = true;
+                validArguments = (parseTimelineFormat(argv[++index], &format) == 0);
+            } else if (strcmp(argv[index], "--timeline-output") == 0 && index + 1 < argc) {
+                timelinePath = argv[++index];
+            } else {
+                validArguments = false;
+            }
+        }
+
+        // Without --levels, there is one level per quantum given.
+        // Quanta that were not given start at DEFAULT_BASE_QUANTUM and double at every level.
+        if (numberOfQuanta > 0 && !levelsGiven)
+            parameters.numberOfLevels = (unsigned int)numberOfQuanta;
+        if (validArguments && numberOfQuanta > 0 && (unsigned int)numberOfQuanta != parameters.numberOfLevels)
+            validArguments = false;
+        for (unsigned int level = 0; validArguments && level < parameters.numberOfLevels && level < MAX_LEVELS; level++) {
+            if (numberOfQuanta == 0)
+                parameters.quanta[level] = (unsigned long long)DEFAULT_BASE_QUANTUM << level;
+            validArguments = (parameters.quanta[level] > 0);
+        }
+        if (!validArguments || parameters.numberOfLevels == 0 || parameters.numberOfLevels > MAX_LEVELS ||
+                ((printMetrics || recordTimeline) && numberOfBoostPeriods > 1)) {
+            printUsage(argv[0]);
+            return 1;
+        }
+
+        if (numberOfBoostPeriods > 1)
+            displayTradeOffHeader();
+        for (int index = 0; index < numberOfBoostPeriods; index++) {
+            // Every boost period replays the trace from the start
+            if (openWorkloadTrace(&trace, argv[1]) == -1)
+                return 1;
+
+            timeline recordedTimeline;
+            initTimeline(&recordedTimeline);
+            parameters.boostPeriod = boostPeriods[index];
+            int result = runMLFQ(&trace, &parameters, false, recordTimeline ? &recordedTimeline : NULL, NULL, &summary);
+            closeWorkloadTrace(&trace);
+
+            if (result == 0 && printMetrics) {
+                printSchedulingMetrics(&summary.metrics, summary.numberOfTasks, summary.totalWaitingTime, summary.totalTime);
+            } else if (result == 0 && numberOfBoostPeriods > 1) {
+                displayTradeOff(&parameters, &summary);
+            } else if (result == 0) {
+                displaySummary(&parameters, &summary);
+                printf("\n");
+                displayTradeOffHeader();
+                displayTradeOff(&parameters, &summary);
+            }
+            if (result == 0 && recordTimeline)
+                result = writeTimeline(&recordedTimeline, format, timelinePath);
+            destroyTimeline(&recordedTimeline);
+            if (result == -1)
+                return 1;
+        }
+        return 0;
+    }
+
+    workloadRecord records[] = {
+        {.arrivalTime = 0, .cpuBurstTime = 12, .id = 1},    // A long task, demoted down to the last level
+        {.arrivalTime = 1, .cpuBurstTime = 2, .id = 2},     // Short tasks, completed at level 0
+        {.arrivalTime = 2, .cpuBurstTime = 5, .id = 3},
+        {.arrivalTime = 6, .cpuBurstTime = 1, .id = 4},
+        {.arrivalTime = 9, .cpuBurstTime = 7, .id = 5},
+        {.arrivalTime = 14, .cpuBurstTime = 2, .id = 6}
+    };
+    unsigned int numberOfTasks = sizeof(records) / sizeof(records[0]);
+    task tasks[sizeof(records) / sizeof(records[0])];
+
+    for (unsigned int level = 0; level < parameters.numberOfLevels; level++)
+        parameters.quanta[level] = (unsigned long long)DEFAULT_BASE_QUANTUM << level;
+    parameters.boostPeriod = 20;
+    openWorkloadTraceFromRecords(&trace, records, numberOfTasks);
+    runMLFQ(&trace, &parameters, true, NULL, tasks, &summary);
+    displayTaskStatus(tasks, numberOfTasks);
+    displaySummary(&parameters, &summary);
+
+    return 0;
+}
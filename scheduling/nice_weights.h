@@ -0,0 +1,95 @@
+// scheduling/nice_weights.h
+// Load weights of the nice levels, as in the kernel's sched_prio_to_weight table(kernel/sched/core.c).
+// Nice 0 has a weight of 1024, and each nice level is ~10% of CPU time apart from the next one:
+// the weight of every level is ~1.25 times the weight of the level above it.
+//
+// Like the kernel, dividing by a weight is done by multiplying with its inverse, ~2^32 / weight
+// (sched_prio_to_wmult), and shifting: calcDelta is the kernel's __calc_delta. It is integer
+// arithmetic only, so the results are the same whatever the compiler and the FPU.
+#ifndef NICE_WEIGHTS_H
+#define NICE_WEIGHTS_H
+
+#include <stdint.h>
+
+#define NICE_0_LOAD 1024    // Weight of a task with nice 0
+#define MIN_NICE -20
+#define MAX_NICE 19
+#define WMULT_CONST 0xFFFFFFFFu     // 2^32 - 1, so that the inverse of a weight of 1 fits in 32 bits
+#define WMULT_SHIFT 32
+
+static const unsigned long long prioToWeight[40] = {
+    /* -20 */     88761,     71755,     56483,     46273,     36291,
+    /* -15 */     29154,     23254,     18705,     14949,     11916,
+    /* -10 */      9548,      7620,      6100,      4904,      3906,
+    /*  -5 */      3121,      2501,      1991,      1586,      1277,
+    /*   0 */      1024,       820,       655,       526,       423,
+    /*   5 */       335,       272,       215,       172,       137,
+    /*  10 */       110,        87,        70,        56,        45,
+    /*  15 */        36,        29,        23,        18,        15,
+};
+
+// ~2^32 / prioToWeight, copied from the kernel's sched_prio_to_wmult(some entries are rounded up)
+static const uint32_t prioToWmult[40] = {
+    /* -20 */     48388,     59856,     76040,     92818,    118348,
+    /* -15 */    147320,    184698,    229616,    287308,    360437,
+    /* -10 */    449829,    563644,    704093,    875809,   1099582,
+    /*  -5 */   1376151,   1717300,   2157191,   2708050,   3363326,
+    /*   0 */   4194304,   5237765,   6557202,   8165337,  10153587,
+    /*   5 */  12820798,  15790321,  19976592,  24970740,  31350126,
+    /*  10 */  39045157,  49367440,  61356676,  76695844,  95443717,
+    /*  15 */ 119304647, 148102320, 186737708, 238609294, 286331153,
+};
+
+// Function to get the weight of a nice level. Out of range values are clamped.
+static inline unsigned long long niceToWeight(int nice) {
+    if (nice < MIN_NICE)
+        nice = MIN_NICE;
+    if (nice > MAX_NICE)
+        nice = MAX_NICE;
+    return prioToWeight[nice - MIN_NICE];
+}
+
+static inline uint32_t niceToInverseWeight(int nice) {
+    if (nice < MIN_NICE)
+        nice = MIN_NICE;
+    if (nice > MAX_NICE)
+        nice = MAX_NICE;
+    return prioToWmult[nice - MIN_NICE];
+}
+
+// Function to get the inverse of any weight, such as the shares of a task group(like __update_inv_weight)
+static inline uint32_t inverseWeight(unsigned long long weight) {
+    if (weight >= WMULT_CONST)
+        return 1;
+    return WMULT_CONST / (uint32_t)weight;
+}
+
+// Function to compute (a * mul) >> shift without losing the high bits of the product(like mul_u64_u32_shr)
+static inline uint64_t mulU64U32Shr(uint64_t a, uint32_t mul, unsigned int shift) {
+    uint64_t high = (a >> 32) * mul;
+    uint64_t low = (a & 0xFFFFFFFFu) * mul;
+    return (high << (32 - shift)) + (low >> shift);
+}
+
+// Function to compute delta * weight / the weight whose inverse is given(like the kernel's __calc_delta).
+// weight * inverse may not fit in 32 bits: the extra bits are shifted out of the factor and the shift
+// is shortened by as much.
+static inline uint64_t calcDelta(uint64_t delta, unsigned long long weight, uint32_t inverse) {
+    uint64_t factor = weight;
+    unsigned int shift = WMULT_SHIFT;
+
+    if (factor >> 32) {
+        unsigned int bits = 32 - __builtin_clz((uint32_t)(factor >> 32));
+        shift -= bits;
+        factor >>= bits;
+    }
+    factor *= inverse;
+    if (factor >> 32) {
+        unsigned int bits = 32 - __builtin_clz((uint32_t)(factor >> 32));
+        shift -= bits;
+        factor >>= bits;
+    }
+    return mulU64U32Shr(delta, (uint32_t)factor, shift);
+}
+
+#endif
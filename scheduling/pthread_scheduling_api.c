@@ -1,14 +1,67 @@
+// scheduling/pthread_scheduling_api.c
+// Without arguments: queries and sets the contention scope of a few threads.
+//
+// With options: a wake-up latency benchmark in the style of cyclictest. Every measurement thread
+// runs under the requested policy(SCHED_OTHER, SCHED_FIFO or SCHED_RR) and priority, optionally
+// pinned to a CPU, and sleeps until an absolute deadline on CLOCK_MONOTONIC, once per interval.
+// How late it wakes up(now - deadline) goes into a log-bucketed histogram(latency_histogram.h).
+// Background threads that spin under SCHED_OTHER(CPU hogs) can be added to load the CPUs.
+//
+// Usage: ./pthread_scheduling_api.out [--policy other|fifo|rr] [--priority N] [--threads N]
+//            [--interval us] [--loops N] [--affinity cpu | --spread] [--hogs N] [--histogram]
+//   e.g. sudo ./pthread_scheduling_api.out --policy fifo --priority 80 --threads 2 --spread --hogs 2
+// SCHED_FIFO and SCHED_RR need root or CAP_SYS_NICE.
+// gcc -o pthread_scheduling_api.out pthread_scheduling_api.c -lpthread
+#define _GNU_SOURCE
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
 #include <pthread.h>
+#include <sys/mman.h>
+#include "latency_histogram.h"
+
 #define NUMBER_OF_THREADS 5
+#define NANOSECONDS_PER_SECOND 1000000000ll
+
+typedef struct {
+	int policy;
+	int priority;
+	unsigned int numberOfThreads;
+	unsigned long long interval;		// Period of every measurement thread, in nanoseconds
+	unsigned long long numberOfLoops;	// Wake-ups measured by every thread
+	int affinity;				// CPU that every thread is pinned to(-1 if not pinned)
+	bool spread;				// Pin thread i to CPU i % number of CPUs
+	unsigned int numberOfHogs;
+	bool printHistogram;
+} benchmarkOptions;
+
+// What one measurement thread measured
+typedef struct {
+	const benchmarkOptions* options;
+	int cpu;				// CPU the thread is pinned to(-1 if not pinned)
+	unsigned long long minLatency;
+	unsigned long long totalLatency;
+	unsigned long long numberOfOverruns;	// Wake-ups so late that whole periods were skipped
+	latencyHistogram latencies;		// Wake-up latencies, in nanoseconds
+} measurementThread;
+
+static atomic_bool stopThreads;		// Set when the benchmark is over, or could not start
 
 void *runner (void *param) {
 	printf("Thread %ld\n", pthread_self());
 	pthread_exit(0);
 }
 
-int main(int argc, char* argv[]) {
-	int i, scope;
+// Function to query the current contention scope, and run threads with PTHREAD_SCOPE_SYSTEM
+void showContentionScope() {
+	int scope;
 	pthread_t tid[NUMBER_OF_THREADS];
 	pthread_attr_t attr;
 
@@ -38,4 +91,283 @@ int main(int argc, char* argv[]) {
 		pthread_join(tid[index], NULL);
 }
 
+static inline unsigned long long toNanoseconds(const struct timespec* time) {
+	return (unsigned long long)time->tv_sec * NANOSECONDS_PER_SECOND + time->tv_nsec;
+}
+
+static inline void addNanoseconds(struct timespec* time, unsigned long long nanoseconds) {
+	nanoseconds += time->tv_nsec;
+	time->tv_sec += nanoseconds / NANOSECONDS_PER_SECOND;
+	time->tv_nsec = nanoseconds % NANOSECONDS_PER_SECOND;
+}
+
+// Function to sleep until one deadline per interval, and record how late every wake-up is
+void *measureWakeUps(void *param) {
+	measurementThread* thread = param;
+	const benchmarkOptions* options = thread->options;
+	struct timespec deadline, now;
+
+	clock_gettime(CLOCK_MONOTONIC, &deadline);
+	for (unsigned long long loop = 0; loop < options->numberOfLoops && !atomic_load(&stopThreads); loop++) {
+		addNanoseconds(&deadline, options->interval);
+		int result;
+		while ((result = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL)) == EINTR)
+			;
+		if (result != 0) {
+			fprintf(stderr, "clock_nanosleep: %s\n", strerror(result));
+			break;
+		}
+		clock_gettime(CLOCK_MONOTONIC, &now);
+
+		unsigned long long latency = toNanoseconds(&now) - toNanoseconds(&deadline);
+		recordLatency(&thread->latencies, latency);
+		thread->totalLatency += latency;
+		if (latency < thread->minLatency)
+			thread->minLatency = latency;
+
+		// If the wake-up was later than a whole period, the next deadlines have passed already: skip them
+		while (toNanoseconds(&deadline) + options->interval <= toNanoseconds(&now)) {
+			addNanoseconds(&deadline, options->interval);
+			thread->numberOfOverruns++;
+		}
+	}
+	return NULL;
+}
+
+// Function to keep a CPU busy until the benchmark is over
+void *spin(void *param) {
+	(void)param;
+	while (!atomic_load_explicit(&stopThreads, memory_order_relaxed))
+		;
+	return NULL;
+}
+
+// Function to create a thread with a policy and priority, pinned to cpu(unless cpu is -1).
+// Returns 0 on success, or the error number.
+int createThread(pthread_t* thread, int policy, int priority, int cpu, void *(*function)(void *), void *param) {
+	pthread_attr_t attr;
+	struct sched_param schedParam = {.sched_priority = priority};
+	int result;
+
+	pthread_attr_init(&attr);
+	pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+	pthread_attr_setschedpolicy(&attr, policy);
+	pthread_attr_setschedparam(&attr, &schedParam);
+	if (cpu >= 0) {
+		cpu_set_t cpuset;
+		CPU_ZERO(&cpuset);
+		CPU_SET(cpu, &cpuset);
+		pthread_attr_setaffinity_np(&attr, sizeof(cpuset), &cpuset);
+	}
+
+	result = pthread_create(thread, &attr, function, param);
+	pthread_attr_destroy(&attr);
+	return result;
+}
+
+const char* policyName(int policy) {
+	switch (policy) {
+	case SCHED_FIFO:
+		return "SCHED_FIFO";
+	case SCHED_RR:
+		return "SCHED_RR";
+	default:
+		return "SCHED_OTHER";
+	}
+}
+
+// Function to pick the CPU of the thread with the given index(-1 if it is not pinned)
+int cpuOfThread(const benchmarkOptions* options, unsigned int index, long numberOfCpus) {
+	if (options->affinity >= 0)
+		return options->affinity;
+	if (options->spread)
+		return (int)(index % numberOfCpus);
+	return -1;
+}
+
+// Function to display the wake-up latencies of every thread and over all of them, in microseconds
+void displayLatencies(const benchmarkOptions* options, const measurementThread* threads) {
+	latencyHistogram allLatencies;
+	unsigned long long minLatency = ULLONG_MAX, totalLatency = 0, numberOfOverruns = 0;
+
+	initLatencyHistogram(&allLatencies);
+	printf("Policy: %s, priority %d, interval %llu us, %llu loops\n", policyName(options->policy),
+			options->priority, options->interval / 1000, options->numberOfLoops);
+	printf("\nThread\tCPU\tMin(us)\tAvg(us)\tp50(us)\tp99(us)\tp99.9(us)\tMax(us)\tOverruns\n");
+	for (unsigned int index = 0; index < options->numberOfThreads; index++) {
+		const measurementThread* thread = &threads[index];
+		const latencyHistogram* latencies = &thread->latencies;
+		if (latencies->numberOfValues == 0)
+			continue;
+
+		printf("%u\t%d\t%.1f\t%.1f\t%.1f\t%.1f\t%.1f\t\t%.1f\t%llu\n", index, thread->cpu,
+				thread->minLatency / 1000.0,
+				(double)thread->totalLatency / latencies->numberOfValues / 1000.0,
+				latencyPercentile(latencies, 50) / 1000.0, latencyPercentile(latencies, 99) / 1000.0,
+				latencyPercentile(latencies, 99.9) / 1000.0, latencies->maxValue / 1000.0,
+				thread->numberOfOverruns);
+
+		mergeLatencyHistogram(&allLatencies, latencies);
+		if (thread->minLatency < minLatency)
+			minLatency = thread->minLatency;
+		totalLatency += thread->totalLatency;
+		numberOfOverruns += thread->numberOfOverruns;
+	}
+	if (allLatencies.numberOfValues == 0)
+		return;
+
+	printf("All\t-\t%.1f\t%.1f\t%.1f\t%.1f\t%.1f\t\t%.1f\t%llu\n",
+			minLatency / 1000.0, (double)totalLatency / allLatencies.numberOfValues / 1000.0,
+			latencyPercentile(&allLatencies, 50) / 1000.0, latencyPercentile(&allLatencies, 99) / 1000.0,
+			latencyPercentile(&allLatencies, 99.9) / 1000.0, allLatencies.maxValue / 1000.0,
+			numberOfOverruns);
+
+	// Every non-empty bucket, as the largest latency that falls into it and how many wake-ups did
+	if (options->printHistogram) {
+		printf("\nUp to(us)\tWake-ups\n");
+		for (unsigned int bucket = 0; bucket < LATENCY_HISTOGRAM_BUCKETS; bucket++) {
+			if (allLatencies.counts[bucket] > 0)
+				printf("%.3f\t\t%llu\n", latencyBucketHighestValue(bucket) / 1000.0, allLatencies.counts[bucket]);
+		}
+	}
+}
+
+// Function to run the benchmark. Returns 0 on success, -1 on failure.
+int runBenchmark(const benchmarkOptions* options) {
+	long numberOfCpus = sysconf(_SC_NPROCESSORS_ONLN);
+	int result = 0;
+
+	if (options->affinity >= numberOfCpus) {
+		fprintf(stderr, "CPU %d does not exist(%ld CPUs online)\n", options->affinity, numberOfCpus);
+		return -1;
+	}
+
+	// A page fault during a measurement would show up as latency
+	if (options->policy != SCHED_OTHER && mlockall(MCL_CURRENT | MCL_FUTURE) == -1)
+		perror("mlockall");
+
+	measurementThread* threads = calloc(options->numberOfThreads, sizeof(measurementThread));
+	pthread_t* tids = malloc((options->numberOfThreads + options->numberOfHogs) * sizeof(pthread_t));
+	if (threads == NULL || tids == NULL) {
+		perror("malloc");
+		free(threads);
+		free(tids);
+		return -1;
+	}
+
+	// The hogs start first, so that the measurement threads compete with them from the first wake-up
+	atomic_store(&stopThreads, false);
+	unsigned int numberOfHogs = 0;
+	for (; numberOfHogs < options->numberOfHogs; numberOfHogs++) {
+		int error = createThread(&tids[options->numberOfThreads + numberOfHogs], SCHED_OTHER, 0,
+				cpuOfThread(options, numberOfHogs, numberOfCpus), spin, NULL);
+		if (error != 0) {
+			fprintf(stderr, "pthread_create: %s\n", strerror(error));
+			result = -1;
+			break;
+		}
+	}
+
+	unsigned int numberOfThreads = 0;
+	if (result == 0) {
+		for (; numberOfThreads < options->numberOfThreads; numberOfThreads++) {
+			measurementThread* thread = &threads[numberOfThreads];
+			thread->options = options;
+			thread->cpu = cpuOfThread(options, numberOfThreads, numberOfCpus);
+			thread->minLatency = ULLONG_MAX;
+			initLatencyHistogram(&thread->latencies);
+
+			int error = createThread(&tids[numberOfThreads], options->policy, options->priority, thread->cpu,
+					measureWakeUps, thread);
+			if (error != 0) {
+				if (error == EPERM)
+					fprintf(stderr, "pthread_create: %s needs root or CAP_SYS_NICE\n", policyName(options->policy));
+				else
+					fprintf(stderr, "pthread_create: %s\n", strerror(error));
+				result = -1;
+				break;
+			}
+		}
+
+		// If one thread could not be created, the others stop at their next wake-up
+		if (result == -1)
+			atomic_store(&stopThreads, true);
+		for (unsigned int index = 0; index < numberOfThreads; index++)
+			pthread_join(tids[index], NULL);
+	}
+
+	atomic_store(&stopThreads, true);
+	for (unsigned int index = 0; index < numberOfHogs; index++)
+		pthread_join(tids[options->numberOfThreads + index], NULL);
+
+	if (result == 0)
+		displayLatencies(options, threads);
+
+	free(threads);
+	free(tids);
+	return result;
+}
+
+void printUsage(const char* program) {
+	fprintf(stderr, "Usage: %s [--policy other|fifo|rr] [--priority N] [--threads N] [--interval us] [--loops N] "
+			"[--affinity cpu | --spread] [--hogs N] [--histogram]\n", program);
+}
+
+int main(int argc, char* argv[]) {
+	benchmarkOptions options = {SCHED_OTHER, 0, 1, 1000000, 10000, -1, false, 0, false};
+	bool priorityGiven = false;
+
+	if (argc == 1) {
+		showContentionScope();
+		return 0;
+	}
+
+	for (int index = 1; index < argc; index++) {
+		if (strcmp(argv[index], "--policy") == 0 && index + 1 < argc) {
+			index++;
+			if (strcmp(argv[index], "other") == 0)
+				options.policy = SCHED_OTHER;
+			else if (strcmp(argv[index], "fifo") == 0)
+				options.policy = SCHED_FIFO;
+			else if (strcmp(argv[index], "rr") == 0)
+				options.policy = SCHED_RR;
+			else {
+				printUsage(argv[0]);
+				return 1;
+			}
+		} else if (strcmp(argv[index], "--priority") == 0 && index + 1 < argc) {
+			options.priority = atoi(argv[++index]);
+			priorityGiven = true;
+		} else if (strcmp(argv[index], "--threads") == 0 && index + 1 < argc) {
+			options.numberOfThreads = (unsigned int)strtoul(argv[++index], NULL, 10);
+		} else if (strcmp(argv[index], "--interval") == 0 && index + 1 < argc) {
+			options.interval = strtoull(argv[++index], NULL, 10) * 1000;
+		} else if (strcmp(argv[index], "--loops") == 0 && index + 1 < argc) {
+			options.numberOfLoops = strtoull(argv[++index], NULL, 10);
+		} else if (strcmp(argv[index], "--affinity") == 0 && index + 1 < argc) {
+			options.affinity = atoi(argv[++index]);
+		} else if (strcmp(argv[index], "--spread") == 0) {
+			options.spread = true;
+		} else if (strcmp(argv[index], "--hogs") == 0 && index + 1 < argc) {
+			options.numberOfHogs = (unsigned int)strtoul(argv[++index], NULL, 10);
+		} else if (strcmp(argv[index], "--histogram") == 0) {
+			options.printHistogram = true;
+		} else {
+			printUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	// Real-time policies default to a high priority, SCHED_OTHER only accepts 0
+	if (!priorityGiven && options.policy != SCHED_OTHER)
+		options.priority = 80;
+	if (options.numberOfThreads == 0 || options.interval == 0 ||
+			options.priority < sched_get_priority_min(options.policy) ||
+			options.priority > sched_get_priority_max(options.policy) ||
+			(options.affinity >= 0 && options.spread)) {
+		printUsage(argv[0]);
+		return 1;
+	}
 
+	return (runBenchmark(&options) == -1) ? 1 : 0;
+}
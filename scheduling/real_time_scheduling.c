@@ -0,0 +1,764 @@
+// scheduling/real_time_scheduling.c
+// Earliest deadline first(EDF) and rate-monotonic(RM) scheduling of periodic and sporadic tasks on
+// one CPU, with offline schedulability tests and a simulation that counts the deadline misses.
+//
+// A task is given as executionTime/relativeDeadline/period(C/D/T), with D <= T. A periodic task
+// releases a job every T; a sporadic task("s:" prefix) waits at least T between two releases, and
+// a random extra delay on top. Every job needs C of CPU time and should finish within D of its release.
+//  - EDF runs the ready job with the earliest absolute deadline.
+//  - RM gives every task a fixed priority, the shorter the period the higher, and runs the ready
+//    job of the highest priority.
+// Ready jobs are kept in a binary min-heap on the absolute deadline(EDF) or on the priority(RM),
+// and the next release of every task in another one on the release time, so every decision and
+// every release is O(log n) in the number of jobs or tasks. A job that misses its deadline still
+// runs to completion; how late it finishes(tardiness) goes into a log-bucketed histogram.
+//
+// The offline tests are run before the simulation:
+//  - EDF: utilization <= 1 when every D = T, otherwise the processor demand test: at every absolute
+//    deadline t in the first busy period, the work due by t must not exceed t(exact). Above a
+//    utilization of 1, the first deadline at which the work due exceeds the time is reported.
+//  - RM: the Liu & Layland bound n(2^(1/n) - 1) and the hyperbolic bound(both sufficient, and only
+//    when every D = T), and the response time analysis(exact): R = C + sum over higher priorities
+//    of ceil(R / Tj) * Cj <= D
+// With --admit, tasks are admitted one by one, in the order given, as long as the exact test of
+// the policy still passes; the rejected ones are not simulated.
+//
+// Usage: ./real_time_scheduling.out                  (demo: a task set that EDF schedules and RM does not)
+//        ./real_time_scheduling.out [--policy edf|rm|both] [--horizon time] [--admit] [--seed seed]
+//               [--sporadic-delay fraction] [--timeline gantt|csv|json] [--timeline-output path] [s:]C/D/T[xN] ...
+//               (xN adds N identical tasks. The horizon defaults to the hyperperiod, at most MAX_DEFAULT_HORIZON.
+//                Sporadic tasks wait T plus an exponential delay of mean fraction * T, 0.5 by default.)
+// gcc -o real_time_scheduling.out real_time_scheduling.c -lm
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
+#include <math.h>
+#include "latency_histogram.h"
+#include "timeline.h"
+
+#define MAX_DEFAULT_HORIZON 100000000ull        // Longest default horizon, when the hyperperiod is longer
+#define MAX_DEMAND_CHECKPOINTS 10000000ull      // Deadlines checked by the processor demand test at most
+#define EDF_OVERLOADED (ULLONG_MAX - 1)         // The EDF test found more work than time, but no deadline within its budget
+
+typedef enum {
+    POLICY_EDF,
+    POLICY_RM
+} realTimePolicy;
+
+typedef enum {
+    PERIODIC,
+    SPORADIC
+} arrivalModel;
+
+typedef struct {
+    unsigned int id;                        // Task ID
+    unsigned long long executionTime;       // C
+    unsigned long long relativeDeadline;    // D
+    unsigned long long period;              // T(the minimum time between two releases if sporadic)
+    arrivalModel model;
+    unsigned int priority;                  // Rate-monotonic priority, 0 is the highest
+    bool admitted;
+    unsigned long long nextRelease;         // Time of the next job
+    unsigned long long numberOfJobs;        // Completed jobs
+    unsigned long long numberOfMisses;
+    unsigned long long worstResponseTime;   // Longest finish - release
+    unsigned long long maxTardiness;        // Longest finish - deadline of a missed job
+} realTimeTask;
+
+typedef struct {
+    unsigned long long key;                 // Absolute deadline(EDF) or priority(RM)
+    unsigned long long sequence;            // Order of release, to break ties
+    unsigned int taskIndex;
+    unsigned long long release;
+    unsigned long long deadline;            // Absolute deadline
+    unsigned long long remainingTime;
+} job;
+
+// Ready jobs: a binary min-heap on (key, sequence)
+typedef struct {
+    job* jobs;
+    unsigned int size;
+    unsigned int capacity;
+} jobHeap;
+
+// Next release of every task that still releases jobs before the horizon: a binary min-heap on
+// (time, task index), so tasks due at the same time release their jobs in the order given
+typedef struct {
+    unsigned long long time;
+    unsigned int taskIndex;
+} release;
+
+typedef struct {
+    release* releases;
+    unsigned int size;
+} releaseHeap;
+
+typedef struct {
+    unsigned long long numberOfJobs;        // Completed jobs
+    unsigned long long numberOfMisses;
+    long long totalLateness;                // Sum of finish - deadline, negative when early
+    latencyHistogram tardiness;             // Finish - deadline of every missed job
+    unsigned long long numberOfPreemptions;
+    unsigned long long numberOfContextSwitches;
+    unsigned long long busyTime;
+    unsigned long long totalTime;           // Time when the last job finished
+} realTimeSummary;
+
+bool isJobBefore(const job* a, const job* b) {
+    if (a->key != b->key)
+        return a->key < b->key;
+    return a->sequence < b->sequence;
+}
+
+int pushJob(jobHeap* heap, const job* newJob) {
+    if (heap->size == heap->capacity) {
+        unsigned int newCapacity = (heap->capacity == 0) ? 64 : heap->capacity * 2;
+        job* newJobs = realloc(heap->jobs, newCapacity * sizeof(job));
+        if (newJobs == NULL) {
+            perror("realloc");
+            return -1;
+        }
+        heap->jobs = newJobs;
+        heap->capacity = newCapacity;
+    }
+
+    unsigned int index = heap->size++;
+    while (index > 0) {
+        unsigned int parent = (index - 1) / 2;
+        if (!isJobBefore(newJob, &heap->jobs[parent]))
+            break;
+        heap->jobs[index] = heap->jobs[parent];
+        index = parent;
+    }
+    heap->jobs[index] = *newJob;
+    return 0;
+}
+
+void popJob(jobHeap* heap) {
+    job last = heap->jobs[--heap->size];
+    unsigned int index = 0;
+    while (true) {
+        unsigned int child = 2 * index + 1;
+        if (child >= heap->size)
+            break;
+        if (child + 1 < heap->size && isJobBefore(&heap->jobs[child + 1], &heap->jobs[child]))
+            child++;
+        if (!isJobBefore(&heap->jobs[child], &last))
+            break;
+        heap->jobs[index] = heap->jobs[child];
+        index = child;
+    }
+    if (heap->size > 0)
+        heap->jobs[index] = last;
+}
+
+bool isReleaseBefore(const release* a, const release* b) {
+    if (a->time != b->time)
+        return a->time < b->time;
+    return a->taskIndex < b->taskIndex;
+}
+
+// The heap holds at most one release per task, so it never grows past the array given to it
+void pushRelease(releaseHeap* heap, const release* newRelease) {
+    unsigned int index = heap->size++;
+    while (index > 0) {
+        unsigned int parent = (index - 1) / 2;
+        if (!isReleaseBefore(newRelease, &heap->releases[parent]))
+            break;
+        heap->releases[index] = heap->releases[parent];
+        index = parent;
+    }
+    heap->releases[index] = *newRelease;
+}
+
+// Function to replace the release at the top of the heap(or remove it if replacement is NULL)
+void replaceTopRelease(releaseHeap* heap, const release* replacement) {
+    release moved = (replacement != NULL) ? *replacement : heap->releases[--heap->size];
+    unsigned int index = 0;
+    while (true) {
+        unsigned int child = 2 * index + 1;
+        if (child >= heap->size)
+            break;
+        if (child + 1 < heap->size && isReleaseBefore(&heap->releases[child + 1], &heap->releases[child]))
+            child++;
+        if (!isReleaseBefore(&heap->releases[child], &moved))
+            break;
+        heap->releases[index] = heap->releases[child];
+        index = child;
+    }
+    if (heap->size > 0)
+        heap->releases[index] = moved;
+}
+
+unsigned long long greatestCommonDivisor(unsigned long long a, unsigned long long b) {
+    while (b != 0) {
+        unsigned long long remainder = a % b;
+        a = b;
+        b = remainder;
+    }
+    return a;
+}
+
+// Function to find the hyperperiod(least common multiple of the periods), or 0 if it exceeds limit
+unsigned long long hyperperiod(const realTimeTask tasks[], unsigned int numberOfTasks, unsigned long long limit) {
+    unsigned long long result = 1;
+    for (unsigned int index = 0; index < numberOfTasks; index++) {
+        if (!tasks[index].admitted)
+            continue;
+        unsigned long long factor = tasks[index].period / greatestCommonDivisor(result, tasks[index].period);
+        if (result > limit / factor)
+            return 0;
+        result *= factor;
+    }
+    return result;
+}
+
+// Function to give every task its rate-monotonic priority: by period, then in the order given
+void assignRateMonotonicPriorities(realTimeTask tasks[], unsigned int numberOfTasks) {
+    for (unsigned int index = 0; index < numberOfTasks; index++) {
+        tasks[index].priority = 0;
+        for (unsigned int other = 0; other < numberOfTasks; other++) {
+            if (tasks[other].period < tasks[index].period || (tasks[other].period == tasks[index].period && other < index))
+                tasks[index].priority++;
+        }
+    }
+}
+
+double utilization(const realTimeTask tasks[], unsigned int numberOfTasks) {
+    double total = 0;
+    for (unsigned int index = 0; index < numberOfTasks; index++) {
+        if (tasks[index].admitted)
+            total += (double)tasks[index].executionTime / tasks[index].period;
+    }
+    return total;
+}
+
+// Function to find the worst-case response time of a task under RM(response time analysis).
+// Returns 0 if it exceeds the deadline of the task.
+unsigned long long responseTime(const realTimeTask tasks[], unsigned int numberOfTasks, unsigned int taskIndex) {
+    const realTimeTask* analyzed = &tasks[taskIndex];
+    unsigned long long response = analyzed->executionTime, previous = 0;
+
+    while (response != previous) {
+        if (response > analyzed->relativeDeadline)
+            return 0;
+        previous = response;
+        response = analyzed->executionTime;
+        for (unsigned int index = 0; index < numberOfTasks; index++) {
+            const realTimeTask* other = &tasks[index];
+            if (other->admitted && index != taskIndex && other->priority < analyzed->priority)
+                response += (previous + other->period - 1) / other->period * other->executionTime;
+        }
+    }
+    return response;
+}
+
+// Function to run the response time analysis on every task. Returns the index of the first task
+// that can miss its deadline, or -1 if none can.
+int rateMonotonicTest(const realTimeTask tasks[], unsigned int numberOfTasks) {
+    for (unsigned int index = 0; index < numberOfTasks; index++) {
+        if (tasks[index].admitted && responseTime(tasks, numberOfTasks, index) == 0)
+            return (int)index;
+    }
+    return -1;
+}
+
+// Function to compute the work of the jobs that are released at 0 or later and due by time(demand bound)
+unsigned long long processorDemand(const realTimeTask tasks[], unsigned int numberOfTasks, unsigned long long time) {
+    unsigned long long demand = 0;
+    for (unsigned int index = 0; index < numberOfTasks; index++) {
+        const realTimeTask* task = &tasks[index];
+        if (task->admitted && time >= task->relativeDeadline)
+            demand += ((time - task->relativeDeadline) / task->period + 1) * task->executionTime;
+    }
+    return demand;
+}
+
+// Function to find the first absolute deadline up to limit at which the demand exceeds the time.
+// Returns 0 if there is none, or ULLONG_MAX if there are too many deadlines to check.
+unsigned long long firstDemandViolation(const realTimeTask tasks[], unsigned int numberOfTasks, unsigned long long limit) {
+    unsigned long long numberOfCheckpoints = 0, checkpoint = 0;
+    while (true) {
+        unsigned long long nextCheckpoint = ULLONG_MAX;
+        for (unsigned int index = 0; index < numberOfTasks; index++) {
+            const realTimeTask* task = &tasks[index];
+            if (!task->admitted)
+                continue;
+            unsigned long long deadline = task->relativeDeadline;
+            if (checkpoint >= deadline)
+                deadline += ((checkpoint - deadline) / task->period + 1) * task->period;
+            if (deadline < nextCheckpoint)
+                nextCheckpoint = deadline;
+        }
+        if (nextCheckpoint == ULLONG_MAX || nextCheckpoint > limit)
+            return 0;
+        if (++numberOfCheckpoints > MAX_DEMAND_CHECKPOINTS)
+            return ULLONG_MAX;
+        checkpoint = nextCheckpoint;
+        if (processorDemand(tasks, numberOfTasks, checkpoint) > checkpoint)
+            return checkpoint;
+    }
+}
+
+// Function to run the EDF test. Returns the first absolute deadline at which the demand exceeds
+// the time, 0 if there is none, ULLONG_MAX if it could not be decided, or EDF_OVERLOADED if the
+// utilization is above 1 but the first deadline missed is too far to find.
+unsigned long long earliestDeadlineFirstTest(const realTimeTask tasks[], unsigned int numberOfTasks) {
+    double totalUtilization = utilization(tasks, numberOfTasks);
+    bool implicitDeadlines = true;
+    for (unsigned int index = 0; index < numberOfTasks; index++) {
+        if (tasks[index].admitted && tasks[index].relativeDeadline != tasks[index].period)
+            implicitDeadlines = false;
+    }
+
+    // Exact with rational arithmetic: the demand of every hyperperiod must fit in it
+    unsigned long long executionInHyperperiod = 0, length = hyperperiod(tasks, numberOfTasks, ULLONG_MAX / 2);
+    for (unsigned int index = 0; length != 0 && index < numberOfTasks && executionInHyperperiod <= length; index++) {
+        if (tasks[index].admitted)
+            executionInHyperperiod += length / tasks[index].period * tasks[index].executionTime;
+    }
+    bool overloaded = (length != 0) ? executionInHyperperiod > length : totalUtilization > 1.0;
+    if (overloaded) {
+        // The demand outgrows the time, so some deadline is missed: find the first one
+        unsigned long long missedDeadline = firstDemandViolation(tasks, numberOfTasks, ULLONG_MAX);
+        return (missedDeadline == 0 || missedDeadline == ULLONG_MAX) ? EDF_OVERLOADED : missedDeadline;
+    }
+    if (implicitDeadlines)
+        return 0;
+
+    // Every deadline miss shows up in the first busy period: w = sum of ceil(w / T) * C
+    unsigned long long busyPeriod = 0, next = 0, numberOfIterations = 0;
+    for (unsigned int index = 0; index < numberOfTasks; index++) {
+        if (tasks[index].admitted)
+            next += tasks[index].executionTime;
+    }
+    while (next != busyPeriod) {
+        busyPeriod = next;
+        next = 0;
+        for (unsigned int index = 0; index < numberOfTasks; index++) {
+            if (tasks[index].admitted)
+                next += (busyPeriod + tasks[index].period - 1) / tasks[index].period * tasks[index].executionTime;
+        }
+        if (length != 0 && next > length)
+            break;      // Cannot be longer than the hyperperiod when the utilization is at most 1
+        if (++numberOfIterations > MAX_DEMAND_CHECKPOINTS)
+            return ULLONG_MAX;
+    }
+    if (length != 0 && busyPeriod > length)
+        busyPeriod = length;
+
+    // Check the absolute deadlines up to the end of the busy period, in increasing order
+    return firstDemandViolation(tasks, numberOfTasks, busyPeriod);
+}
+
+// Function to check whether the admitted tasks pass the exact test of a policy
+bool isSchedulable(const realTimeTask tasks[], unsigned int numberOfTasks, realTimePolicy policy) {
+    if (policy == POLICY_RM)
+        return rateMonotonicTest(tasks, numberOfTasks) == -1;
+    return earliestDeadlineFirstTest(tasks, numberOfTasks) == 0;
+}
+
+// Function to admit the tasks in the order given, as long as the set stays schedulable
+void admitTasks(realTimeTask tasks[], unsigned int numberOfTasks, realTimePolicy policy) {
+    for (unsigned int index = 0; index < numberOfTasks; index++)
+        tasks[index].admitted = false;
+    for (unsigned int index = 0; index < numberOfTasks; index++) {
+        tasks[index].admitted = true;
+        if (!isSchedulable(tasks, numberOfTasks, policy))
+            tasks[index].admitted = false;
+    }
+}
+
+// Function to display the offline tests of both policies
+void displayAnalysis(const realTimeTask tasks[], unsigned int numberOfTasks) {
+    unsigned int numberOfAdmittedTasks = 0;
+    double hyperbolicProduct = 1, density = 0;
+    bool implicitDeadlines = true;      // The utilization bounds only hold when every D = T
+
+    printf("Task\tC\tD\tT\tModel\t\tUtilization\tRM priority\tRM response time\n");
+    for (unsigned int index = 0; index < numberOfTasks; index++) {
+        const realTimeTask* task = &tasks[index];
+        if (!task->admitted)
+            continue;
+        unsigned long long response = responseTime(tasks, numberOfTasks, index);
+        numberOfAdmittedTasks++;
+        hyperbolicProduct *= 1 + (double)task->executionTime / task->period;
+        density += (double)task->executionTime / task->relativeDeadline;
+        if (task->relativeDeadline != task->period)
+            implicitDeadlines = false;
+
+        printf("%u\t%llu\t%llu\t%llu\t%s\t%.4f\t\t%u\t\t", task->id, task->executionTime, task->relativeDeadline,
+                task->period, task->model == SPORADIC ? "sporadic" : "periodic",
+                (double)task->executionTime / task->period, task->priority);
+        if (response == 0)
+            printf("> D(miss)\n");
+        else
+            printf("%llu\n", response);
+    }
+
+    double totalUtilization = utilization(tasks, numberOfTasks);
+    double liuLaylandBound = numberOfAdmittedTasks * (pow(2.0, 1.0 / numberOfAdmittedTasks) - 1);
+    printf("\nUtilization: %.4f, density: %.4f\n", totalUtilization, density);
+    if (implicitDeadlines) {
+        printf("RM, Liu & Layland bound %.4f: %s\n", liuLaylandBound,
+                totalUtilization <= liuLaylandBound ? "schedulable" : "not guaranteed");
+        printf("RM, hyperbolic bound(product of U + 1 = %.4f <= 2): %s\n", hyperbolicProduct,
+                hyperbolicProduct <= 2.0 ? "schedulable" : "not guaranteed");
+    } else {
+        printf("RM, Liu & Layland bound %.4f: not applicable(D < T)\n", liuLaylandBound);
+        printf("RM, hyperbolic bound: not applicable(D < T)\n");
+    }
+
+    int missingTask = rateMonotonicTest(tasks, numberOfTasks);
+    if (missingTask == -1)
+        printf("RM, response time analysis: schedulable\n");
+    else
+        printf("RM, response time analysis: not schedulable(task %u can miss its deadline)\n", tasks[missingTask].id);
+
+    unsigned long long missedDeadline = earliestDeadlineFirstTest(tasks, numberOfTasks);
+    if (missedDeadline == 0)
+        printf("EDF, processor demand: schedulable\n");
+    else if (missedDeadline == ULLONG_MAX)
+        printf("EDF, processor demand: undecided(more than %llu deadlines to check)\n", MAX_DEMAND_CHECKPOINTS);
+    else if (missedDeadline == EDF_OVERLOADED)
+        printf("EDF, processor demand: not schedulable(utilization > 1)\n");
+    else
+        printf("EDF, processor demand: not schedulable(more work is due by %llu than fits)\n", missedDeadline);
+}
+
+// Function to get the next random number(xorshift64*)
+unsigned long long nextRandom(unsigned long long* state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545F4914F6CDD1Dull;
+}
+
+// Function to draw the extra delay of a sporadic release: exponential, of mean meanDelay
+unsigned long long drawSporadicDelay(unsigned long long* randomState, double meanDelay) {
+    double uniform = ((nextRandom(randomState) >> 11) + 1) * (1.0 / 9007199254740992.0);
+    return (unsigned long long)(-meanDelay * log(uniform));
+}
+
+// Function to release the jobs that are due by now. A task whose next release is at the horizon or
+// later leaves the release heap.
+int releaseJobs(realTimeTask tasks[], realTimePolicy policy, releaseHeap* releases, jobHeap* readyJobs,
+        unsigned long long currentTimestamp, unsigned long long horizon, unsigned long long* sequence,
+        unsigned long long* randomState, double sporadicDelay) {
+    while (releases->size > 0 && releases->releases[0].time <= currentTimestamp) {
+        unsigned int index = releases->releases[0].taskIndex;
+        realTimeTask* task = &tasks[index];
+        job newJob;
+        newJob.deadline = task->nextRelease + task->relativeDeadline;
+        newJob.key = (policy == POLICY_EDF) ? newJob.deadline : task->priority;
+        newJob.sequence = (*sequence)++;
+        newJob.taskIndex = index;
+        newJob.release = task->nextRelease;
+        newJob.remainingTime = task->executionTime;
+        if (pushJob(readyJobs, &newJob) == -1)
+            return -1;
+
+        task->nextRelease += task->period;
+        if (task->model == SPORADIC)
+            task->nextRelease += drawSporadicDelay(randomState, sporadicDelay * task->period);
+        release nextRelease = {task->nextRelease, index};
+        replaceTopRelease(releases, task->nextRelease < horizon ? &nextRelease : NULL);
+    }
+    return 0;
+}
+
+// Function to simulate a policy from time 0(every task releases its first job at 0) until the horizon.
+// Jobs released before the horizon run to completion. Returns 0 on success, -1 on failure.
+int runRealTime(realTimeTask tasks[], unsigned int numberOfTasks, realTimePolicy policy, unsigned long long horizon,
+        unsigned long long seed, double sporadicDelay, bool printTimeline, timeline* recordedTimeline, realTimeSummary* summary) {
+    jobHeap readyJobs = {NULL, 0, 0};
+    releaseHeap releases = {malloc(numberOfTasks * sizeof(release)), 0};
+    unsigned long long currentTimestamp = 0, sequence = 0, randomState = seed | 1;
+    unsigned long long lastSequence = ULLONG_MAX;     // Job that ran last
+    unsigned long long lastDeadline = 0, segmentStart = 0;
+    unsigned int lastTaskId = 0;
+    bool lastJobUnfinished = false;
+    int result = 0;
+
+    if (releases.releases == NULL) {
+        perror("malloc");
+        return -1;
+    }
+    memset(summary, 0, sizeof(*summary));
+    initLatencyHistogram(&summary->tardiness);
+    for (unsigned int index = 0; index < numberOfTasks; index++) {
+        tasks[index].nextRelease = 0;
+        tasks[index].numberOfJobs = 0;
+        tasks[index].numberOfMisses = 0;
+        tasks[index].worstResponseTime = 0;
+        tasks[index].maxTardiness = 0;
+        if (tasks[index].admitted && horizon > 0) {
+            release firstRelease = {0, index};
+            pushRelease(&releases, &firstRelease);
+        }
+    }
+
+    while (true) {
+        if (releaseJobs(tasks, policy, &releases, &readyJobs, currentTimestamp, horizon, &sequence,
+                &randomState, sporadicDelay) == -1) {
+            result = -1;
+            break;
+        }
+
+        // The time of the next release before the horizon(ULLONG_MAX if there is none)
+        unsigned long long nextRelease = (releases.size > 0) ? releases.releases[0].time : ULLONG_MAX;
+        if (readyJobs.size == 0) {
+            if (nextRelease == ULLONG_MAX)
+                break;      // Every job is completed
+            currentTimestamp = nextRelease;
+            continue;
+        }
+
+        // The job at the top runs until it completes or the next release, which may preempt it
+        job* runningJob = &readyJobs.jobs[0];
+        realTimeTask* task = &tasks[runningJob->taskIndex];
+        if (runningJob->sequence != lastSequence) {
+            summary->numberOfContextSwitches++;
+            if (lastJobUnfinished) {
+                summary->numberOfPreemptions++;
+                if (printTimeline)
+                    printf("From timestamp %llu to %llu, task %u(deadline %llu) is running\n", segmentStart,
+                            currentTimestamp, lastTaskId, lastDeadline);
+            }
+            segmentStart = currentTimestamp;
+        }
+        lastSequence = runningJob->sequence;
+        lastTaskId = task->id;
+        lastDeadline = runningJob->deadline;
+
+        unsigned long long runTime = runningJob->remainingTime;
+        if (nextRelease != ULLONG_MAX && nextRelease - currentTimestamp < runTime)
+            runTime = nextRelease - currentTimestamp;
+        if (recordedTimeline != NULL && recordRun(recordedTimeline, task->id, currentTimestamp, runTime) == -1) {
+            result = -1;
+            break;
+        }
+        currentTimestamp += runTime;
+        summary->busyTime += runTime;
+        runningJob->remainingTime -= runTime;
+        lastJobUnfinished = (runningJob->remainingTime > 0);
+        if (lastJobUnfinished)
+            continue;
+
+        // The job is completed: did it meet its deadline?
+        if (printTimeline)
+            printf("From timestamp %llu to %llu, task %u(deadline %llu) is running\n", segmentStart,
+                    currentTimestamp, task->id, runningJob->deadline);
+        long long lateness = (long long)(currentTimestamp - runningJob->deadline);
+        unsigned long long response = currentTimestamp - runningJob->release;
+        task->numberOfJobs++;
+        if (response > task->worstResponseTime)
+            task->worstResponseTime = response;
+        summary->numberOfJobs++;
+        summary->totalLateness += lateness;
+        summary->totalTime = currentTimestamp;
+        if (lateness > 0) {
+            if (printTimeline)
+                printf("At timestamp %llu, task %u misses its deadline by %lld\n", currentTimestamp, task->id, lateness);
+            task->numberOfMisses++;
+            if ((unsigned long long)lateness > task->maxTardiness)
+                task->maxTardiness = (unsigned long long)lateness;
+            summary->numberOfMisses++;
+            recordLatency(&summary->tardiness, (unsigned long long)lateness);
+        }
+        popJob(&readyJobs);
+    }
+
+    free(readyJobs.jobs);
+    free(releases.releases);
+    return result;
+}
+
+const char* policyName(realTimePolicy policy) {
+    return (policy == POLICY_EDF) ? "EDF" : "RM";
+}
+
+// Function to display the deadline misses of a simulation, per task and over every job
+void displayRealTimeSummary(realTimePolicy policy, const realTimeTask tasks[], unsigned int numberOfTasks,
+        unsigned long long horizon, const realTimeSummary* summary) {
+    printf("\n%s, horizon %llu:\n", policyName(policy), horizon);
+    printf("Task\tJobs\tMisses\tMiss ratio\tWorst response\tMax tardiness\n");
+    for (unsigned int index = 0; index < numberOfTasks; index++) {
+        const realTimeTask* task = &tasks[index];
+        if (!task->admitted) {
+            printf("%u\trejected\n", task->id);
+            continue;
+        }
+        printf("%u\t%llu\t%llu\t%.4f\t\t%llu\t\t%llu\n", task->id, task->numberOfJobs, task->numberOfMisses,
+                task->numberOfJobs > 0 ? (double)task->numberOfMisses / task->numberOfJobs : 0.0,
+                task->worstResponseTime, task->maxTardiness);
+    }
+
+    printf("Deadline misses: %llu of %llu jobs(miss ratio %.4f)\n", summary->numberOfMisses, summary->numberOfJobs,
+            summary->numberOfJobs > 0 ? (double)summary->numberOfMisses / summary->numberOfJobs : 0.0);
+    printf("Average lateness: %.2f\n", summary->numberOfJobs > 0 ? (double)summary->totalLateness / summary->numberOfJobs : 0.0);
+    printf("Tardiness of the missed jobs p50/p90/p99/max: %llu / %llu / %llu / %llu\n",
+            latencyPercentile(&summary->tardiness, 50), latencyPercentile(&summary->tardiness, 90),
+            latencyPercentile(&summary->tardiness, 99), summary->tardiness.maxValue);
+    printf("Preemptions: %llu, context switches: %llu\n", summary->numberOfPreemptions, summary->numberOfContextSwitches);
+    printf("CPU utilization: %.4f\n", summary->totalTime > 0 ? (double)summary->busyTime / summary->totalTime : 0.0);
+}
+
+// Function to parse [s:]C/D/T[xN] into count tasks. Returns 0 on success, -1 on failure.
+int parseTask(const char* argument, realTimeTask* task, unsigned int* count) {
+    unsigned long long executionTime, relativeDeadline, period;
+    int length = 0;
+
+    memset(task, 0, sizeof(*task));
+    task->model = PERIODIC;
+    task->admitted = true;
+    if (strncmp(argument, "s:", 2) == 0) {
+        task->model = SPORADIC;
+        argument += 2;
+    }
+
+    *count = 1;
+    if (sscanf(argument, "%llu/%llu/%llu%n", &executionTime, &relativeDeadline, &period, &length) != 3)
+        return -1;
+    if (argument[length] == 'x') {
+        char* end;
+        *count = (unsigned int)strtoul(argument + length + 1, &end, 10);
+        if (*end != '\0')
+            return -1;
+    } else if (argument[length] != '\0') {
+        return -1;
+    }
+    if (executionTime == 0 || executionTime > relativeDeadline || relativeDeadline > period || *count == 0)
+        return -1;
+
+    task->executionTime = executionTime;
+    task->relativeDeadline = relativeDeadline;
+    task->period = period;
+    return 0;
+}
+
+// Function to analyze and simulate a task set under one policy, or both
+int runTaskSet(realTimeTask tasks[], unsigned int numberOfTasks, bool policies[2], bool admit,
+        unsigned long long horizon, unsigned long long seed, double sporadicDelay, bool printTimeline,
+        bool recordTimeline, timelineFormat format, const char* timelinePath) {
+    assignRateMonotonicPriorities(tasks, numberOfTasks);
+    displayAnalysis(tasks, numberOfTasks);
+
+    for (int policy = POLICY_EDF; policy <= POLICY_RM; policy++) {
+        if (!policies[policy])
+            continue;
+
+        if (admit) {
+            admitTasks(tasks, numberOfTasks, (realTimePolicy)policy);
+            printf("\n%s admits:", policyName((realTimePolicy)policy));
+            for (unsigned int index = 0; index < numberOfTasks; index++) {
+                if (tasks[index].admitted)
+                    printf(" %u", tasks[index].id);
+            }
+            printf("(utilization %.4f)\n", utilization(tasks, numberOfTasks));
+        }
+
+        unsigned long long runHorizon = horizon;
+        if (runHorizon == 0) {
+            runHorizon = hyperperiod(tasks, numberOfTasks, MAX_DEFAULT_HORIZON);
+            if (runHorizon == 0)
+                runHorizon = MAX_DEFAULT_HORIZON;
+        }
+
+        realTimeSummary summary;
+        timeline recordedTimeline;
+        initTimeline(&recordedTimeline);
+        if (printTimeline)
+            printf("\nTimeline of %s:\n", policyName((realTimePolicy)policy));
+        int result = runRealTime(tasks, numberOfTasks, (realTimePolicy)policy, runHorizon, seed, sporadicDelay,
+                printTimeline, recordTimeline ? &recordedTimeline : NULL, &summary);
+        if (result == 0)
+            displayRealTimeSummary((realTimePolicy)policy, tasks, numberOfTasks, runHorizon, &summary);
+        if (result == 0 && recordTimeline)
+            result = writeTimeline(&recordedTimeline, format, timelinePath);
+        destroyTimeline(&recordedTimeline);
+        if (result == -1)
+            return -1;
+    }
+    return 0;
+}
+
+void printUsage(const char* program) {
+    fprintf(stderr, "Usage: %s [--policy edf|rm|both] [--horizon time] [--admit] [--seed seed] [--sporadic-delay fraction] "
+            "[--timeline gantt|csv|json] [--timeline-output path] [s:]C/D/T[xN] ...\n", program);
+}
+
+int main(int argc, char* argv[]) {
+    bool policies[2] = {true, true};
+    bool admit = false, recordTimeline = false;
+    unsigned long long horizon = 0, seed = 42;
+    double sporadicDelay = 0.5;
+    timelineFormat format = TIMELINE_GANTT;
+    const char* timelinePath = NULL;
+    realTimeTask* tasks = NULL;
+    unsigned int numberOfTasks = 0;
+
+    if (argc == 1) {
+        // U = 0.25 + 0.33 + 0.375 = 0.96: above the RM bound, and RM misses deadlines of task 3, but not above 1
+        realTimeTask demoTasks[] = {
+            {1, 1, 4, 4, PERIODIC, 0, true, 0, 0, 0, 0, 0},
+            {2, 2, 6, 6, PERIODIC, 0, true, 0, 0, 0, 0, 0},
+            {3, 3, 8, 8, PERIODIC, 0, true, 0, 0, 0, 0, 0}
+        };
+        return runTaskSet(demoTasks, sizeof(demoTasks) / sizeof(demoTasks[0]), policies, false, 0, seed,
+                sporadicDelay, true, false, format, NULL) == 0 ? 0 : 1;
+    }
+
+    bool validArguments = true;
+    for (int index = 1; index < argc && validArguments; index++) {
+        if (strcmp(argv[index], "--policy") == 0 && index + 1 < argc) {
+            index++;
+            policies[POLICY_EDF] = (strcmp(argv[index], "edf") == 0 || strcmp(argv[index], "both") == 0);
+            policies[POLICY_RM] = (strcmp(argv[index], "rm") == 0 || strcmp(argv[index], "both") == 0);
+            validArguments = (policies[POLICY_EDF] || policies[POLICY_RM]);
+        } else if (strcmp(argv[index], "--horizon") == 0 && index + 1 < argc) {
+            horizon = strtoull(argv[++index], NULL, 10);
+        } else if (strcmp(argv[index], "--admit") == 0) {
+            admit = true;
+        } else if (strcmp(argv[index], "--seed") == 0 && index + 1 < argc) {
+            seed = strtoull(argv[++index], NULL, 10);
+        } else if (strcmp(argv[index], "--sporadic-delay") == 0 && index + 1 < argc) {
+            sporadicDelay = strtod(argv[++index], NULL);
+            validArguments = (sporadicDelay >= 0);
+        } else if (strcmp(argv[index], "--timeline") == 0 && index + 1 < argc) {
+            recordTimeline = true;
+            validArguments = (parseTimelineFormat(argv[++index], &format) == 0);
+        } else if (strcmp(argv[index], "--timeline-output") == 0 && index + 1 < argc) {
+            timelinePath = argv[++index];
+        } else {
+            realTimeTask task;
+            unsigned int count;
+            validArguments = (parseTask(argv[index], &task, &count) == 0);
+            realTimeTask* newTasks = validArguments ? realloc(tasks, (numberOfTasks + count) * sizeof(realTimeTask)) : NULL;
+            if (validArguments && newTasks == NULL) {
+                perror("realloc");
+                free(tasks);
+                return 1;
+            }
+            for (unsigned int copy = 0; validArguments && copy < count; copy++) {
+                tasks = newTasks;
+                tasks[numberOfTasks] = task;
+                tasks[numberOfTasks].id = numberOfTasks + 1;
+                numberOfTasks++;
+            }
+        }
+    }
+    if (!validArguments || numberOfTasks == 0 || (recordTimeline && policies[POLICY_EDF] && policies[POLICY_RM])) {
+        printUsage(argv[0]);
+        free(tasks);
+        return 1;
+    }
+
+    int result = runTaskSet(tasks, numberOfTasks, policies, admit, horizon, seed, sporadicDelay, false,
+            recordTimeline, format, timelinePath);
+    free(tasks);
+    return (result == 0) ? 0 : 1;
+}
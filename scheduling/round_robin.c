@@ -1,132 +1,646 @@
 // scheduling/round_robin.c
+// The simulation is event-driven: the clock jumps straight to the next quantum expiry,
+// completion or arrival instead of moving one tick at a time.
+// Tasks are streamed from a workload trace, and only the tasks that have arrived but not
+// completed are kept in memory, in a FIFO ready queue.
+//
+// With more than one CPU, every CPU has its own runqueue and runs on its own host thread, and the
+// runqueues are balanced every --balance-interval units(see load_balance.h).
+// On one CPU, switching to another task can cost time(see switch_cost.h): the clock moves past
+// the cost before the task runs, so small quanta lose more and more of the CPU to switching.
+//
+// Usage: ./round_robin.out                          (small demo with a full timeline)
+//        ./round_robin.out <trace> [numberOfCpus] [--quantum timeQuantum] [--balance-interval interval] [--metrics]
+//               [--timeline gantt|csv|json] [--timeline-output path]
+//               [--switch-cost ns] [--refill-cost ns] [--warmth-decay ns] [--unit-length ns]
+//               [--calibrate [--working-set bytes]]
+//               (replay a workload trace, summary only. --metrics prints one line of key=value pairs
+//                instead, over every CPU. --timeline records the runs and renders them once the
+//                simulation is over(see timeline.h), on one CPU. The switch cost options charge
+//                every context switch, on one CPU, and --calibrate measures the costs on this host.)
+// gcc -o round_robin.out round_robin.c -lpthread -lm
+#define _GNU_SOURCE
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <stdbool.h>
+#include <pthread.h>
+#include "workload_trace.h"
+#include "latency_histogram.h"
+#include "scheduling_metrics.h"
+#include "timeline.h"
+#include "switch_cost.h"
+#include "load_balance.h"
 
 typedef struct {
-	unsigned int id;		// Task ID
-	unsigned int cpuBurstTime;	// CPU burst time
-	unsigned int remainingTime;	// Remaining time
-	unsigned int arrivalTime;	// Arrival time (when the task arrives to the queue)
-	unsigned int startTime;		// Start time
-	unsigned int endTime;		// End time
-	unsigned int waitingTime;	// Waiting time
+	unsigned int id;			// Task ID
+	unsigned long long cpuBurstTime;	// CPU burst time
+	unsigned long long remainingTime;	// Remaining time
+	unsigned long long arrivalTime;		// Arrival time (when the task arrives to the queue)
+	unsigned long long startTime;		// Start time
+	unsigned long long endTime;		// End time
+	unsigned long long waitingTime;		// Waiting time
 	bool started;
+	unsigned long long readyTime;		// When the task joined its current ready queue
+	unsigned long long lastRunEnd;		// When the task last left the CPU
 } task;
 
-// Function to get the next task index in the RR(Round Robin)
-int getNextTask(task tasks[], unsigned int numberOfTasks, unsigned int currentTimestamp, unsigned int lastTaskIndex) {
-	for (unsigned int i = 0; i < numberOfTasks; i++) {
-		unsigned int index = (lastTaskIndex + i + 1) % numberOfTasks;
-		if (tasks[index].arrivalTime <= currentTimestamp && tasks[index].remainingTime > 0) {
-			return index;
+// Ready queue: a ring buffer of tasks in FIFO order. Newly arrived tasks and tasks whose quantum
+// has expired both join at the tail, and the next task to run is always at the head, so every
+// dispatch is O(1) no matter how many tasks there are.
+typedef struct {
+	task* tasks;
+	unsigned int head;		// Index of the first task
+	unsigned int numberOfTasks;
+	unsigned int capacity;		// Always a power of two, so wrapping around is a mask
+} readyQueue;
+
+typedef struct {
+	unsigned long long numberOfTasks;	// Number of completed tasks
+	unsigned long long totalWaitingTime;	// Sum of the waiting time of every task
+	unsigned long long totalTime;		// Time when the last task finished
+	schedulingMetrics metrics;
+} schedulingSummary;
+
+// Function to add a task at the tail of the ready queue
+int enqueueTask(readyQueue* queue, const task* newTask) {
+	if (queue->numberOfTasks == queue->capacity) {
+		// Double the buffer and unwrap the tasks to the start of it
+		unsigned int newCapacity = (queue->capacity == 0) ? 64 : queue->capacity * 2;
+		task* newTasks = malloc(newCapacity * sizeof(task));
+		if (newTasks == NULL) {
+			perror("malloc");
+			return -1;
 		}
+		for (unsigned int i = 0; i < queue->numberOfTasks; i++)
+			newTasks[i] = queue->tasks[(queue->head + i) & (queue->capacity - 1)];
+		free(queue->tasks);
+		queue->tasks = newTasks;
+		queue->head = 0;
+		queue->capacity = newCapacity;
 	}
-	return -1;
+
+	queue->tasks[(queue->head + queue->numberOfTasks) & (queue->capacity - 1)] = *newTask;
+	queue->numberOfTasks++;
+	return 0;
+}
+
+// Function to take the task at the head of the ready queue. Returns false if the queue is empty.
+bool dequeueTask(readyQueue* queue, task* nextTask) {
+	if (queue->numberOfTasks == 0)
+		return false;
+	*nextTask = queue->tasks[queue->head];
+	queue->head = (queue->head + 1) & (queue->capacity - 1);
+	queue->numberOfTasks--;
+	return true;
+}
+
+// Function to take the task at the tail of the ready queue(the one that would run last)
+bool dequeueLastTask(readyQueue* queue, task* lastTask) {
+	if (queue->numberOfTasks == 0)
+		return false;
+	queue->numberOfTasks--;
+	*lastTask = queue->tasks[(queue->head + queue->numberOfTasks) & (queue->capacity - 1)];
+	return true;
+}
+
+// Function to look at the task at the head of the ready queue without taking it
+const task* peekTask(const readyQueue* queue) {
+	if (queue->numberOfTasks == 0)
+		return NULL;
+	return &queue->tasks[queue->head];
+}
+
+// Function to move every task that has arrived by now to the tail of the ready queue
+int admitArrivedTasks(readyQueue* queue, workloadTrace* trace, unsigned long long currentTimestamp) {
+	while (hasArrivalBy(trace, currentTimestamp)) {
+		const workloadRecord* record = nextWorkloadRecord(trace);
+		task newTask = {.id = record->id, .cpuBurstTime = record->cpuBurstTime, .remainingTime = record->cpuBurstTime,
+				.arrivalTime = record->arrivalTime, .readyTime = record->arrivalTime};
+		if (enqueueTask(queue, &newTask) == -1)
+			return -1;
+	}
+	return 0;
 }
 
 // Function to run Round Robin scheduling
-void runRoundRobin(task tasks[], unsigned int numberOfTasks, unsigned int timeQuamtum) {
-	unsigned int currentTimestamp = 0;
-	unsigned int numberOfCompletedTasks = 0;
-	int lastTaskIndex = -1;		// Initially, no task completed.
-	
-	while (numberOfCompletedTasks < numberOfTasks) {
-		// Increment the waiting time for the tasks that are not started yet but arrived.
-		for (unsigned int index = 0; index < numberOfTasks; index++) {
-			if (tasks[index].arrivalTime <= currentTimestamp
-				&& index != lastTaskIndex
-				&& tasks[index].remainingTime > 0) {
-				tasks[index].waitingTime++;
-			}
+// If recordedTimeline is not NULL, every run of a task is recorded into it.
+// If finishedTasks is not NULL, every completed task is copied into it.
+// If switchCosts is not NULL, every switch to another task is charged before the task runs.
+int runRoundRobin(workloadTrace* trace, unsigned long long timeQuamtum, bool printTimeline,
+		timeline* recordedTimeline, task finishedTasks[], schedulingSummary* summary, switchCostModel* switchCosts) {
+	readyQueue queue = {NULL, 0, 0, 0};
+	unsigned long long currentTimestamp = 0;
+	bool hasPreemptedTask = false;		// Whether the last task used up its quantum
+	unsigned int preemptedTaskId = 0;
+	task currentTask;
+
+	summary->numberOfTasks = 0;
+	summary->totalWaitingTime = 0;
+	summary->totalTime = 0;
+	initSchedulingMetrics(&summary->metrics);
+
+	while (true) {
+		// Admit the tasks that have arrived by now
+		if (admitArrivedTasks(&queue, trace, currentTimestamp) == -1) {
+			free(queue.tasks);
+			return -1;
 		}
 
-		// Find the next task to run
-		int nextTaskIndex = getNextTask(tasks, numberOfTasks, currentTimestamp, lastTaskIndex);
-		if (nextTaskIndex == -1) {
-			currentTimestamp++;
+		// The next task to run is the one at the head of the queue
+		if (!dequeueTask(&queue, &currentTask)) {
+			// Nothing is ready, so jump over the idle gap to the next arrival
+			const workloadRecord* nextArrival = peekWorkloadRecord(trace);
+			if (nextArrival == NULL)
+				break;		// Every task is completed
+			currentTimestamp = nextArrival->arrivalTime;
 			continue;
 		}
 
-		task* currentTask = &tasks[nextTaskIndex];
+		// Pay for the switch if the CPU was running another task(or none)
+		if (switchCosts != NULL && (!summary->metrics.hasLastTask || summary->metrics.lastTaskId != currentTask.id))
+			currentTimestamp += chargeSwitch(switchCosts, currentTimestamp, currentTask.started, currentTask.lastRunEnd);
 
 		// Start the task
-		if (!currentTask->started) {
-			currentTask->started = true;
-			currentTask->startTime = currentTimestamp;
-			currentTask->waitingTime += currentTask->startTime - currentTask->arrivalTime;
+		if (!currentTask.started) {
+			currentTask.started = true;
+			currentTask.startTime = currentTimestamp;
 		}
+		recordDispatch(&summary->metrics, currentTask.id);
 
-		// Determine the actual run time 
-		unsigned int runTime = (currentTask->remainingTime > timeQuamtum) ? timeQuamtum : currentTask->remainingTime;
+		// Determine the actual run time. The next event is either the quantum expiry or the completion.
+		unsigned long long runTime = (currentTask.remainingTime > timeQuamtum) ? timeQuamtum : currentTask.remainingTime;
 		// Inform the task has been preempted if it is
-		if (lastTaskIndex != -1 
-				&& lastTaskIndex != nextTaskIndex
-				&& tasks[lastTaskIndex].remainingTime > 0)
-			printf("Task %d is preempted(timeQuantum is consumed) at time %d\n", tasks[lastTaskIndex].id, currentTimestamp);
-	
-		// Print the timeline as the task runs
-		for (unsigned int t = 0; t < runTime; t++) {
-			printf("At timestamp %u, task %u is running\n", currentTimestamp, currentTask->id);
-			currentTimestamp++;
+		if (printTimeline && hasPreemptedTask && preemptedTaskId != currentTask.id)
+			printf("Task %u is preempted(timeQuantum is consumed) at time %llu\n", preemptedTaskId, currentTimestamp);
+
+		// Print the timeline as the task runs, then jump to the end of the run
+		if (printTimeline)
+			printf("From timestamp %llu to %llu, task %u is running\n", currentTimestamp, currentTimestamp + runTime, currentTask.id);
+		if (recordedTimeline != NULL && recordRun(recordedTimeline, currentTask.id, currentTimestamp, runTime) == -1) {
+			free(queue.tasks);
+			return -1;
 		}
+		currentTimestamp += runTime;
 
 		// Update the task's remaining time
-		currentTask->remainingTime -= runTime;
+		currentTask.remainingTime -= runTime;
+		currentTask.lastRunEnd = currentTimestamp;
+
+		if (currentTask.remainingTime == 0) {
+			// Every moment between the arrival and the end that the task was not running, it was waiting
+			currentTask.endTime = currentTimestamp;
+			currentTask.waitingTime = currentTask.endTime - currentTask.arrivalTime - currentTask.cpuBurstTime;
+			if (printTimeline)
+				printf("At timestamp %llu, task %u is completed\n", currentTimestamp, currentTask.id);
+
+			summary->totalWaitingTime += currentTask.waitingTime;
+			summary->totalTime = currentTimestamp;
+			recordCompletion(&summary->metrics, currentTask.arrivalTime, currentTask.startTime, currentTask.endTime, currentTask.waitingTime);
+			if (finishedTasks != NULL)
+				finishedTasks[summary->numberOfTasks] = currentTask;
+			summary->numberOfTasks++;
+			hasPreemptedTask = false;
+		} else {
+			// Tasks that arrived while this one was running go first, then it joins the tail
+			if (admitArrivedTasks(&queue, trace, currentTimestamp) == -1 || enqueueTask(&queue, &currentTask) == -1) {
+				free(queue.tasks);
+				return -1;
+			}
+			hasPreemptedTask = true;
+			preemptedTaskId = currentTask.id;
+		}
+	}
+
+	free(queue.tasks);
+	return 0;
+}
+
+// The state of one CPU of the multi-CPU simulation
+typedef struct {
+	readyQueue runqueue;			// Tasks waiting for this CPU
+	readyQueue arrivals;			// Tasks placed on this CPU that arrive during the current period
+	unsigned long long clock;		// Local time of this CPU
+	unsigned long long busyTime;		// Time spent running tasks
+	unsigned long long numberOfCompletedTasks;
+	unsigned long long totalWaitingTime;
+	unsigned long long lastEndTime;		// When the last task on this CPU finished
+	unsigned long long migrationsIn;	// Tasks pulled from other CPUs by the load balancer
+	unsigned long long migrationsOut;	// Tasks pushed to other CPUs by the load balancer
+	schedulingMetrics metrics;
+} cpuState;
+
+// The multi-CPU simulation runs in periods between the balance points that matter(see load_balance.h).
+// During a period, every CPU simulates its own runqueue on its own thread. Between two periods, one
+// thread balances the runqueues and places the tasks arriving before the next balance point.
+typedef struct {
+	cpuState* cpus;
+	unsigned int numberOfCpus;
+	workloadTrace* trace;
+	unsigned long long timeQuantum;
+	unsigned long long balanceInterval;	// Time between two balance points
+	unsigned long long periodEnd;		// End of the current period
+	unsigned int lastPlacedCpu;		// CPU that got the last arrival
+	bool finished;
+	bool failed;				// Set by a CPU that ran out of memory
+	pthread_mutex_t failureLock;
+	pthread_barrier_t barrier;
+} multiCpuSimulation;
+
+typedef struct {
+	multiCpuSimulation* simulation;
+	cpuState* cpu;
+} cpuThreadArgument;
+
+// Function to get the earliest time a CPU may start the quantum that completes one of its tasks
+// (ULLONG_MAX if it has none)
+unsigned long long earliestCompletion(const cpuState* cpu, unsigned long long timeQuantum) {
+	const readyQueue* queue = &cpu->runqueue;
+	unsigned long long completionTime = ULLONG_MAX;
+	for (unsigned int i = 0; i < queue->numberOfTasks; i++) {
+		const task* queuedTask = &queue->tasks[(queue->head + i) & (queue->capacity - 1)];
+		unsigned long long time = earliestCompletingSlice(cpu->clock, queuedTask->remainingTime, timeQuantum);
+		if (time < completionTime)
+			completionTime = time;
+	}
+	return completionTime;
+}
+
+// Function to simulate one CPU from its clock to the end of the current period
+int runCpuPeriod(multiCpuSimulation* simulation, cpuState* cpu) {
+	task currentTask;
+
+	while (cpu->clock < simulation->periodEnd) {
+		// Admit the tasks placed on this CPU that have arrived by now
+		while (peekTask(&cpu->arrivals) != NULL && peekTask(&cpu->arrivals)->arrivalTime <= cpu->clock) {
+			dequeueTask(&cpu->arrivals, &currentTask);
+			if (enqueueTask(&cpu->runqueue, &currentTask) == -1)
+				return -1;
+		}
+
+		if (!dequeueTask(&cpu->runqueue, &currentTask)) {
+			// Idle until the next task placed on this CPU arrives, or until the period ends
+			const task* nextArrival = peekTask(&cpu->arrivals);
+			cpu->clock = (nextArrival != NULL) ? nextArrival->arrivalTime : simulation->periodEnd;
+			continue;
+		}
+
+		// A migrated task cannot run here before it stopped running on its previous CPU
+		if (currentTask.readyTime > cpu->clock)
+			cpu->clock = currentTask.readyTime;
+		if (!currentTask.started) {
+			currentTask.started = true;
+			currentTask.startTime = cpu->clock;
+		}
+		recordDispatch(&cpu->metrics, currentTask.id);
+
+		unsigned long long runTime = (currentTask.remainingTime > simulation->timeQuantum) ? simulation->timeQuantum : currentTask.remainingTime;
+		cpu->clock += runTime;
+		cpu->busyTime += runTime;
+		currentTask.remainingTime -= runTime;
+
+		if (currentTask.remainingTime == 0) {
+			currentTask.endTime = cpu->clock;
+			currentTask.waitingTime = currentTask.endTime - currentTask.arrivalTime - currentTask.cpuBurstTime;
+			cpu->numberOfCompletedTasks++;
+			cpu->totalWaitingTime += currentTask.waitingTime;
+			cpu->lastEndTime = cpu->clock;
+			recordCompletion(&cpu->metrics, currentTask.arrivalTime, currentTask.startTime, currentTask.endTime, currentTask.waitingTime);
+		} else {
+			// Tasks that arrived while this one was running go first, then it joins the tail
+			while (peekTask(&cpu->arrivals) != NULL && peekTask(&cpu->arrivals)->arrivalTime <= cpu->clock) {
+				task arrivedTask;
+				dequeueTask(&cpu->arrivals, &arrivedTask);
+				if (enqueueTask(&cpu->runqueue, &arrivedTask) == -1)
+					return -1;
+			}
+			currentTask.readyTime = cpu->clock;
+			if (enqueueTask(&cpu->runqueue, &currentTask) == -1)
+				return -1;
+		}
+	}
+	return 0;
+}
+
+// Function to even out the runqueues. Tasks are moved from the longest runqueue to the shortest one
+// until they differ by at most one task, which also lets an idle CPU steal work from a busy one.
+int balanceLoad(multiCpuSimulation* simulation) {
+	while (true) {
+		cpuState* busiest = &simulation->cpus[0];
+		cpuState* idlest = &simulation->cpus[0];
+		for (unsigned int index = 1; index < simulation->numberOfCpus; index++) {
+			cpuState* cpu = &simulation->cpus[index];
+			if (cpu->runqueue.numberOfTasks > busiest->runqueue.numberOfTasks)
+				busiest = cpu;
+			if (cpu->runqueue.numberOfTasks < idlest->runqueue.numberOfTasks)
+				idlest = cpu;
+		}
+		if (busiest->runqueue.numberOfTasks <= idlest->runqueue.numberOfTasks + 1)
+			return 0;
+
+		// The task at the tail would wait the longest where it is
+		task migratedTask;
+		dequeueLastTask(&busiest->runqueue, &migratedTask);
+		if (enqueueTask(&idlest->runqueue, &migratedTask) == -1)
+			return -1;
+		busiest->migrationsOut++;
+		idlest->migrationsIn++;
+	}
+}
+
+// Function to prepare the next period: balance the runqueues, skip over idle gaps, place the tasks
+// arriving before the next balance point on the CPU with the fewest tasks, and skip the balance
+// points where nothing can change.
+int startNextPeriod(multiCpuSimulation* simulation) {
+	if (simulation->failed || balanceLoad(simulation) == -1) {
+		simulation->finished = true;
+		simulation->failed = true;
+		return -1;
+	}
+
+	bool isIdle = true;
+	for (unsigned int index = 0; index < simulation->numberOfCpus; index++) {
+		if (simulation->cpus[index].runqueue.numberOfTasks > 0 || simulation->cpus[index].arrivals.numberOfTasks > 0)
+			isIdle = false;
+	}
 
-		if (currentTask->remainingTime == 0) {
-			currentTask->endTime = currentTimestamp;
-			numberOfCompletedTasks++;
-			printf("At timestamp %u, task %u is completed\n", currentTimestamp, currentTask->id);
-	
+	unsigned long long periodStart = simulation->periodEnd;
+	if (isIdle) {
+		const workloadRecord* nextArrival = peekWorkloadRecord(simulation->trace);
+		if (nextArrival == NULL) {
+			simulation->finished = true;	// Every task is completed
+			return 0;
 		}
+		if (nextArrival->arrivalTime > periodStart)
+			periodStart = nextArrival->arrivalTime;
+	}
+	simulation->periodEnd = periodStart + simulation->balanceInterval;
+
+	for (unsigned int index = 0; index < simulation->numberOfCpus; index++) {
+		if (simulation->cpus[index].clock < periodStart)
+			simulation->cpus[index].clock = periodStart;
+	}
 
-		// Update the last task index
-		lastTaskIndex = nextTaskIndex;
+	while (hasArrivalBy(simulation->trace, simulation->periodEnd - 1)) {
+		const workloadRecord* record = nextWorkloadRecord(simulation->trace);
+		task newTask = {.id = record->id, .cpuBurstTime = record->cpuBurstTime, .remainingTime = record->cpuBurstTime,
+				.arrivalTime = record->arrivalTime, .readyTime = record->arrivalTime};
+
+		// Ties go to the CPU after the one that got the previous task, so they are spread evenly
+		unsigned int targetIndex = (simulation->lastPlacedCpu + 1) % simulation->numberOfCpus;
+		for (unsigned int offset = 1; offset < simulation->numberOfCpus; offset++) {
+			unsigned int index = (simulation->lastPlacedCpu + 1 + offset) % simulation->numberOfCpus;
+			cpuState* cpu = &simulation->cpus[index];
+			cpuState* target = &simulation->cpus[targetIndex];
+			if (cpu->runqueue.numberOfTasks + cpu->arrivals.numberOfTasks
+					< target->runqueue.numberOfTasks + target->arrivals.numberOfTasks)
+				targetIndex = index;
+		}
+		simulation->lastPlacedCpu = targetIndex;
+		if (enqueueTask(&simulation->cpus[targetIndex].arrivals, &newTask) == -1) {
+			simulation->finished = true;
+			simulation->failed = true;
+			return -1;
+		}
 	}
+
+	// Tasks that are yet to arrive on a CPU change its runqueue during this period
+	unsigned long long completionTime = ULLONG_MAX;
+	for (unsigned int index = 0; index < simulation->numberOfCpus; index++) {
+		cpuState* cpu = &simulation->cpus[index];
+		if (cpu->arrivals.numberOfTasks > 0)
+			return 0;
+		unsigned long long time = earliestCompletion(cpu, simulation->timeQuantum);
+		if (time < completionTime)
+			completionTime = time;
+	}
+	const workloadRecord* nextArrival = peekWorkloadRecord(simulation->trace);
+	simulation->periodEnd = nextBalancePoint(periodStart, simulation->balanceInterval, completionTime,
+			(nextArrival != NULL) ? nextArrival->arrivalTime : ULLONG_MAX);
+	return 0;
+}
+
+void* cpuThread(void* param) {
+	cpuThreadArgument* argument = param;
+	multiCpuSimulation* simulation = argument->simulation;
+
+	while (true) {
+		if (runCpuPeriod(simulation, argument->cpu) == -1) {
+			pthread_mutex_lock(&simulation->failureLock);
+			simulation->failed = true;
+			pthread_mutex_unlock(&simulation->failureLock);
+		}
+
+		// Wait for every CPU to reach the end of the period. One of them prepares the next one.
+		if (pthread_barrier_wait(&simulation->barrier) == PTHREAD_BARRIER_SERIAL_THREAD)
+			startNextPeriod(simulation);
+		pthread_barrier_wait(&simulation->barrier);
+
+		if (simulation->finished)
+			break;
+	}
+	return NULL;
+}
+
+// Function to run Round Robin on several CPUs, each with its own runqueue
+int runMultiCpuRoundRobin(workloadTrace* trace, unsigned long long timeQuamtum, unsigned int numberOfCpus,
+		unsigned long long balanceInterval, bool printMetrics) {
+	multiCpuSimulation simulation = {.numberOfCpus = numberOfCpus, .trace = trace, .timeQuantum = timeQuamtum,
+			.balanceInterval = balanceInterval, .lastPlacedCpu = numberOfCpus - 1};
+	pthread_t* threads = malloc(numberOfCpus * sizeof(pthread_t));
+	cpuThreadArgument* arguments = malloc(numberOfCpus * sizeof(cpuThreadArgument));
+	simulation.cpus = calloc(numberOfCpus, sizeof(cpuState));
+	if (threads == NULL || arguments == NULL || simulation.cpus == NULL) {
+		perror("malloc");
+		free(threads);
+		free(arguments);
+		free(simulation.cpus);
+		return -1;
+	}
+
+	pthread_mutex_init(&simulation.failureLock, NULL);
+	pthread_barrier_init(&simulation.barrier, NULL, numberOfCpus);
+	startNextPeriod(&simulation);
+
+	if (!simulation.finished) {
+		for (unsigned int index = 0; index < numberOfCpus; index++) {
+			arguments[index].simulation = &simulation;
+			arguments[index].cpu = &simulation.cpus[index];
+			pthread_create(&threads[index], NULL, cpuThread, &arguments[index]);
+		}
+		for (unsigned int index = 0; index < numberOfCpus; index++)
+			pthread_join(threads[index], NULL);
+	}
+
+	// Report how each CPU was used, and the latencies over every task
+	unsigned long long totalTime = 0, numberOfTasks = 0, totalWaitingTime = 0, numberOfMigrations = 0;
+	schedulingMetrics metrics;
+	initSchedulingMetrics(&metrics);
+	for (unsigned int index = 0; index < numberOfCpus; index++) {
+		cpuState* cpu = &simulation.cpus[index];
+		if (cpu->lastEndTime > totalTime)
+			totalTime = cpu->lastEndTime;
+		numberOfTasks += cpu->numberOfCompletedTasks;
+		totalWaitingTime += cpu->totalWaitingTime;
+		numberOfMigrations += cpu->migrationsIn;
+		mergeSchedulingMetrics(&metrics, &cpu->metrics);
+	}
+
+	if (!simulation.failed && printMetrics) {
+		printSchedulingMetrics(&metrics, numberOfTasks, totalWaitingTime, totalTime);
+	} else if (!simulation.failed) {
+		printf("CPU\tUtilization\tCompleted\tMigrated in\tMigrated out\n");
+		for (unsigned int index = 0; index < numberOfCpus; index++) {
+			cpuState* cpu = &simulation.cpus[index];
+			printf("%u\t%.2f%%\t\t%llu\t\t%llu\t\t%llu\n", index,
+					totalTime > 0 ? 100.0 * cpu->busyTime / totalTime : 0.0,
+					cpu->numberOfCompletedTasks, cpu->migrationsIn, cpu->migrationsOut);
+		}
+		printf("\nMigrations: %llu\n", numberOfMigrations);
+		if (numberOfTasks == 0) {
+			printf("No tasks\n");
+		} else {
+			printf("Average waiting time: %.2f\n", (double)totalWaitingTime / numberOfTasks);
+			printf("Throughput: %.2f\n", (double)numberOfTasks / totalTime);
+			printf("Total time: %llu\n", totalTime);
+			printLatencyReport(&metrics);
+		}
+	}
+
+	for (unsigned int index = 0; index < numberOfCpus; index++) {
+		free(simulation.cpus[index].runqueue.tasks);
+		free(simulation.cpus[index].arrivals.tasks);
+	}
+	pthread_barrier_destroy(&simulation.barrier);
+	pthread_mutex_destroy(&simulation.failureLock);
+	free(simulation.cpus);
+	free(arguments);
+	free(threads);
+	return simulation.failed ? -1 : 0;
+}
+
+int compareTaskId(const void* a, const void* b) {
+	const task* taskA = a;
+	const task* taskB = b;
+	return (taskA->id > taskB->id) - (taskA->id < taskB->id);
 }
 
 // Function to display the task status information after the scheduling
 void displayTaskStatus(task tasks[], int numberOfTasks) {
-	unsigned int totalWaitingTime = 0;
+	// Tasks are stored in the order they completed. Show them in the order of their ID.
+	qsort(tasks, numberOfTasks, sizeof(task), compareTaskId);
+
 	printf("\nTaskID\tCPU Burst Time\tArrival Time\tWaiting Time\tStart Time\tEnd Time\n");
 	for (int index = 0; index < numberOfTasks; index++) {
-		printf("%d\t%d\t\t%d\t\t%d\t\t%d\t\t%d\n",
+		printf("%u\t%llu\t\t%llu\t\t%llu\t\t%llu\t\t%llu\n",
 				tasks[index].id,
 				tasks[index].cpuBurstTime,
 				tasks[index].arrivalTime,
 				tasks[index].waitingTime,
 				tasks[index].startTime,
 				tasks[index].endTime);
-		totalWaitingTime += tasks[index].waitingTime;
 	}
-	double averageWaitingTime = (double)totalWaitingTime / numberOfTasks;
-	
-	// totalTime is the sum of the end time of all tasks
-	unsigned int totalTime = 0;
-	for (int index = 0; index < numberOfTasks; index++) {
-		if (tasks[index].endTime > totalTime)
-			totalTime = tasks[index].endTime;
+}
+
+// Function to display the summary of the scheduling
+void displaySummary(const schedulingSummary* summary, const switchCostModel* switchCosts) {
+	if (summary->numberOfTasks == 0) {
+		printf("\nNo tasks\n");
+		return;
 	}
-	double throughput = (double)numberOfTasks / totalTime;
+	double averageWaitingTime = (double)summary->totalWaitingTime / summary->numberOfTasks;
+	double throughput = (double)summary->numberOfTasks / summary->totalTime;
 
 	printf("\nAverage waiting time: %.2f\n", averageWaitingTime);
 	printf("Throughput: %.2f\n", throughput);
-	printf("Total time: %d\n", totalTime);
+	printf("Total time: %llu\n", summary->totalTime);
+	printLatencyReport(&summary->metrics);
+	if (switchCosts != NULL)
+		printSwitchCostReport(switchCosts, summary->totalTime);
 }
 
-int main(void) {
-	unsigned int timeQuamtum = 3;
-	task tasks[] = {
-		{1, 5, 5, 0, 0, 0, 0, false},	// Task 1: CPU burst time = 5, Arrival time = 0
-		{2, 3, 3, 1, 0, 0, 0, false},	// Task 2: CPU burst time = 3, Arrival time = 1
-		{3, 8, 8, 2, 0, 0, 0, false},	// Task 3: CPU burst time = 8, Arrival time = 2
-		{4, 6, 6, 3, 0, 0, 0, false},	// Task 4: CPU burst time = 6, Arrival time = 3
-		{5, 4, 4, 4, 0, 0, 0, false}	// Task 5: CPU burst time = 4, Arrival time = 4
+int main(int argc, char* argv[]) {
+	unsigned long long timeQuamtum = 3;
+	workloadTrace trace;
+	schedulingSummary summary;
+
+	if (argc > 1) {
+		unsigned int numberOfCpus = 1;
+		unsigned long long balanceInterval = LOAD_BALANCE_INTERVAL;
+		bool printMetrics = false;
+		bool recordTimeline = false;
+		bool validArguments = true;
+		timelineFormat format = TIMELINE_GANTT;
+		const char* timelinePath = NULL;
+		switchCostModel switchCosts;
+		initSwitchCostModel(&switchCosts);
+		for (int index = 2; index < argc; index++) {
+			int switchCostOption = parseSwitchCostOption(&switchCosts, argc, argv, &index);
+			if (switchCostOption != 0) {
+				if (switchCostOption == -1)
+					validArguments = false;
+			} else if (strcmp(argv[index], "--metrics") == 0) {
+				printMetrics = true;
+			} else if (strcmp(argv[index], "--quantum") == 0 && index + 1 < argc) {
+				timeQuamtum = strtoull(argv[++index], NULL, 10);
+			} else if (strcmp(argv[index], "--balance-interval") == 0 && index + 1 < argc) {
+				balanceInterval = strtoull(argv[++index], NULL, 10);
+			} else if (strcmp(argv[index], "--timeline") == 0 && index + 1 < argc) {
+				recordTimeline = true;
+				if (parseTimelineFormat(argv[++index], &format) == -1)
+					validArguments = false;
+			} else if (strcmp(argv[index], "--timeline-output") == 0 && index + 1 < argc) {
+				timelinePath = argv[++index];
+			} else {
+				numberOfCpus = (unsigned int)strtoul(argv[index], NULL, 10);
+			}
+		}
+		bool modelsSwitches = isSwitchCostEnabled(&switchCosts) || switchCosts.calibrate;
+		if (!validArguments || numberOfCpus == 0 || timeQuamtum == 0 || balanceInterval == 0 ||
+				((recordTimeline || modelsSwitches) && numberOfCpus > 1)) {
+			fprintf(stderr, "Usage: %s <trace> [numberOfCpus] [--quantum timeQuantum] [--balance-interval interval] [--metrics] [--timeline gantt|csv|json] [--timeline-output path] "
+					SWITCH_COST_USAGE "\n", argv[0]);
+			return 1;
+		}
+		if (prepareSwitchCostModel(&switchCosts) == -1)
+			return 1;
+		if (openWorkloadTrace(&trace, argv[1]) == -1)
+			return 1;
+
+		int result;
+		if (numberOfCpus > 1) {
+			result = runMultiCpuRoundRobin(&trace, timeQuamtum, numberOfCpus, balanceInterval, printMetrics);
+		} else {
+			timeline recordedTimeline;
+			initTimeline(&recordedTimeline);
+			result = runRoundRobin(&trace, timeQuamtum, false, recordTimeline ? &recordedTimeline : NULL, NULL, &summary,
+					isSwitchCostEnabled(&switchCosts) ? &switchCosts : NULL);
+			if (result == 0 && printMetrics)
+				printSchedulingMetrics(&summary.metrics, summary.numberOfTasks, summary.totalWaitingTime, summary.totalTime);
+			else if (result == 0)
+				displaySummary(&summary, isSwitchCostEnabled(&switchCosts) ? &switchCosts : NULL);
+			if (result == 0 && recordTimeline)
+				result = writeTimeline(&recordedTimeline, format, timelinePath);
+			destroyTimeline(&recordedTimeline);
+		}
+		closeWorkloadTrace(&trace);
+		return (result == 0) ? 0 : 1;
+	}
+
+	workloadRecord records[] = {
+		{.arrivalTime = 0, .cpuBurstTime = 5, .id = 1},	// Task 1: CPU burst time = 5, Arrival time = 0
+		{.arrivalTime = 1, .cpuBurstTime = 3, .id = 2},	// Task 2: CPU burst time = 3, Arrival time = 1
+		{.arrivalTime = 2, .cpuBurstTime = 8, .id = 3},	// Task 3: CPU burst time = 8, Arrival time = 2
+		{.arrivalTime = 3, .cpuBurstTime = 6, .id = 4},	// Task 4: CPU burst time = 6, Arrival time = 3
+		{.arrivalTime = 4, .cpuBurstTime = 4, .id = 5}	// Task 5: CPU burst time = 4, Arrival time = 4
 	};
+	unsigned int numberOfTasks = sizeof(records) / sizeof(records[0]);
+	task tasks[sizeof(records) / sizeof(records[0])];
 
-	unsigned int numberOfTasks = sizeof(tasks) / sizeof(task);
-	runRoundRobin(tasks, numberOfTasks, timeQuamtum);
+	openWorkloadTraceFromRecords(&trace, records, numberOfTasks);
+	runRoundRobin(&trace, timeQuamtum, true, NULL, tasks, &summary, NULL);
 	displayTaskStatus(tasks, numberOfTasks);
+	displaySummary(&summary, NULL);
 
 	return 0;
 }
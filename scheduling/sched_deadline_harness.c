@@ -0,0 +1,351 @@
+// scheduling/sched_deadline_harness.c
+// Runs periodic worker threads under SCHED_DEADLINE to measure how much periodic work a machine
+// really absorbs. Every task is given as runtime/deadline/period(in microseconds), optionally
+// followed by xN for N identical tasks. Every period, a worker is released, does a job of
+// load * runtime of CPU time, and checks whether it finished by its deadline.
+//
+// The kernel admits a SCHED_DEADLINE task only while the total bandwidth(runtime / period) fits
+// in the root domain; a task that does not fit is rejected(EBUSY) and counted, not run. Without
+// the privilege for SCHED_DEADLINE(EPERM), a worker falls back to SCHED_FIFO with a rate-monotonic
+// priority(shorter period, higher priority), and to SCHED_OTHER if it cannot get SCHED_FIFO either.
+// The workers are released together, so the first period is the worst case(critical instant).
+// SCHED_DEADLINE tasks cannot be pinned; to measure one core, run the harness in a cpuset of one CPU.
+//
+// Usage: ./sched_deadline_harness.out [--duration seconds] [--load fraction] runtime/deadline/period[xN] ...
+//   e.g. sudo ./sched_deadline_harness.out --duration 10 2000/5000/10000x3 1000/2000/2000
+// gcc -o sched_deadline_harness.out sched_deadline_harness.c -lpthread
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include "latency_histogram.h"
+
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE 6
+#endif
+#ifndef SYS_sched_setattr
+#ifdef __NR_sched_setattr
+#define SYS_sched_setattr __NR_sched_setattr
+#else
+#error "sched_setattr is not available: the kernel headers predate Linux 3.14"
+#endif
+#endif
+
+#define NANOSECONDS_PER_SECOND 1000000000ull
+#define NANOSECONDS_PER_MICROSECOND 1000ull
+#define START_DELAY 100000000ull    // Time for every worker to set its policy before the first release(ns)
+
+// Layout of struct sched_attr(linux/sched/types.h), which glibc does not always provide
+typedef struct {
+    uint32_t size;
+    uint32_t schedPolicy;
+    uint64_t schedFlags;
+    int32_t schedNice;
+    uint32_t schedPriority;
+    uint64_t schedRuntime;          // In nanoseconds
+    uint64_t schedDeadline;
+    uint64_t schedPeriod;
+} schedAttr;
+
+typedef enum {
+    MODE_DEADLINE,
+    MODE_FIFO,
+    MODE_OTHER,
+    MODE_REJECTED                   // Refused by the admission control of SCHED_DEADLINE
+} workerMode;
+
+// One periodic task, and what its worker measured
+typedef struct {
+    unsigned long long runtime;     // All in nanoseconds
+    unsigned long long deadline;    // Relative to the release
+    unsigned long long period;
+    int fifoPriority;               // Priority if the worker falls back to SCHED_FIFO
+    workerMode mode;
+    unsigned long long startTime;   // First release, on CLOCK_MONOTONIC
+    unsigned long long endTime;     // No release at or after this
+    double load;
+    unsigned long long numberOfJobs;
+    unsigned long long numberOfMisses;
+    unsigned long long numberOfSkippedReleases;     // Releases that passed while a late job was still running
+    unsigned long long cpuTime;                     // CPU time spent in jobs
+    latencyHistogram lateness;                      // How late the missed jobs finished(us)
+    latencyHistogram responseTimes;                 // Finish - release of every job(us)
+} periodicTask;
+
+static inline unsigned long long now(clockid_t clock) {
+    struct timespec time;
+    clock_gettime(clock, &time);
+    return (unsigned long long)time.tv_sec * NANOSECONDS_PER_SECOND + time.tv_nsec;
+}
+
+static inline void sleepUntil(unsigned long long time) {
+    struct timespec wakeUp = {time / NANOSECONDS_PER_SECOND, time % NANOSECONDS_PER_SECOND};
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeUp, NULL) == EINTR)
+        ;
+}
+
+// Function to switch the calling thread to SCHED_DEADLINE. Returns 0 on success, or the error number.
+int setDeadlinePolicy(const periodicTask* periodic) {
+    schedAttr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.schedPolicy = SCHED_DEADLINE;
+    attr.schedRuntime = periodic->runtime;
+    attr.schedDeadline = periodic->deadline;
+    attr.schedPeriod = periodic->period;
+
+    if (syscall(SYS_sched_setattr, 0, &attr, 0) == -1)
+        return errno;
+    return 0;
+}
+
+// Function to pick the best policy that the calling thread may use
+workerMode setWorkerPolicy(const periodicTask* periodic) {
+    int error = setDeadlinePolicy(periodic);
+    if (error == 0)
+        return MODE_DEADLINE;
+    if (error == EBUSY)
+        return MODE_REJECTED;
+    if (error != EPERM && error != ENOSYS && error != EINVAL)
+        fprintf(stderr, "sched_setattr: %s\n", strerror(error));
+
+    struct sched_param param = {.sched_priority = periodic->fifoPriority};
+    if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0)
+        return MODE_FIFO;
+    return MODE_OTHER;
+}
+
+// Function to spin until the calling thread has used cpuTime more of CPU time
+void burnCpu(unsigned long long cpuTime) {
+    unsigned long long end = now(CLOCK_THREAD_CPUTIME_ID) + cpuTime;
+    while (now(CLOCK_THREAD_CPUTIME_ID) < end)
+        ;
+}
+
+// Function to run the jobs of one periodic task, one per period, until the end of the experiment
+void* runWorker(void* param) {
+    periodicTask* periodic = param;
+    unsigned long long job = (unsigned long long)(periodic->load * periodic->runtime);
+
+    periodic->mode = setWorkerPolicy(periodic);
+    if (periodic->mode == MODE_REJECTED)
+        return NULL;
+
+    unsigned long long release = periodic->startTime;
+    while (release < periodic->endTime) {
+        sleepUntil(release);
+
+        unsigned long long cpuStart = now(CLOCK_THREAD_CPUTIME_ID);
+        burnCpu(job);
+        unsigned long long finish = now(CLOCK_MONOTONIC);
+        periodic->cpuTime += now(CLOCK_THREAD_CPUTIME_ID) - cpuStart;
+        periodic->numberOfJobs++;
+        recordLatency(&periodic->responseTimes, (finish - release) / NANOSECONDS_PER_MICROSECOND);
+
+        if (finish > release + periodic->deadline) {
+            periodic->numberOfMisses++;
+            recordLatency(&periodic->lateness, (finish - release - periodic->deadline) / NANOSECONDS_PER_MICROSECOND);
+        }
+
+        // A job that ran past the next releases makes the worker skip them, instead of running late forever
+        release += periodic->period;
+        while (release + periodic->period <= finish) {
+            release += periodic->period;
+            periodic->numberOfSkippedReleases++;
+        }
+    }
+    return NULL;
+}
+
+// Function to parse runtime/deadline/period[xN] into count tasks. Returns 0 on success, -1 on failure.
+int parseTask(const char* argument, periodicTask* periodic, unsigned int* count) {
+    unsigned long long runtime, deadline, period;
+    int length = 0;
+
+    *count = 1;
+    if (sscanf(argument, "%llu/%llu/%llu%n", &runtime, &deadline, &period, &length) != 3)
+        return -1;
+    if (argument[length] == 'x') {
+        char* end;
+        *count = (unsigned int)strtoul(argument + length + 1, &end, 10);
+        if (*end != '\0')
+            return -1;
+    } else if (argument[length] != '\0') {
+        return -1;
+    }
+
+    // The kernel requires runtime <= deadline <= period, and at least 1024ns of runtime
+    if (runtime * NANOSECONDS_PER_MICROSECOND < 1024 || runtime > deadline || deadline > period || *count == 0)
+        return -1;
+
+    memset(periodic, 0, sizeof(*periodic));
+    periodic->runtime = runtime * NANOSECONDS_PER_MICROSECOND;
+    periodic->deadline = deadline * NANOSECONDS_PER_MICROSECOND;
+    periodic->period = period * NANOSECONDS_PER_MICROSECOND;
+    initLatencyHistogram(&periodic->lateness);
+    initLatencyHistogram(&periodic->responseTimes);
+    return 0;
+}
+
+// Function to give every task a rate-monotonic SCHED_FIFO priority: the shorter the period, the higher
+void assignFifoPriorities(periodicTask* tasks, unsigned int numberOfTasks) {
+    int maxPriority = sched_get_priority_max(SCHED_FIFO);
+    int minPriority = sched_get_priority_min(SCHED_FIFO);
+
+    for (unsigned int index = 0; index < numberOfTasks; index++) {
+        int priority = maxPriority;
+        for (unsigned int other = 0; other < numberOfTasks; other++) {
+            // One level per distinct shorter period
+            bool counted = false;
+            for (unsigned int before = 0; before < other; before++)
+                counted |= (tasks[before].period == tasks[other].period);
+            if (!counted && tasks[other].period < tasks[index].period)
+                priority--;
+        }
+        tasks[index].fifoPriority = (priority < minPriority) ? minPriority : priority;
+    }
+}
+
+const char* modeName(workerMode mode) {
+    switch (mode) {
+    case MODE_DEADLINE:
+        return "DEADLINE";
+    case MODE_FIFO:
+        return "FIFO";
+    case MODE_OTHER:
+        return "OTHER";
+    default:
+        return "rejected";
+    }
+}
+
+// Function to display, for every task and over all tasks, the misses and how much work got done
+void displayResults(const periodicTask* tasks, unsigned int numberOfTasks, double duration) {
+    double requestedBandwidth = 0, admittedBandwidth = 0, achievedBandwidth = 0;
+    unsigned long long numberOfJobs = 0, numberOfMisses = 0, numberOfRejections = 0;
+
+    printf("Task\tRuntime/Deadline/Period(us)\tPolicy\t\tJobs\tMisses\tMiss ratio\tSkipped\tp99 response(us)\tMax lateness(us)\tCPU share\n");
+    for (unsigned int index = 0; index < numberOfTasks; index++) {
+        const periodicTask* periodic = &tasks[index];
+        double bandwidth = (double)periodic->runtime / periodic->period;
+        double share = periodic->cpuTime / (duration * NANOSECONDS_PER_SECOND);
+
+        requestedBandwidth += bandwidth;
+        if (periodic->mode == MODE_REJECTED) {
+            numberOfRejections++;
+        } else {
+            admittedBandwidth += bandwidth;
+            achievedBandwidth += share;
+            numberOfJobs += periodic->numberOfJobs;
+            numberOfMisses += periodic->numberOfMisses;
+        }
+
+        printf("%u\t%llu/%llu/%llu\t\t\t%s", index, periodic->runtime / NANOSECONDS_PER_MICROSECOND,
+                periodic->deadline / NANOSECONDS_PER_MICROSECOND, periodic->period / NANOSECONDS_PER_MICROSECOND,
+                modeName(periodic->mode));
+        if (periodic->mode == MODE_FIFO)
+            printf("(%d)", periodic->fifoPriority);
+        printf("\t");
+        if (periodic->mode == MODE_REJECTED) {
+            printf("-\t-\t-\t\t-\t-\t\t\t-\t\t\t-\n");
+            continue;
+        }
+        printf("%llu\t%llu\t%.4f\t\t%llu\t%llu\t\t\t%llu\t\t\t%.4f\n", periodic->numberOfJobs, periodic->numberOfMisses,
+                periodic->numberOfJobs > 0 ? (double)periodic->numberOfMisses / periodic->numberOfJobs : 0.0,
+                periodic->numberOfSkippedReleases, latencyPercentile(&periodic->responseTimes, 99),
+                periodic->lateness.maxValue, share);
+    }
+
+    printf("\nRequested bandwidth: %.4f CPUs\n", requestedBandwidth);
+    printf("Admitted bandwidth: %.4f CPUs(%llu of %u tasks rejected by admission control)\n",
+            admittedBandwidth, numberOfRejections, numberOfTasks);
+    printf("Achieved throughput: %.4f CPUs of periodic work, %.1f jobs per second\n",
+            achievedBandwidth, numberOfJobs / duration);
+    printf("Deadline misses: %llu of %llu jobs(%.4f)\n", numberOfMisses, numberOfJobs,
+            numberOfJobs > 0 ? (double)numberOfMisses / numberOfJobs : 0.0);
+}
+
+void printUsage(const char* program) {
+    fprintf(stderr, "Usage: %s [--duration seconds] [--load fraction] runtime/deadline/period[xN] ...\n", program);
+    fprintf(stderr, "  times in microseconds, runtime <= deadline <= period; xN starts N identical tasks\n");
+}
+
+int main(int argc, char* argv[]) {
+    double duration = 5.0;
+    double load = 0.9;          // Fraction of the runtime that every job uses
+    periodicTask* tasks = NULL;
+    unsigned int numberOfTasks = 0;
+
+    for (int index = 1; index < argc; index++) {
+        if (strcmp(argv[index], "--duration") == 0 && index + 1 < argc) {
+            duration = strtod(argv[++index], NULL);
+        } else if (strcmp(argv[index], "--load") == 0 && index + 1 < argc) {
+            load = strtod(argv[++index], NULL);
+        } else {
+            periodicTask periodic;
+            unsigned int count;
+            if (parseTask(argv[index], &periodic, &count) == -1) {
+                printUsage(argv[0]);
+                free(tasks);
+                return 1;
+            }
+
+            periodicTask* newTasks = realloc(tasks, (numberOfTasks + count) * sizeof(periodicTask));
+            if (newTasks == NULL) {
+                perror("realloc");
+                free(tasks);
+                return 1;
+            }
+            tasks = newTasks;
+            for (unsigned int copy = 0; copy < count; copy++)
+                tasks[numberOfTasks++] = periodic;
+        }
+    }
+    if (numberOfTasks == 0 || duration <= 0 || load <= 0 || load > 1) {
+        printUsage(argv[0]);
+        free(tasks);
+        return 1;
+    }
+
+    pthread_t* threads = malloc(numberOfTasks * sizeof(pthread_t));
+    if (threads == NULL) {
+        perror("malloc");
+        free(tasks);
+        return 1;
+    }
+
+    // Every worker is released for the first time at the same instant
+    assignFifoPriorities(tasks, numberOfTasks);
+    unsigned long long startTime = now(CLOCK_MONOTONIC) + START_DELAY;
+    for (unsigned int index = 0; index < numberOfTasks; index++) {
+        tasks[index].startTime = startTime;
+        tasks[index].endTime = startTime + (unsigned long long)(duration * NANOSECONDS_PER_SECOND);
+        tasks[index].load = load;
+    }
+
+    unsigned int numberOfThreads = 0;
+    for (; numberOfThreads < numberOfTasks; numberOfThreads++) {
+        int error = pthread_create(&threads[numberOfThreads], NULL, runWorker, &tasks[numberOfThreads]);
+        if (error != 0) {
+            fprintf(stderr, "pthread_create: %s\n", strerror(error));
+            break;
+        }
+    }
+    for (unsigned int index = 0; index < numberOfThreads; index++)
+        pthread_join(threads[index], NULL);
+
+    if (numberOfThreads == numberOfTasks)
+        displayResults(tasks, numberOfTasks, duration);
+
+    free(threads);
+    free(tasks);
+    return (numberOfThreads == numberOfTasks) ? 0 : 1;
+}
@@ -0,0 +1,462 @@
+// scheduling/scheduler_sweep.c
+// Runs a grid of scheduler experiments on one workload trace and writes a single table of results.
+// Every experiment is one run of a simulator program with --metrics(see scheduling_metrics.h).
+// Experiments are independent, so a pool of threads, one per core by default, keeps that many
+// running at once. The trace is loaded once here and stays mapped for the whole sweep; the
+// simulators map it read-only, so all of them share that one copy in the page cache.
+//
+// The switch cost options(see switch_cost.h) are passed on to the policies that model the cost of a
+// context switch, rr and asjf; the others switch for free. --calibrate measures the costs once, here,
+// before any experiment runs, so every experiment is charged the same costs.
+//
+// --cpus runs every experiment on that many CPUs, which only rr and cfs simulate, and without
+// switch costs.
+//
+// Usage: ./scheduler_sweep.out <trace> [--threads N] [--cpus N] [--json] [--output path]
+//               [--switch-cost ns] [--refill-cost ns] [--warmth-decay ns] [--unit-length ns]
+//               [--calibrate [--working-set bytes]] <policy>[:<parameter>=<v1>,<v2>,...] ...
+//   e.g. ./scheduler_sweep.out workload.trace rr:quantum=1,2,4,8 cfs:latency=8,24 asjf:alpha=0.2,0.5,0.8 mlfq:boost=0,200 srtf sjf fcfs
+//        ./scheduler_sweep.out workload.trace --calibrate rr:quantum=1,2,4,8,16,32   (where switching eats the throughput)
+//        ./scheduler_sweep.out workload.trace --cpus 4 rr:quantum=1,4,16 cfs:latency=8,24
+// The simulator programs(*.out) are looked up in the directory of this program.
+// gcc -o scheduler_sweep.out scheduler_sweep.c -lpthread -lm
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <spawn.h>
+#include <pthread.h>
+#include <sys/wait.h>
+#include "workload_trace.h"
+#include "switch_cost.h"
+
+#define MAX_VALUE_LENGTH 32
+#define MAX_ARGUMENTS 16
+
+extern char** environ;
+
+// A policy that can be swept, and the simulator that implements it
+typedef struct {
+    const char* name;
+    const char* program;
+    const char* parameter;      // Name of the parameter that can be swept(NULL if there is none)
+    const char* option;         // Command line option of the simulator that sets the parameter
+    bool chargesSwitches;       // Whether the simulator takes the switch cost options
+    bool runsOnCpus;            // Whether the simulator takes a number of CPUs
+} policyDescription;
+
+static const policyDescription policies[] = {
+    {"fcfs", "first_come_first_serve_scheduling.out", NULL, NULL, false, false},
+    {"sjf", "shortest_job_first_scheduling.out", NULL, NULL, false, false},
+    {"srtf", "shortest_remaining_time_first.out", NULL, NULL, false, false},
+    {"asjf", "approximated_SJF.out", "alpha", "--alpha", true, false},
+    {"rr", "round_robin.out", "quantum", "--quantum", true, true},
+    {"cfs", "completely_fair_scheduling.out", "latency", "--latency", false, true},
+    {"mlfq", "multilevel_feedback_queue.out", "boost", "--boost", false, false}
+};
+
+// One point of the grid, and what its run measured
+typedef struct {
+    const policyDescription* policy;
+    char value[MAX_VALUE_LENGTH];       // Value of the parameter(empty if the policy has none)
+    bool succeeded;
+    unsigned long long numberOfTasks;
+    unsigned long long totalTime;
+    double throughput;
+    double meanWaitingTime;
+    unsigned long long p99WaitingTime;
+    double meanTurnaroundTime;
+    unsigned long long p99TurnaroundTime;
+    unsigned long long numberOfContextSwitches;
+    double wallSeconds;                 // How long the simulator ran
+} experiment;
+
+typedef struct {
+    experiment* experiments;
+    unsigned int numberOfExperiments;
+    unsigned int nextExperiment;        // Next experiment that no thread has taken yet
+    pthread_mutex_t lock;
+    const char* programDirectory;
+    const char* tracePath;
+    const switchCostModel* switchCosts; // Costs passed on to the simulators(NULL if switches are free)
+    const char* numberOfCpus;           // Number of CPUs passed on to the simulators(NULL for one)
+} sweep;
+
+// Function to find a policy by its name
+const policyDescription* findPolicy(const char* name, size_t length) {
+    for (unsigned int index = 0; index < sizeof(policies) / sizeof(policies[0]); index++) {
+        if (strlen(policies[index].name) == length && strncmp(policies[index].name, name, length) == 0)
+            return &policies[index];
+    }
+    return NULL;
+}
+
+// Function to add the experiments of one "<policy>[:<parameter>=<v1>,<v2>,...]" argument to the grid
+int addExperiments(const char* specification, experiment** experiments, unsigned int* numberOfExperiments) {
+    const char* colon = strchr(specification, ':');
+    size_t nameLength = (colon != NULL) ? (size_t)(colon - specification) : strlen(specification);
+    const policyDescription* policy = findPolicy(specification, nameLength);
+    if (policy == NULL) {
+        fprintf(stderr, "Unknown policy: %.*s\n", (int)nameLength, specification);
+        return -1;
+    }
+
+    const char* values = "";
+    if (colon != NULL) {
+        const char* equals = strchr(colon, '=');
+        if (policy->parameter == NULL || equals == NULL ||
+                strlen(policy->parameter) != (size_t)(equals - colon - 1) ||
+                strncmp(policy->parameter, colon + 1, equals - colon - 1) != 0) {
+            fprintf(stderr, "%s: %s takes %s%s\n", specification, policy->name,
+                    policy->parameter ? "only the parameter " : "no parameter", policy->parameter ? policy->parameter : "");
+            return -1;
+        }
+        values = equals + 1;
+    }
+
+    // Every value of the list is one experiment. Without a list, the simulator uses its default.
+    do {
+        const char* comma = strchr(values, ',');
+        size_t valueLength = (comma != NULL) ? (size_t)(comma - values) : strlen(values);
+        if (colon != NULL) {
+            char* end;
+            char value[MAX_VALUE_LENGTH];
+            snprintf(value, sizeof(value), "%.*s", (int)valueLength, values);
+            double number = strtod(value, &end);
+            // The value is written into the JSON as it is, so "nan" and "inf" are rejected too
+            if (valueLength == 0 || valueLength >= MAX_VALUE_LENGTH || *end != '\0' || !isfinite(number) || number < 0) {
+                fprintf(stderr, "%s: invalid value \"%.*s\"\n", specification, (int)valueLength, values);
+                return -1;
+            }
+        }
+
+        experiment* newExperiments = realloc(*experiments, (*numberOfExperiments + 1) * sizeof(experiment));
+        if (newExperiments == NULL) {
+            perror("realloc");
+            return -1;
+        }
+        *experiments = newExperiments;
+
+        experiment* newExperiment = &newExperiments[(*numberOfExperiments)++];
+        memset(newExperiment, 0, sizeof(*newExperiment));
+        newExperiment->policy = policy;
+        snprintf(newExperiment->value, sizeof(newExperiment->value), "%.*s", (int)valueLength, values);
+
+        values = (comma != NULL) ? comma + 1 : NULL;
+    } while (values != NULL);
+
+    return 0;
+}
+
+// Function to run the simulator of one experiment and read back its metrics
+void runExperiment(const sweep* state, experiment* currentExperiment) {
+    char programPath[PATH_MAX];
+    char output[1024];
+    size_t outputLength = 0;
+    int outputPipe[2];
+    pid_t pid;
+    struct timespec start, end;
+
+    snprintf(programPath, sizeof(programPath), "%s/%s", state->programDirectory, currentExperiment->policy->program);
+    char* arguments[MAX_ARGUMENTS] = {programPath, (char*)state->tracePath};
+    unsigned int numberOfArguments = 2;
+    if (state->numberOfCpus != NULL)
+        arguments[numberOfArguments++] = (char*)state->numberOfCpus;
+    if (currentExperiment->value[0] != '\0') {
+        arguments[numberOfArguments++] = (char*)currentExperiment->policy->option;
+        arguments[numberOfArguments++] = currentExperiment->value;
+    }
+    char switchCostValues[4][MAX_VALUE_LENGTH];
+    if (state->switchCosts != NULL && currentExperiment->policy->chargesSwitches) {
+        static const char* const switchCostOptions[] = {"--switch-cost", "--refill-cost", "--warmth-decay", "--unit-length"};
+        const unsigned long long values[] = {state->switchCosts->switchCost, state->switchCosts->refillCost,
+                                             state->switchCosts->warmthDecay, state->switchCosts->unitLength};
+        for (unsigned int index = 0; index < 4; index++) {
+            snprintf(switchCostValues[index], MAX_VALUE_LENGTH, "%llu", values[index]);
+            arguments[numberOfArguments++] = (char*)switchCostOptions[index];
+            arguments[numberOfArguments++] = switchCostValues[index];
+        }
+    }
+    arguments[numberOfArguments++] = "--metrics";
+    arguments[numberOfArguments] = NULL;
+
+    // Close-on-exec, so that a child started by another thread does not keep this pipe open
+    if (pipe2(outputPipe, O_CLOEXEC) == -1) {
+        perror("pipe2");
+        return;
+    }
+
+    posix_spawn_file_actions_t fileActions;
+    posix_spawn_file_actions_init(&fileActions);
+    posix_spawn_file_actions_adddup2(&fileActions, outputPipe[1], STDOUT_FILENO);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int error = posix_spawn(&pid, programPath, &fileActions, NULL, arguments, environ);
+    posix_spawn_file_actions_destroy(&fileActions);
+    close(outputPipe[1]);
+    if (error != 0) {
+        fprintf(stderr, "%s: %s\n", programPath, strerror(error));
+        close(outputPipe[0]);
+        return;
+    }
+
+    // Only the first sizeof(output) bytes matter, but read to the end so the simulator never blocks
+    while (true) {
+        char buffer[4096];
+        ssize_t length = read(outputPipe[0], buffer, sizeof(buffer));
+        if (length <= 0)
+            break;
+        size_t copyLength = sizeof(output) - 1 - outputLength;
+        if ((size_t)length < copyLength)
+            copyLength = length;
+        memcpy(output + outputLength, buffer, copyLength);
+        outputLength += copyLength;
+    }
+    output[outputLength] = '\0';
+    close(outputPipe[0]);
+
+    int status;
+    waitpid(pid, &status, 0);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    currentExperiment->wallSeconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 ||
+            sscanf(output, "tasks=%llu total_time=%llu throughput=%lf mean_waiting=%lf p99_waiting=%llu "
+                           "mean_turnaround=%lf p99_turnaround=%llu context_switches=%llu",
+                    &currentExperiment->numberOfTasks, &currentExperiment->totalTime, &currentExperiment->throughput,
+                    &currentExperiment->meanWaitingTime, &currentExperiment->p99WaitingTime,
+                    &currentExperiment->meanTurnaroundTime, &currentExperiment->p99TurnaroundTime,
+                    &currentExperiment->numberOfContextSwitches) != 8) {
+        fprintf(stderr, "%s %s%s%s: failed\n", currentExperiment->policy->name,
+                currentExperiment->policy->parameter ? currentExperiment->policy->parameter : "",
+                currentExperiment->value[0] ? "=" : "", currentExperiment->value);
+        return;
+    }
+    currentExperiment->succeeded = true;
+}
+
+void* workerThread(void* param) {
+    sweep* state = param;
+
+    while (true) {
+        pthread_mutex_lock(&state->lock);
+        unsigned int index = state->nextExperiment;
+        if (index < state->numberOfExperiments)
+            state->nextExperiment++;
+        pthread_mutex_unlock(&state->lock);
+
+        if (index >= state->numberOfExperiments)
+            break;
+        runExperiment(state, &state->experiments[index]);
+    }
+    return NULL;
+}
+
+void writeCsv(FILE* file, const experiment experiments[], unsigned int numberOfExperiments) {
+    fprintf(file, "policy,parameter,value,tasks,total_time,throughput,mean_waiting,p99_waiting,"
+                  "mean_turnaround,p99_turnaround,context_switches,wall_seconds\n");
+    for (unsigned int index = 0; index < numberOfExperiments; index++) {
+        const experiment* current = &experiments[index];
+        if (!current->succeeded)
+            continue;
+        fprintf(file, "%s,%s,%s,%llu,%llu,%.6f,%.6f,%llu,%.6f,%llu,%llu,%.3f\n",
+                current->policy->name,
+                current->policy->parameter ? current->policy->parameter : "",
+                current->value,
+                current->numberOfTasks,
+                current->totalTime,
+                current->throughput,
+                current->meanWaitingTime,
+                current->p99WaitingTime,
+                current->meanTurnaroundTime,
+                current->p99TurnaroundTime,
+                current->numberOfContextSwitches,
+                current->wallSeconds);
+    }
+}
+
+void writeJson(FILE* file, const experiment experiments[], unsigned int numberOfExperiments) {
+    bool isFirst = true;
+
+    fprintf(file, "[\n");
+    for (unsigned int index = 0; index < numberOfExperiments; index++) {
+        const experiment* current = &experiments[index];
+        if (!current->succeeded)
+            continue;
+        fprintf(file, "%s  {\"policy\": \"%s\", ", isFirst ? "" : ",\n", current->policy->name);
+        if (current->value[0] != '\0')
+            fprintf(file, "\"%s\": %s, ", current->policy->parameter, current->value);
+        fprintf(file, "\"tasks\": %llu, \"total_time\": %llu, \"throughput\": %.6f, "
+                      "\"mean_waiting\": %.6f, \"p99_waiting\": %llu, \"mean_turnaround\": %.6f, "
+                      "\"p99_turnaround\": %llu, \"context_switches\": %llu, \"wall_seconds\": %.3f}",
+                current->numberOfTasks,
+                current->totalTime,
+                current->throughput,
+                current->meanWaitingTime,
+                current->p99WaitingTime,
+                current->meanTurnaroundTime,
+                current->p99TurnaroundTime,
+                current->numberOfContextSwitches,
+                current->wallSeconds);
+        isFirst = false;
+    }
+    fprintf(file, "\n]\n");
+}
+
+void printUsage(const char* programName) {
+    fprintf(stderr, "Usage: %s <trace> [--threads N] [--cpus N] [--json] [--output path] " SWITCH_COST_USAGE
+                    " <policy>[:<parameter>=<v1>,<v2>,...] ...\n", programName);
+    fprintf(stderr, "Policies:");
+    for (unsigned int index = 0; index < sizeof(policies) / sizeof(policies[0]); index++) {
+        if (policies[index].parameter != NULL)
+            fprintf(stderr, " %s[:%s=...]", policies[index].name, policies[index].parameter);
+        else
+            fprintf(stderr, " %s", policies[index].name);
+    }
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char* argv[]) {
+    experiment* experiments = NULL;
+    unsigned int numberOfExperiments = 0;
+    long numberOfThreads = sysconf(_SC_NPROCESSORS_ONLN);
+    const char* numberOfCpus = NULL;
+    bool writeAsJson = false;
+    const char* outputPath = NULL;
+    switchCostModel switchCosts;
+    initSwitchCostModel(&switchCosts);
+
+    if (argc < 3) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    for (int index = 2; index < argc; index++) {
+        int switchCostOption = parseSwitchCostOption(&switchCosts, argc, argv, &index);
+        if (switchCostOption == -1) {
+            printUsage(argv[0]);
+            free(experiments);
+            return 1;
+        } else if (switchCostOption == 1) {
+            continue;
+        } else if (strcmp(argv[index], "--threads") == 0 && index + 1 < argc) {
+            numberOfThreads = strtol(argv[++index], NULL, 10);
+        } else if (strcmp(argv[index], "--cpus") == 0 && index + 1 < argc) {
+            numberOfCpus = argv[++index];
+        } else if (strcmp(argv[index], "--json") == 0) {
+            writeAsJson = true;
+        } else if (strcmp(argv[index], "--output") == 0 && index + 1 < argc) {
+            outputPath = argv[++index];
+        } else if (addExperiments(argv[index], &experiments, &numberOfExperiments) == -1) {
+            free(experiments);
+            return 1;
+        }
+    }
+    if (numberOfExperiments == 0 || numberOfThreads < 1) {
+        printUsage(argv[0]);
+        free(experiments);
+        return 1;
+    }
+    if (numberOfCpus != NULL) {
+        // The count is passed on as it is, so it must be a plain number
+        char* end;
+        unsigned long cpus = strtoul(numberOfCpus, &end, 10);
+        bool validCpus = (*end == '\0' && numberOfCpus[0] >= '1' && numberOfCpus[0] <= '9' && cpus <= UINT_MAX);
+        if (validCpus && (isSwitchCostEnabled(&switchCosts) || switchCosts.calibrate)) {
+            fprintf(stderr, "--cpus: switch costs are only modeled on one CPU\n");
+            free(experiments);
+            return 1;
+        }
+        for (unsigned int index = 0; validCpus && index < numberOfExperiments; index++) {
+            if (!experiments[index].policy->runsOnCpus) {
+                fprintf(stderr, "--cpus: %s only runs on one CPU\n", experiments[index].policy->name);
+                free(experiments);
+                return 1;
+            }
+        }
+        if (!validCpus) {
+            printUsage(argv[0]);
+            free(experiments);
+            return 1;
+        }
+    }
+    if ((unsigned long)numberOfThreads > numberOfExperiments)
+        numberOfThreads = numberOfExperiments;
+    if (prepareSwitchCostModel(&switchCosts) == -1) {
+        free(experiments);
+        return 1;
+    }
+
+    // Load the trace once. Keeping it mapped keeps it in the page cache while the simulators read it.
+    workloadTrace trace;
+    if (openWorkloadTrace(&trace, argv[1]) == -1) {
+        free(experiments);
+        return 1;
+    }
+    madvise(trace.mapping, trace.mappingLength, MADV_WILLNEED);
+
+    // The simulators are next to this program
+    char programDirectory[PATH_MAX];
+    const char* slash = strrchr(argv[0], '/');
+    if (slash != NULL)
+        snprintf(programDirectory, sizeof(programDirectory), "%.*s", (int)(slash - argv[0]), argv[0]);
+    else
+        snprintf(programDirectory, sizeof(programDirectory), ".");
+
+    sweep state = {experiments, numberOfExperiments, 0, PTHREAD_MUTEX_INITIALIZER, programDirectory, argv[1],
+                   isSwitchCostEnabled(&switchCosts) ? &switchCosts : NULL, numberOfCpus};
+    pthread_t* threads = malloc(numberOfThreads * sizeof(pthread_t));
+    if (threads == NULL) {
+        perror("malloc");
+        closeWorkloadTrace(&trace);
+        free(experiments);
+        return 1;
+    }
+
+    fprintf(stderr, "Running %u experiments on %llu tasks with %ld threads\n",
+            numberOfExperiments, (unsigned long long)trace.numberOfRecords, numberOfThreads);
+    long numberOfStartedThreads = 0;
+    for (; numberOfStartedThreads < numberOfThreads; numberOfStartedThreads++) {
+        int error = pthread_create(&threads[numberOfStartedThreads], NULL, workerThread, &state);
+        if (error != 0) {
+            fprintf(stderr, "pthread_create: %s\n", strerror(error));
+            break;
+        }
+    }
+    for (long index = 0; index < numberOfStartedThreads; index++)
+        pthread_join(threads[index], NULL);
+    closeWorkloadTrace(&trace);
+    if (numberOfStartedThreads < numberOfThreads) {
+        free(threads);
+        free(experiments);
+        return 1;
+    }
+
+    FILE* file = stdout;
+    if (outputPath != NULL && (file = fopen(outputPath, "w")) == NULL) {
+        perror("fopen");
+        free(threads);
+        free(experiments);
+        return 1;
+    }
+    if (writeAsJson)
+        writeJson(file, experiments, numberOfExperiments);
+    else
+        writeCsv(file, experiments, numberOfExperiments);
+    if (file != stdout)
+        fclose(file);
+
+    bool allSucceeded = true;
+    for (unsigned int index = 0; index < numberOfExperiments; index++)
+        allSucceeded = allSucceeded && experiments[index].succeeded;
+
+    free(threads);
+    free(experiments);
+    return allSucceeded ? 0 : 1;
+}
@@ -0,0 +1,361 @@
+// scheduling/scheduling_engine.c
+// FCFS, SJF, SRTF, Round Robin, CFS and approximated SJF as plug-ins of the scheduling engine
+// (see scheduling_engine.h), so that they run on identical traces with identical accounting.
+// The standalone programs(first_come_first_serve_scheduling.c, ...) remain the reference for each
+// policy; on any trace, the plug-ins produce the same schedule.
+//
+// Usage: ./scheduling_engine.out          (every policy on a small demo workload)
+//        ./scheduling_engine.out <trace> [--policy name]... [--quantum timeQuantum]
+//               [--latency schedLatency] [--granularity minGranularity] [--metrics]
+//               [--timeline text|gantt|csv|json] [--timeline-output path]
+//               (every policy, or only the given ones, on a workload trace. --metrics prints one line of
+//                key=value pairs instead of the table, for a single policy. --timeline text prints every
+//                run as it happens; the other formats record the runs and render them after each policy
+//                (see timeline.h), to stdout or, for a single policy, to the --timeline-output file.)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "workload_trace.h"
+#include "scheduling_engine.h"
+#include "nice_weights.h"
+
+#define RR_TIME_QUANTUM 3       // Default time quantum of Round Robin
+#define SCHED_LATENCY 8         // Default targeted latency of CFS
+#define MIN_GRANULARITY 1       // Default shortest time slice of CFS
+#define NSEC_PER_UNIT 750000ull // CFS vruntime is counted in nanoseconds, as in completely_fair_scheduling.c
+
+// State shared by every plug-in: each one uses either the FIFO or the heap as its ready set
+typedef struct {
+    slotQueue queue;
+    slotHeap heap;
+    unsigned long long timeQuantum;
+
+    // CFS only(see completely_fair_scheduling.c)
+    unsigned long long schedLatency;
+    unsigned long long minGranularity;
+    unsigned long long loadWeight;      // Sum of the weights of the queued tasks and the current task
+    unsigned int numberOfRunningTasks;
+    unsigned long long minVruntime;
+    int currentSlot;                    // Task on the CPU(-1 when idle)
+    slotQueue pendingArrivals;          // Tasks that arrived while the current task was running
+} policyState;
+
+void* createPolicyState(const policyParameters* parameters) {
+    policyState* state = calloc(1, sizeof(policyState));
+    if (state == NULL) {
+        perror("calloc");
+        return NULL;
+    }
+    state->timeQuantum = (parameters->timeQuantum != 0) ? parameters->timeQuantum : RR_TIME_QUANTUM;
+    state->schedLatency = (parameters->schedLatency != 0) ? parameters->schedLatency : SCHED_LATENCY;
+    state->minGranularity = (parameters->minGranularity != 0) ? parameters->minGranularity : MIN_GRANULARITY;
+    state->currentSlot = -1;
+    return state;
+}
+
+void destroyPolicyState(void* param) {
+    policyState* state = param;
+    free(state->queue.slots);
+    free(state->heap.entries);
+    free(state->pendingArrivals.slots);
+    free(state);
+}
+
+int pickFromQueue(void* param, taskStore* store) {
+    policyState* state = param;
+    (void)store;
+    return popSlot(&state->queue);
+}
+
+int pickFromHeap(void* param, taskStore* store) {
+    policyState* state = param;
+    (void)store;
+    return popHeapSlot(&state->heap);
+}
+
+unsigned long long runToCompletion(void* param, const taskStore* store, unsigned int slot) {
+    (void)param;
+    (void)store;
+    (void)slot;
+    return RUN_TO_COMPLETION;
+}
+
+unsigned long long timeQuantumSlice(void* param, const taskStore* store, unsigned int slot) {
+    policyState* state = param;
+    (void)store;
+    (void)slot;
+    return state->timeQuantum;
+}
+
+// FCFS and Round Robin: tasks are served in the order they joined the queue
+int enqueueAtTail(void* param, taskStore* store, unsigned int slot) {
+    policyState* state = param;
+    (void)store;
+    return pushSlot(&state->queue, slot);
+}
+
+int requeueAtTail(void* param, taskStore* store, unsigned int slot, unsigned long long runTime) {
+    policyState* state = param;
+    (void)store;
+    (void)runTime;
+    return pushSlot(&state->queue, slot);
+}
+
+// SJF: the shortest burst first. In case of tie, the task that arrived first.
+int enqueueByBurst(void* param, taskStore* store, unsigned int slot) {
+    policyState* state = param;
+    return pushHeapSlot(&state->heap, store->cpuBurstTime[slot], store->sequence[slot], slot);
+}
+
+// SRTF: the shortest remaining time first. The remaining time only changes while a task runs.
+int enqueueByRemainingTime(void* param, taskStore* store, unsigned int slot) {
+    policyState* state = param;
+    return pushHeapSlot(&state->heap, store->remainingTime[slot], store->sequence[slot], slot);
+}
+
+int requeueByRemainingTime(void* param, taskStore* store, unsigned int slot, unsigned long long runTime) {
+    (void)runTime;
+    return enqueueByRemainingTime(param, store, slot);
+}
+
+// Approximated SJF: the shortest predicted burst first
+int enqueueByPrediction(void* param, taskStore* store, unsigned int slot) {
+    policyState* state = param;
+    return pushHeapSlot(&state->heap, store->predictedBurst[slot], store->sequence[slot], slot);
+}
+
+int requeueByPrediction(void* param, taskStore* store, unsigned int slot, unsigned long long runTime) {
+    (void)runTime;
+    return enqueueByPrediction(param, store, slot);
+}
+
+// CFS: the lowest vruntime first. In case of tie, the lowest task ID.
+// vruntime advances by the run time in nanoseconds scaled by NICE_0_LOAD / weight(an integer
+// inverse-weight multiply on 64-bit nanoseconds, the same arithmetic as the standalone program),
+// and every task gets its weighted share of schedLatency as its time slice.
+unsigned long long calcDeltaFair(unsigned long long delta, const taskStore* store, unsigned int slot) {
+    int nice = store->nice[slot];
+    if (nice == 0)
+        return delta * NSEC_PER_UNIT;
+    return calcDelta(delta * NSEC_PER_UNIT, NICE_0_LOAD, niceToInverseWeight(nice));
+}
+
+unsigned long long cfsTimeSlice(void* param, const taskStore* store, unsigned int slot) {
+    policyState* state = param;
+    unsigned long long period = state->schedLatency;
+    if (state->numberOfRunningTasks > state->schedLatency / state->minGranularity)
+        period = state->numberOfRunningTasks * state->minGranularity;
+
+    unsigned long long slice = period * niceToWeight(store->nice[slot]) / state->loadWeight;
+    return (slice < state->minGranularity) ? state->minGranularity : slice;
+}
+
+void updateMinVruntime(policyState* state, const taskStore* store) {
+    unsigned long long vruntime = state->minVruntime;
+
+    if (state->currentSlot != -1)
+        vruntime = store->vruntime[state->currentSlot];
+    if (state->heap.size > 0) {
+        if (state->currentSlot == -1 || state->heap.entries[0].key < vruntime)
+            vruntime = state->heap.entries[0].key;
+    }
+
+    if (vruntime > state->minVruntime)
+        state->minVruntime = vruntime;
+}
+
+// A new task starts one virtual slice after min_vruntime
+int placeNewTask(policyState* state, taskStore* store, unsigned int slot) {
+    state->loadWeight += niceToWeight(store->nice[slot]);
+    state->numberOfRunningTasks++;
+    store->vruntime[slot] = state->minVruntime + calcDeltaFair(cfsTimeSlice(state, store, slot), store, slot);
+    return pushHeapSlot(&state->heap, store->vruntime[slot], store->id[slot], slot);
+}
+
+// Tasks that arrive while another one runs are placed once the running task has been charged,
+// as the kernel updates the current task before it enqueues a wakee
+int enqueueCfsTask(void* param, taskStore* store, unsigned int slot) {
+    policyState* state = param;
+    if (state->currentSlot != -1)
+        return pushSlot(&state->pendingArrivals, slot);
+    return placeNewTask(state, store, slot);
+}
+
+int pickCfsTask(void* param, taskStore* store) {
+    policyState* state = param;
+    (void)store;
+    state->currentSlot = popHeapSlot(&state->heap);
+    return state->currentSlot;
+}
+
+int chargeVruntime(void* param, taskStore* store, unsigned int slot, unsigned long long runTime) {
+    policyState* state = param;
+    store->vruntime[slot] += calcDeltaFair(runTime, store, slot);
+    updateMinVruntime(state, store);
+
+    int arrivedSlot;
+    while ((arrivedSlot = popSlot(&state->pendingArrivals)) != -1) {
+        if (placeNewTask(state, store, arrivedSlot) == -1)
+            return -1;
+    }
+
+    state->currentSlot = -1;
+    return pushHeapSlot(&state->heap, store->vruntime[slot], store->id[slot], slot);
+}
+
+void dequeueCfsTask(void* param, taskStore* store, unsigned int slot, unsigned long long runTime) {
+    policyState* state = param;
+    store->vruntime[slot] += calcDeltaFair(runTime, store, slot);
+
+    state->loadWeight -= niceToWeight(store->nice[slot]);
+    state->numberOfRunningTasks--;
+    state->currentSlot = -1;
+    updateMinVruntime(state, store);
+}
+
+static const schedulingPolicy policies[] = {
+    {"fcfs", false, createPolicyState, destroyPolicyState, enqueueAtTail, pickFromQueue, runToCompletion, requeueAtTail, NULL},
+    {"sjf", false, createPolicyState, destroyPolicyState, enqueueByBurst, pickFromHeap, runToCompletion, requeueByRemainingTime, NULL},
+    {"srtf", true, createPolicyState, destroyPolicyState, enqueueByRemainingTime, pickFromHeap, runToCompletion, requeueByRemainingTime, NULL},
+    {"rr", false, createPolicyState, destroyPolicyState, enqueueAtTail, pickFromQueue, timeQuantumSlice, requeueAtTail, NULL},
+    {"cfs", false, createPolicyState, destroyPolicyState, enqueueCfsTask, pickCfsTask, cfsTimeSlice, chargeVruntime, dequeueCfsTask},
+    {"asjf", true, createPolicyState, destroyPolicyState, enqueueByPrediction, pickFromHeap, runToCompletion, requeueByPrediction, NULL}
+};
+
+const schedulingPolicy* findPolicy(const char* name) {
+    for (unsigned int index = 0; index < sizeof(policies) / sizeof(policies[0]); index++) {
+        if (strcmp(policies[index].name, name) == 0)
+            return &policies[index];
+    }
+    return NULL;
+}
+
+// Function to display one row of the comparison table
+void displayPolicySummary(const char* name, const schedulingSummary* summary) {
+    const schedulingMetrics* metrics = &summary->metrics;
+    if (summary->numberOfTasks == 0) {
+        printf("%s\t0\tno tasks\n", name);
+        return;
+    }
+    printf("%s\t%llu\t%.2f\t\t%llu\t\t%.2f\t\t%llu\t\t%.2f\t\t%llu\t\t%llu\t\t%.4f\t\t%llu\n",
+            name,
+            summary->numberOfTasks,
+            (double)summary->totalWaitingTime / summary->numberOfTasks,
+            latencyPercentile(&metrics->waitingTimes, 99),
+            (double)metrics->totalResponseTime / summary->numberOfTasks,
+            latencyPercentile(&metrics->responseTimes, 99),
+            (double)metrics->totalTurnaroundTime / summary->numberOfTasks,
+            latencyPercentile(&metrics->turnaroundTimes, 99),
+            metrics->numberOfContextSwitches,
+            (double)summary->numberOfTasks / summary->totalTime,
+            summary->totalTime);
+}
+
+void printUsage(const char* programName) {
+    fprintf(stderr, "Usage: %s <trace> [--policy name]... [--quantum timeQuantum]\n", programName);
+    fprintf(stderr, "       [--latency schedLatency] [--granularity minGranularity] [--metrics]\n");
+    fprintf(stderr, "       [--timeline text|gantt|csv|json] [--timeline-output path]\n");
+    fprintf(stderr, "Policies:");
+    for (unsigned int index = 0; index < sizeof(policies) / sizeof(policies[0]); index++)
+        fprintf(stderr, " %s", policies[index].name);
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char* argv[]) {
+    const schedulingPolicy* selectedPolicies[sizeof(policies) / sizeof(policies[0])];
+    unsigned int numberOfSelectedPolicies = 0;
+    policyParameters parameters = {0, 0, 0};
+    bool printTimeline = false, printMetrics = false, recordTimeline = false;
+    timelineFormat format = TIMELINE_GANTT;
+    const char* timelinePath = NULL;
+
+    static const workloadRecord records[] = {
+        {.arrivalTime = 0, .cpuBurstTime = 6, .id = 1},
+        {.arrivalTime = 2, .cpuBurstTime = 8, .id = 2},
+        {.arrivalTime = 4, .cpuBurstTime = 7, .id = 3},
+        {.arrivalTime = 6, .cpuBurstTime = 3, .id = 4},
+        {.arrivalTime = 8, .cpuBurstTime = 4, .id = 5}
+    };
+
+    for (int index = 2; index < argc; index++) {
+        if (strcmp(argv[index], "--policy") == 0 && index + 1 < argc) {
+            const schedulingPolicy* policy = findPolicy(argv[++index]);
+            if (policy == NULL || numberOfSelectedPolicies == sizeof(selectedPolicies) / sizeof(selectedPolicies[0])) {
+                printUsage(argv[0]);
+                return 1;
+            }
+            selectedPolicies[numberOfSelectedPolicies++] = policy;
+        } else if (strcmp(argv[index], "--quantum") == 0 && index + 1 < argc) {
+            parameters.timeQuantum = strtoull(argv[++index], NULL, 10);
+        } else if (strcmp(argv[index], "--latency") == 0 && index + 1 < argc) {
+            parameters.schedLatency = strtoull(argv[++index], NULL, 10);
+        } else if (strcmp(argv[index], "--granularity") == 0 && index + 1 < argc) {
+            parameters.minGranularity = strtoull(argv[++index], NULL, 10);
+        } else if (strcmp(argv[index], "--timeline") == 0 && index + 1 < argc && strcmp(argv[index + 1], "text") == 0) {
+            printTimeline = true;
+            index++;
+        } else if (strcmp(argv[index], "--timeline") == 0 && index + 1 < argc && parseTimelineFormat(argv[index + 1], &format) == 0) {
+            recordTimeline = true;
+            index++;
+        } else if (strcmp(argv[index], "--timeline-output") == 0 && index + 1 < argc) {
+            timelinePath = argv[++index];
+        } else if (strcmp(argv[index], "--metrics") == 0) {
+            printMetrics = true;
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (numberOfSelectedPolicies == 0) {
+        for (unsigned int index = 0; index < sizeof(policies) / sizeof(policies[0]); index++)
+            selectedPolicies[numberOfSelectedPolicies++] = &policies[index];
+    }
+    if (((printMetrics || timelinePath != NULL) && numberOfSelectedPolicies != 1) ||
+            (parameters.schedLatency != 0 && parameters.minGranularity > parameters.schedLatency)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if (!printMetrics)
+        printf("Policy\tTasks\tAvg waiting\tp99 waiting\tAvg response\tp99 response\tAvg turnaround\tp99 turnaround\tSwitches\tThroughput\tTotal time\n");
+    for (unsigned int index = 0; index < numberOfSelectedPolicies; index++) {
+        workloadTrace trace;
+        schedulingSummary summary;
+
+        // Every policy replays the trace from the start
+        if (argc > 1) {
+            if (openWorkloadTrace(&trace, argv[1]) == -1)
+                return 1;
+        } else {
+            openWorkloadTraceFromRecords(&trace, records, sizeof(records) / sizeof(records[0]));
+        }
+
+        timeline recordedTimeline;
+        initTimeline(&recordedTimeline);
+        if (printTimeline)
+            printf("\nTimeline of %s:\n", selectedPolicies[index]->name);
+        int result = runPolicy(selectedPolicies[index], &parameters, &trace, printTimeline,
+                recordTimeline ? &recordedTimeline : NULL, &summary);
+        closeWorkloadTrace(&trace);
+        if (result == -1) {
+            destroyTimeline(&recordedTimeline);
+            return 1;
+        }
+
+        if (printMetrics)
+            printSchedulingMetrics(&summary.metrics, summary.numberOfTasks, summary.totalWaitingTime, summary.totalTime);
+        else
+            displayPolicySummary(selectedPolicies[index]->name, &summary);
+        if (recordTimeline) {
+            if (timelinePath == NULL)
+                printf("\nTimeline of %s:\n", selectedPolicies[index]->name);
+            result = writeTimeline(&recordedTimeline, format, timelinePath);
+        }
+        destroyTimeline(&recordedTimeline);
+        if (result == -1)
+            return 1;
+    }
+
+    return 0;
+}
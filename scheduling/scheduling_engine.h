@@ -0,0 +1,259 @@
+// scheduling/scheduling_engine.h
+// A scheduling engine that runs any policy over a workload trace with the same main loop and the
+// same accounting, so that policies can be compared on identical traces.
+//
+// A policy is a plug-in(schedulingPolicy) with four hooks:
+//  - onArrival:  a task was admitted, add it to the ready set
+//  - pickNext:   remove the next task to run from the ready set
+//  - onTick:     the running task used up its time slice(or was preempted by an arrival) and is
+//                still runnable; charge it and put it back
+//  - onComplete: the running task finished after its last run(optional)
+// and a time slice: how long the picked task may run before the next decision. The engine is
+// event-driven: the clock jumps from one decision to the next instead of moving tick by tick.
+//
+// Tasks live in a structure-of-arrays store(task_store.h) and policies refer to them by slot.
+// Two ready set containers are provided for the plug-ins: a FIFO ring of slots and a binary
+// min-heap of slots with the key stored inline.
+#ifndef SCHEDULING_ENGINE_H
+#define SCHEDULING_ENGINE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <limits.h>
+#include "workload_trace.h"
+#include "task_store.h"
+#include "scheduling_metrics.h"
+#include "timeline.h"
+
+#define RUN_TO_COMPLETION ULLONG_MAX    // Time slice of a task that is never preempted by the clock
+
+// Parameters that any policy may read
+typedef struct {
+    unsigned long long timeQuantum;
+    unsigned long long schedLatency;    // Period in which every runnable task should run once(CFS)
+    unsigned long long minGranularity;  // Shortest time slice(CFS)
+} policyParameters;
+
+typedef struct {
+    const char* name;
+    bool preemptOnArrival;              // Whether an arrival forces a new decision
+    void* (*create)(const policyParameters* parameters);
+    void (*destroy)(void* state);
+    int (*onArrival)(void* state, taskStore* store, unsigned int slot);
+    int (*pickNext)(void* state, taskStore* store);                     // -1 if nothing is ready
+    unsigned long long (*timeSlice)(void* state, const taskStore* store, unsigned int slot);
+    int (*onTick)(void* state, taskStore* store, unsigned int slot, unsigned long long runTime);
+    void (*onComplete)(void* state, taskStore* store, unsigned int slot, unsigned long long runTime);
+} schedulingPolicy;
+
+typedef struct {
+    unsigned long long numberOfTasks;       // Number of completed tasks
+    unsigned long long totalWaitingTime;    // Sum of the waiting time of every task
+    unsigned long long totalTime;           // Time when the last task finished
+    schedulingMetrics metrics;
+} schedulingSummary;
+
+// FIFO ready set: a ring buffer of slots. The capacity is a power of two, so wrapping is a mask.
+typedef struct {
+    unsigned int* slots;
+    unsigned int head;
+    unsigned int numberOfSlots;
+    unsigned int capacity;
+} slotQueue;
+
+static inline int pushSlot(slotQueue* queue, unsigned int slot) {
+    if (queue->numberOfSlots == queue->capacity) {
+        unsigned int newCapacity = (queue->capacity == 0) ? 64 : queue->capacity * 2;
+        unsigned int* newSlots = malloc(newCapacity * sizeof(unsigned int));
+        if (newSlots == NULL) {
+            perror("malloc");
+            return -1;
+        }
+        for (unsigned int i = 0; i < queue->numberOfSlots; i++)
+            newSlots[i] = queue->slots[(queue->head + i) & (queue->capacity - 1)];
+        free(queue->slots);
+        queue->slots = newSlots;
+        queue->head = 0;
+        queue->capacity = newCapacity;
+    }
+    queue->slots[(queue->head + queue->numberOfSlots) & (queue->capacity - 1)] = slot;
+    queue->numberOfSlots++;
+    return 0;
+}
+
+static inline int popSlot(slotQueue* queue) {
+    if (queue->numberOfSlots == 0)
+        return -1;
+    unsigned int slot = queue->slots[queue->head];
+    queue->head = (queue->head + 1) & (queue->capacity - 1);
+    queue->numberOfSlots--;
+    return (int)slot;
+}
+
+// Ordered ready set: a binary min-heap on (key, tieBreak). The key is copied into the entry, so
+// sifting never has to look into the task store.
+typedef struct {
+    unsigned long long key;
+    unsigned long long tieBreak;
+    unsigned int slot;
+} slotHeapEntry;
+
+typedef struct {
+    slotHeapEntry* entries;
+    unsigned int size;
+    unsigned int capacity;
+} slotHeap;
+
+static inline bool isEntryBefore(const slotHeapEntry* a, const slotHeapEntry* b) {
+    if (a->key != b->key)
+        return a->key < b->key;
+    return a->tieBreak < b->tieBreak;
+}
+
+static inline int pushHeapSlot(slotHeap* heap, unsigned long long key, unsigned long long tieBreak, unsigned int slot) {
+    if (heap->size == heap->capacity) {
+        unsigned int newCapacity = (heap->capacity == 0) ? 64 : heap->capacity * 2;
+        slotHeapEntry* newEntries = realloc(heap->entries, newCapacity * sizeof(slotHeapEntry));
+        if (newEntries == NULL) {
+            perror("realloc");
+            return -1;
+        }
+        heap->entries = newEntries;
+        heap->capacity = newCapacity;
+    }
+
+    slotHeapEntry entry = {key, tieBreak, slot};
+    unsigned int index = heap->size++;
+    while (index > 0) {
+        unsigned int parent = (index - 1) / 2;
+        if (!isEntryBefore(&entry, &heap->entries[parent]))
+            break;
+        heap->entries[index] = heap->entries[parent];
+        index = parent;
+    }
+    heap->entries[index] = entry;
+    return 0;
+}
+
+static inline int popHeapSlot(slotHeap* heap) {
+    if (heap->size == 0)
+        return -1;
+
+    unsigned int slot = heap->entries[0].slot;
+    slotHeapEntry last = heap->entries[--heap->size];
+    unsigned int index = 0;
+    while (true) {
+        unsigned int child = 2 * index + 1;
+        if (child >= heap->size)
+            break;
+        if (child + 1 < heap->size && isEntryBefore(&heap->entries[child + 1], &heap->entries[child]))
+            child++;
+        if (!isEntryBefore(&heap->entries[child], &last))
+            break;
+        heap->entries[index] = heap->entries[child];
+        index = child;
+    }
+    if (heap->size > 0)
+        heap->entries[index] = last;
+    return (int)slot;
+}
+
+// Function to admit the tasks that have arrived by now and hand them to the policy
+static inline int admitArrivals(const schedulingPolicy* policy, void* state, taskStore* store,
+        workloadTrace* trace, unsigned long long currentTimestamp, unsigned long long* numberOfAdmittedTasks) {
+    while (hasArrivalBy(trace, currentTimestamp)) {
+        int slot = addTask(store, nextWorkloadRecord(trace), (*numberOfAdmittedTasks)++);
+        if (slot == -1 || policy->onArrival(state, store, slot) == -1)
+            return -1;
+    }
+    return 0;
+}
+
+// Function to run a policy over a trace
+// If printTimeline is true, every run of a task is printed as it happens.
+// If recordedTimeline is not NULL, every run of a task is recorded into it.
+static inline int runPolicy(const schedulingPolicy* policy, const policyParameters* parameters,
+        workloadTrace* trace, bool printTimeline, timeline* recordedTimeline, schedulingSummary* summary) {
+    taskStore store;
+    unsigned long long currentTimestamp = 0;
+    unsigned long long numberOfAdmittedTasks = 0;
+    int result = 0;
+
+    summary->numberOfTasks = 0;
+    summary->totalWaitingTime = 0;
+    summary->totalTime = 0;
+    initSchedulingMetrics(&summary->metrics);
+
+    void* state = policy->create(parameters);
+    if (state == NULL)
+        return -1;
+    initTaskStore(&store);
+
+    while (true) {
+        if (admitArrivals(policy, state, &store, trace, currentTimestamp, &numberOfAdmittedTasks) == -1) {
+            result = -1;
+            break;
+        }
+
+        int slot = policy->pickNext(state, &store);
+        const workloadRecord* nextArrival = peekWorkloadRecord(trace);
+        if (slot == -1) {
+            if (nextArrival == NULL)
+                break;  // Every task is completed
+
+            // Nothing is ready, so jump over the idle gap to the next arrival
+            currentTimestamp = nextArrival->arrivalTime;
+            continue;
+        }
+
+        if (!store.started[slot]) {
+            store.startTime[slot] = currentTimestamp;
+            store.started[slot] = true;
+        }
+        recordDispatch(&summary->metrics, store.id[slot]);
+
+        // Run the task until it completes, its time slice ends, or(if arrivals preempt) the next task arrives
+        unsigned long long runTime = store.remainingTime[slot];
+        unsigned long long timeSlice = policy->timeSlice(state, &store, slot);
+        if (timeSlice < runTime)
+            runTime = timeSlice;
+        if (policy->preemptOnArrival && nextArrival != NULL && nextArrival->arrivalTime - currentTimestamp < runTime)
+            runTime = nextArrival->arrivalTime - currentTimestamp;
+
+        if (printTimeline)
+            printf("From timestamp %llu to %llu, task %u is running.\n", currentTimestamp, currentTimestamp + runTime, store.id[slot]);
+        if (recordedTimeline != NULL && recordRun(recordedTimeline, store.id[slot], currentTimestamp, runTime) == -1) {
+            result = -1;
+            break;
+        }
+        currentTimestamp += runTime;
+        store.remainingTime[slot] -= runTime;
+
+        if (store.remainingTime[slot] == 0) {
+            // Every moment between the arrival and the end that the task was not running, it was waiting
+            unsigned long long waitingTime = currentTimestamp - store.arrivalTime[slot] - store.cpuBurstTime[slot];
+            summary->totalWaitingTime += waitingTime;
+            summary->totalTime = currentTimestamp;
+            summary->numberOfTasks++;
+            recordCompletion(&summary->metrics, store.arrivalTime[slot], store.startTime[slot], currentTimestamp, waitingTime);
+
+            if (policy->onComplete != NULL)
+                policy->onComplete(state, &store, slot, runTime);
+            removeTask(&store, slot);
+        } else {
+            // Tasks that arrived while this one was running are admitted before it goes back
+            if (admitArrivals(policy, state, &store, trace, currentTimestamp, &numberOfAdmittedTasks) == -1 ||
+                    policy->onTick(state, &store, slot, runTime) == -1) {
+                result = -1;
+                break;
+            }
+        }
+    }
+
+    policy->destroy(state);
+    destroyTaskStore(&store);
+    return result;
+}
+
+#endif
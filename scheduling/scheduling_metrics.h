@@ -0,0 +1,103 @@
+// scheduling/scheduling_metrics.h
+// Per-run metrics shared by the simulators: tail latencies and context switches, collected as
+// tasks are dispatched and completed so that nothing has to be stored per task.
+// Waiting(time spent ready but not running), response(time from the arrival to the first run) and
+// turnaround(time from the arrival to the end) each go into a log-bucketed histogram(latency_histogram.h),
+// so p50/p90/p99/p99.9 and the maximum are available in constant memory, however many tasks there are.
+//
+// Every simulator prints them with "--metrics" as a single line of key=value pairs, which is what
+// the parameter sweep(scheduler_sweep.c) reads back.
+#ifndef SCHEDULING_METRICS_H
+#define SCHEDULING_METRICS_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "latency_histogram.h"
+
+typedef struct {
+    unsigned long long numberOfContextSwitches;     // Dispatches of a task other than the one that ran last
+    unsigned long long totalTurnaroundTime;         // Sum of end - arrival of every task
+    unsigned long long totalResponseTime;           // Sum of start - arrival of every task
+    latencyHistogram waitingTimes;
+    latencyHistogram responseTimes;
+    latencyHistogram turnaroundTimes;
+    unsigned int lastTaskId;                        // Task that ran last
+    bool hasLastTask;
+} schedulingMetrics;
+
+static inline void initSchedulingMetrics(schedulingMetrics* metrics) {
+    metrics->numberOfContextSwitches = 0;
+    metrics->totalTurnaroundTime = 0;
+    metrics->totalResponseTime = 0;
+    initLatencyHistogram(&metrics->waitingTimes);
+    initLatencyHistogram(&metrics->responseTimes);
+    initLatencyHistogram(&metrics->turnaroundTimes);
+    metrics->lastTaskId = 0;
+    metrics->hasLastTask = false;
+}
+
+// Function to record that a task got the CPU. Running the same task again is not a context switch.
+static inline void recordDispatch(schedulingMetrics* metrics, unsigned int id) {
+    if (!metrics->hasLastTask || metrics->lastTaskId != id)
+        metrics->numberOfContextSwitches++;
+    metrics->lastTaskId = id;
+    metrics->hasLastTask = true;
+}
+
+// Function to record a completed task: it arrived, first ran at startTime, and finished at endTime
+static inline void recordCompletion(schedulingMetrics* metrics, unsigned long long arrivalTime,
+        unsigned long long startTime, unsigned long long endTime, unsigned long long waitingTime) {
+    metrics->totalTurnaroundTime += endTime - arrivalTime;
+    metrics->totalResponseTime += startTime - arrivalTime;
+    recordLatency(&metrics->waitingTimes, waitingTime);
+    recordLatency(&metrics->responseTimes, startTime - arrivalTime);
+    recordLatency(&metrics->turnaroundTimes, endTime - arrivalTime);
+}
+
+// Function to add the metrics of source(e.g. one CPU) into destination
+static inline void mergeSchedulingMetrics(schedulingMetrics* destination, const schedulingMetrics* source) {
+    destination->numberOfContextSwitches += source->numberOfContextSwitches;
+    destination->totalTurnaroundTime += source->totalTurnaroundTime;
+    destination->totalResponseTime += source->totalResponseTime;
+    mergeLatencyHistogram(&destination->waitingTimes, &source->waitingTimes);
+    mergeLatencyHistogram(&destination->responseTimes, &source->responseTimes);
+    mergeLatencyHistogram(&destination->turnaroundTimes, &source->turnaroundTimes);
+}
+
+// Function to print the percentiles of the waiting, response and turnaround times as a table
+static inline void printLatencyReport(const schedulingMetrics* metrics) {
+    const char* names[3] = {"Waiting", "Response", "Turnaround"};
+    const latencyHistogram* histograms[3] = {&metrics->waitingTimes, &metrics->responseTimes, &metrics->turnaroundTimes};
+
+    printf("%-12s%10s%10s%10s%10s%10s\n", "Time", "p50", "p90", "p99", "p99.9", "max");
+    for (int index = 0; index < 3; index++) {
+        printf("%-12s%10llu%10llu%10llu%10llu%10llu\n", names[index],
+                latencyPercentile(histograms[index], 50), latencyPercentile(histograms[index], 90),
+                latencyPercentile(histograms[index], 99), latencyPercentile(histograms[index], 99.9),
+                histograms[index]->maxValue);
+    }
+}
+
+// Function to print the metrics of a run as one line of key=value pairs.
+// New keys are only ever appended, so that readers of the older keys keep working.
+static inline void printSchedulingMetrics(const schedulingMetrics* metrics, unsigned long long numberOfTasks,
+        unsigned long long totalWaitingTime, unsigned long long totalTime) {
+    printf("tasks=%llu total_time=%llu throughput=%.6f mean_waiting=%.6f p99_waiting=%llu "
+           "mean_turnaround=%.6f p99_turnaround=%llu context_switches=%llu "
+           "mean_response=%.6f p99_response=%llu p50_waiting=%llu p90_waiting=%llu p999_waiting=%llu max_waiting=%llu\n",
+            numberOfTasks, totalTime,
+            totalTime > 0 ? (double)numberOfTasks / totalTime : 0.0,
+            numberOfTasks > 0 ? (double)totalWaitingTime / numberOfTasks : 0.0,
+            latencyPercentile(&metrics->waitingTimes, 99),
+            numberOfTasks > 0 ? (double)metrics->totalTurnaroundTime / numberOfTasks : 0.0,
+            latencyPercentile(&metrics->turnaroundTimes, 99),
+            metrics->numberOfContextSwitches,
+            numberOfTasks > 0 ? (double)metrics->totalResponseTime / numberOfTasks : 0.0,
+            latencyPercentile(&metrics->responseTimes, 99),
+            latencyPercentile(&metrics->waitingTimes, 50),
+            latencyPercentile(&metrics->waitingTimes, 90),
+            latencyPercentile(&metrics->waitingTimes, 99.9),
+            metrics->waitingTimes.maxValue);
+}
+
+#endif
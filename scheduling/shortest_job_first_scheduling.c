@@ -1,52 +1,260 @@
 // scheduling/shortest_job_first_scheduling.c
+// Non-preemptive SJF(Shortest Job First): whenever the CPU is free, the shortest of the tasks that
+// have arrived runs to completion. Ties go to the task that arrived first.
+// The tasks that have arrived are kept in a min-heap on their burst time, so every decision is
+// O(log n). When every task arrives at t=0, the schedule is simply the tasks in the order of their
+// burst time, and a radix sort on the burst times gives that order in linear time.
+// Tasks are streamed from a workload trace, and only the tasks that have arrived but not run yet
+// are kept in memory: all of them when every task arrives at t=0, only the backlog otherwise.
+// Usage: ./shortest_job_first_scheduling.out          (small demo with a Gantt chart)
+//        ./shortest_job_first_scheduling.out <trace> [--metrics]
+//               (schedule the tasks of a workload trace, summary only. --metrics prints one line of
+//                key=value pairs instead.)
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "workload_trace.h"
+#include "scheduling_metrics.h"
+
+#define RADIX_BITS 8                            // Bits of the burst time sorted by each pass of the radix sort
+#define RADIX_BUCKETS (1 << RADIX_BITS)
 
 // Define the task struct
 typedef struct {
-    unsigned int id;            // Task ID
-    unsigned int cpuBurstTime;  // Time the task needs on the CPU
-    unsigned int waitingTime;   // Time the task has waited in the queue
-    unsigned int startTime;     // Time when the task starts execution
-    unsigned int endTime;       // Time when the task finishes execution
+    unsigned int id;                    // Task ID
+    unsigned long long cpuBurstTime;    // Time the task needs on the CPU
+    unsigned long long arrivalTime;     // Time when the task arrives in the system
+    unsigned long long waitingTime;     // Time the task has waited in the queue
+    unsigned long long startTime;       // Time when the task starts execution
+    unsigned long long endTime;         // Time when the task finishes execution
+    unsigned long long sequence;        // Order of arrival, used to break ties
 } task;
 
-// Function to sort tasks based on their CPU burst time
-// SJF assumes that all task CPU burst time information is available(known)
-void sortTasksByCPUBurst(task tasks[], unsigned int numberOfTasks) {
-    for (unsigned int i = 0; i < numberOfTasks - 1; i++) {
-        for (unsigned int j = i + 1; j < numberOfTasks; j++) {
-            if (tasks[i].cpuBurstTime > tasks[j].cpuBurstTime) {
-                task temporary = tasks[i];
-                tasks[i] = tasks[j];
-                tasks[j] = temporary;
-            }
+// Tasks that have arrived but not run yet. They are appended in the order of their arrival until
+// the first decision, and kept as a min-heap on (burst time, sequence) from then on.
+typedef struct {
+    task* tasks;
+    unsigned long long numberOfTasks;
+    unsigned long long capacity;
+} readyTasks;
+
+typedef struct {
+    unsigned long long numberOfTasks;       // Number of completed tasks
+    unsigned long long totalWaitingTime;    // Sum of the waiting time of every task
+    unsigned long long totalTime;           // Time when the last task finished
+    schedulingMetrics metrics;
+} schedulingSummary;
+
+// Function to append a task to the arrived tasks, without ordering them
+int appendReadyTask(readyTasks* ready, const task* newTask) {
+    if (ready->numberOfTasks == ready->capacity) {
+        unsigned long long newCapacity = (ready->capacity == 0) ? 64 : ready->capacity * 2;
+        task* newTasks = realloc(ready->tasks, newCapacity * sizeof(task));
+        if (newTasks == NULL) {
+            perror("realloc");
+            return -1;
         }
+        ready->tasks = newTasks;
+        ready->capacity = newCapacity;
     }
+    ready->tasks[ready->numberOfTasks++] = *newTask;
+    return 0;
 }
 
-// Function to calculate start, waiting, and end times for SJF scheduling
-void calculateTimes(task tasks[], int numberOfTasks, unsigned int* totalWaitingTime) {
-    unsigned int currentTime = 0;
-    *totalWaitingTime = 0;
+// Function to sort tasks based on their CPU burst time, O(n) per pass.
+// An LSD radix sort: each pass is a stable counting sort on the next RADIX_BITS of the burst time,
+// starting from the lowest ones. Passes stop once the bits left are zero for every task, so short
+// bursts take one or two passes. Being stable, it keeps tasks with the same burst in arrival order.
+int sortTasksByCPUBurst(task tasks[], unsigned long long numberOfTasks) {
+    unsigned long long maxBurstTime = 0;
+    for (unsigned long long index = 0; index < numberOfTasks; index++) {
+        if (tasks[index].cpuBurstTime > maxBurstTime)
+            maxBurstTime = tasks[index].cpuBurstTime;
+    }
+
+    task* buffer = malloc(numberOfTasks * sizeof(task));
+    if (buffer == NULL) {
+        perror("malloc");
+        return -1;
+    }
+
+    task* source = tasks;
+    task* destination = buffer;
+    for (unsigned int shift = 0; shift < 64 && (maxBurstTime >> shift) != 0; shift += RADIX_BITS) {
+        unsigned long long counts[RADIX_BUCKETS] = {0};
+        for (unsigned long long index = 0; index < numberOfTasks; index++)
+            counts[(source[index].cpuBurstTime >> shift) & (RADIX_BUCKETS - 1)]++;
 
-    for (unsigned int index = 0; index < numberOfTasks; index++) {
-        tasks[index].startTime = currentTime;
-        tasks[index].waitingTime = currentTime;             // Waiting time is the time the task waits in the queue
-        currentTime += tasks[index].cpuBurstTime;
-        tasks[index].endTime = currentTime;
-        *totalWaitingTime += tasks[index].waitingTime;
+        // Turn the counts into the position of the first task of each bucket
+        unsigned long long position = 0;
+        for (unsigned int bucket = 0; bucket < RADIX_BUCKETS; bucket++) {
+            unsigned long long count = counts[bucket];
+            counts[bucket] = position;
+            position += count;
+        }
+
+        for (unsigned long long index = 0; index < numberOfTasks; index++)
+            destination[counts[(source[index].cpuBurstTime >> shift) & (RADIX_BUCKETS - 1)]++] = source[index];
+
+        task* temporary = source;
+        source = destination;
+        destination = temporary;
     }
+
+    // After an odd number of passes, the sorted tasks are in the buffer
+    if (source != tasks)
+        memcpy(tasks, source, numberOfTasks * sizeof(task));
+    free(buffer);
+    return 0;
+}
+
+// Function to run a task from currentTime to completion and account for it. Returns the time it ends.
+unsigned long long runTask(task* currentTask, unsigned long long currentTime, task scheduledTasks[], schedulingSummary* summary) {
+    currentTask->startTime = currentTime;
+    currentTask->waitingTime = currentTime - currentTask->arrivalTime;     // Waiting time is the time the task waits in the queue
+    currentTime += currentTask->cpuBurstTime;
+    currentTask->endTime = currentTime;
+    recordDispatch(&summary->metrics, currentTask->id);
+    recordCompletion(&summary->metrics, currentTask->arrivalTime, currentTask->startTime, currentTask->endTime, currentTask->waitingTime);
+
+    summary->totalWaitingTime += currentTask->waitingTime;
+    summary->totalTime = currentTime;
+    if (scheduledTasks != NULL)
+        scheduledTasks[summary->numberOfTasks] = *currentTask;
+    summary->numberOfTasks++;
+    return currentTime;
+}
+
+// Tasks that have arrived are ordered by burst time. Ties go to the one that arrived first.
+bool isTaskBefore(const task* a, const task* b) {
+    if (a->cpuBurstTime != b->cpuBurstTime)
+        return a->cpuBurstTime < b->cpuBurstTime;
+    return a->sequence < b->sequence;
+}
+
+// Function to move a task down the min-heap from index until it is in order
+void siftDownReadyTask(readyTasks* ready, unsigned long long index, task movedTask) {
+    while (true) {
+        unsigned long long child = 2 * index + 1;
+        if (child >= ready->numberOfTasks)
+            break;
+        if (child + 1 < ready->numberOfTasks && isTaskBefore(&ready->tasks[child + 1], &ready->tasks[child]))
+            child++;
+        if (!isTaskBefore(&ready->tasks[child], &movedTask))
+            break;
+        ready->tasks[index] = ready->tasks[child];
+        index = child;
+    }
+    ready->tasks[index] = movedTask;
+}
+
+// Function to turn the arrived tasks into a min-heap, O(n)
+void buildReadyHeap(readyTasks* ready) {
+    for (unsigned long long index = ready->numberOfTasks / 2; index > 0; index--)
+        siftDownReadyTask(ready, index - 1, ready->tasks[index - 1]);
+}
+
+// Function to add a task to the min-heap of arrived tasks, O(log n)
+int pushReadyTask(readyTasks* ready, const task* newTask) {
+    if (appendReadyTask(ready, newTask) == -1)
+        return -1;
+
+    unsigned long long index = ready->numberOfTasks - 1;
+    while (index > 0) {
+        unsigned long long parent = (index - 1) / 2;
+        if (!isTaskBefore(newTask, &ready->tasks[parent]))
+            break;
+        ready->tasks[index] = ready->tasks[parent];
+        index = parent;
+    }
+    ready->tasks[index] = *newTask;
+    return 0;
+}
+
+// Function to take the shortest arrived task off the min-heap, O(log n)
+task popReadyTask(readyTasks* ready) {
+    task shortestTask = ready->tasks[0];
+    task lastTask = ready->tasks[--ready->numberOfTasks];
+    if (ready->numberOfTasks > 0)
+        siftDownReadyTask(ready, 0, lastTask);
+    return shortestTask;
+}
+
+// Function to admit every task that has arrived by currentTime, in the order of their arrival
+int admitArrivedTasks(readyTasks* ready, workloadTrace* trace, unsigned long long currentTime, unsigned long long* sequence,
+        int (*admit)(readyTasks*, const task*)) {
+    while (hasArrivalBy(trace, currentTime)) {
+        const workloadRecord* record = nextWorkloadRecord(trace);
+        task newTask = {record->id, record->cpuBurstTime, record->arrivalTime, 0, 0, 0, (*sequence)++};
+        if (admit(ready, &newTask) == -1)
+            return -1;
+    }
+    return 0;
+}
+
+// Function to run SJF on the tasks of a trace, streamed in the order of their arrival.
+// Only the tasks that have arrived but not run are kept in memory. When every task arrives at t=0,
+// the schedule is the tasks sorted by burst time; otherwise they go through the min-heap.
+// If scheduledTasks is not NULL, every task is copied into it in the order the tasks ran.
+int runSJF(workloadTrace* trace, task scheduledTasks[], schedulingSummary* summary) {
+    readyTasks ready = {NULL, 0, 0};
+    unsigned long long currentTime = 0, sequence = 0;
+
+    summary->numberOfTasks = 0;
+    summary->totalWaitingTime = 0;
+    summary->totalTime = 0;
+    initSchedulingMetrics(&summary->metrics);
+
+    if (admitArrivedTasks(&ready, trace, 0, &sequence, appendReadyTask) == -1) {
+        free(ready.tasks);
+        return -1;
+    }
+    if (peekWorkloadRecord(trace) == NULL) {
+        // Every task arrives at t=0
+        if (sortTasksByCPUBurst(ready.tasks, ready.numberOfTasks) == -1) {
+            free(ready.tasks);
+            return -1;
+        }
+        for (unsigned long long index = 0; index < ready.numberOfTasks; index++)
+            currentTime = runTask(&ready.tasks[index], currentTime, scheduledTasks, summary);
+        free(ready.tasks);
+        return 0;
+    }
+
+    buildReadyHeap(&ready);
+    while (true) {
+        if (ready.numberOfTasks == 0) {
+            // The CPU stays idle until the next task arrives
+            const workloadRecord* nextArrival = peekWorkloadRecord(trace);
+            if (nextArrival == NULL)
+                break;      // Every task is completed
+            if (currentTime < nextArrival->arrivalTime)
+                currentTime = nextArrival->arrivalTime;
+        }
+        if (admitArrivedTasks(&ready, trace, currentTime, &sequence, pushReadyTask) == -1) {
+            free(ready.tasks);
+            return -1;
+        }
+
+        // We assume this scheduling is not preemptive: the shortest task runs to completion
+        task currentTask = popReadyTask(&ready);
+        currentTime = runTask(&currentTask, currentTime, scheduledTasks, summary);
+    }
+
+    free(ready.tasks);
+    return 0;
 }
 
 // Function to display the scheduling results as a Gantt chart
-void displayGanttChart(task tasks[], int numberOfTasks) {
+void displayGanttChart(task tasks[], unsigned int numberOfTasks) {
     printf("\nGantt Chart:\n");
 
     // Display the task IDs in Gantt chart format
     printf("Task ID:   ");
     for (unsigned int index = 0; index < numberOfTasks; index++) {
-        printf("T%d ", tasks[index].id);
-        for (unsigned int time = 1; time < tasks[index].cpuBurstTime; time++) {
+        printf("T%u ", tasks[index].id);
+        for (unsigned long long time = 1; time < tasks[index].cpuBurstTime; time++) {
             printf("  ");  // Add spaces for the duration of the task
         }
     }
@@ -55,32 +263,50 @@ void displayGanttChart(task tasks[], int numberOfTasks) {
     // Display the timeline (start and end times) beneath the task IDs
     printf("Time:      ");
     for (unsigned int index = 0; index < numberOfTasks; index++) {
-        printf("%d", tasks[index].startTime);
-        for (unsigned int time = 1; time <= tasks[index].cpuBurstTime; time++) {
+        printf("%llu", tasks[index].startTime);
+        for (unsigned long long time = 1; time <= tasks[index].cpuBurstTime; time++) {
             printf("--");
         }
     }
-    printf("%d\n", tasks[numberOfTasks - 1].endTime);
+    printf("%llu\n", tasks[numberOfTasks - 1].endTime);
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    workloadTrace trace;
+    schedulingSummary summary;
+    bool printMetrics = false;
     // Assume the tasks are sorted based on their arrival time
-    task tasks[] = {
-        {1, 5, 0, 0, 0},
-        {2, 3, 0, 0, 0},
-        {3, 8, 0, 0, 0},
-        {4, 6, 0, 0, 0} 
+    static const workloadRecord records[] = {
+        {.arrivalTime = 0, .cpuBurstTime = 5, .id = 1},
+        {.arrivalTime = 0, .cpuBurstTime = 3, .id = 2},
+        {.arrivalTime = 0, .cpuBurstTime = 8, .id = 3},
+        {.arrivalTime = 0, .cpuBurstTime = 6, .id = 4}
     };
+    // Only the demo keeps the tasks, for its Gantt chart
+    task demoTasks[sizeof(records) / sizeof(records[0])];
 
-    unsigned int numberOfTasks = sizeof(tasks) / sizeof(tasks[0]);
+    if (argc > 1) {
+        printMetrics = (argc > 2 && strcmp(argv[2], "--metrics") == 0);
+        if (openWorkloadTrace(&trace, argv[1]) == -1)
+            return 1;
+    } else {
+        openWorkloadTraceFromRecords(&trace, records, sizeof(records) / sizeof(records[0]));
+    }
 
-    sortTasksByCPUBurst(tasks, numberOfTasks);
-    unsigned int totalWaitingTime;
-    calculateTimes(tasks, numberOfTasks, &totalWaitingTime);
-    displayGanttChart(tasks, numberOfTasks);
+    int result = runSJF(&trace, (argc == 1) ? demoTasks : NULL, &summary);
+    closeWorkloadTrace(&trace);
+    if (result == -1)
+        return 1;
 
-    printf("Total Waiting Time: %d\n", totalWaitingTime);
-    printf("Average Waiting Time: %f\n", (float)totalWaitingTime / numberOfTasks);
+    if (printMetrics) {
+        printSchedulingMetrics(&summary.metrics, summary.numberOfTasks, summary.totalWaitingTime, summary.totalTime);
+        return 0;
+    }
+    if (argc == 1)
+        displayGanttChart(demoTasks, (unsigned int)summary.numberOfTasks);
 
+    printf("Total Waiting Time: %llu\n", summary.totalWaitingTime);
+    printf("Average Waiting Time: %f\n", summary.numberOfTasks > 0 ? (double)summary.totalWaitingTime / summary.numberOfTasks : 0.0);
+    printLatencyReport(&summary.metrics);
     return 0;
 }
@@ -1,153 +1,670 @@
 // scheduling/shortest_remaining_time_first.c
 // It is a priority scheduling algorithm where the process with the smallest amount of time remaining until completion is selected to execute.
+// Tasks are streamed from a workload trace, and only the tasks that have arrived but not
+// completed are kept in memory. Ready tasks are kept in an indexed binary heap on the remaining
+// time, so each decision is O(log n).
+//
+// Usage: ./shortest_remaining_time_first.out          (small demo with a full timeline)
+//        ./shortest_remaining_time_first.out <trace> [--metrics] [--timeline gantt|csv|json] [--timeline-output path]
+//               (replay a workload trace, summary only. --metrics prints one line of key=value pairs instead.
+//                --timeline records the runs and renders them once the simulation is over(see timeline.h).)
+//        ./shortest_remaining_time_first.out <trace> [--checkpoint path] [--checkpoint-every events] [--until timestamp]
+//               [--resume path] [--metrics]
+//               (write a snapshot of the simulation every so many events(10^7 by default), and stop after
+//                a last one once the clock reaches timestamp. --resume picks a run up from its snapshot, on
+//                the same trace. See simulation_checkpoint.h.)
+//        ./shortest_remaining_time_first.out --benchmark [scanTimeBudget]
+//               (compare the heap against a linear scan on 10^3 to 10^7 tasks, 300 seconds by default)
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <stdbool.h>
 #include <limits.h>
+#include <time.h>
+#include "workload_trace.h"
+#include "scheduling_metrics.h"
+#include "timeline.h"
+#include "simulation_checkpoint.h"
 
 // Define the task structure
 typedef struct {
-    unsigned int id;            // Task ID
-    unsigned int cpuBurstTime;  // Total CPU time required by the task
-    unsigned int remainingTime; // Time left for the task to finish
-    unsigned int arrivalTime;   // Time when the task arrives in the system
-    unsigned int startTime;     // Time when the task starts execution
-    unsigned int endTime;       // Time when the task finishes execution
-    unsigned int waitingTime;   // Total time the task has been waiting
-    bool started;               // Whether the task has started running
+    unsigned int id;                    // Task ID
+    unsigned long long cpuBurstTime;    // Total CPU time required by the task
+    unsigned long long remainingTime;   // Time left for the task to finish
+    unsigned long long arrivalTime;     // Time when the task arrives in the system
+    unsigned long long startTime;       // Time when the task starts execution
+    unsigned long long endTime;         // Time when the task finishes execution
+    unsigned long long waitingTime;     // Total time the task has been waiting
+    bool started;                       // Whether the task has started running
+    unsigned long long sequence;        // Order of admission. Tasks are admitted in the order of arrival.
+    unsigned int heapIndex;             // Position of the task in the ready queue heap
 } task;
 
-// Function to get the next task index based on SRTF
-int getNextTaskSRTF(task tasks[], unsigned int numberOfTasks, unsigned int currentTimestamp) {
-    int minTaskIndex = -1;
-    unsigned int minRemainingTime = UINT_MAX;
+// Ready queue: an indexed binary min-heap over task slots, keyed on the remaining time.
+// Every task remembers where it is in the heap, so its key can be changed in place(decrease-key).
+// The running task stays at the top of the heap while it runs.
+typedef struct {
+    task* tasks;                    // Task slots. The slot of a completed task is reused by a later arrival.
+    unsigned int capacity;          // Number of slots
+    unsigned int* freeSlots;        // Stack of unused slots
+    unsigned int numberOfFreeSlots;
+    unsigned int* heap;             // Slots of the ready tasks in heap order
+    unsigned int heapSize;
+    bool borrowed;                  // Whether the arrays are sections of the checkpoint the run resumed from.
+                                    // They are then copied out before they grow, and never freed.
+} readyQueue;
 
-    for (unsigned int index = 0; index < numberOfTasks; index++) {
-        if (tasks[index].arrivalTime <= currentTimestamp && tasks[index].remainingTime > 0) {
-            if (tasks[index].remainingTime < minRemainingTime) {
-                minRemainingTime = tasks[index].remainingTime;
-                minTaskIndex = index;
-            }
-            // In case of tie, choose the task with earlier arrival time
-            else if (tasks[index].remainingTime == minRemainingTime) {
-                if (tasks[index].arrivalTime < tasks[minTaskIndex].arrivalTime) {
-                    minTaskIndex = index;
-                }
-            }
+typedef struct {
+    unsigned long long numberOfTasks;       // Number of completed tasks
+    unsigned long long totalWaitingTime;    // Sum of the waiting time of every task
+    unsigned long long totalTime;           // Time when the last task finished
+    schedulingMetrics metrics;
+} schedulingSummary;
+
+// The scalars of a run of runSRTF(), the first section of its checkpoints.
+// The other sections are the task slots, the free slot stack and the heap, each capacity entries long.
+typedef struct {
+    unsigned long long currentTimestamp;
+    unsigned long long numberOfAdmittedTasks;
+    int currentTaskSlot;
+    unsigned int capacity;
+    unsigned int numberOfFreeSlots;
+    unsigned int heapSize;
+    schedulingSummary summary;
+} srtfCheckpointState;
+
+// Shorter remaining time first. In case of tie, choose the task with earlier arrival time.
+bool isTaskBefore(const task* a, const task* b) {
+    if (a->remainingTime != b->remainingTime)
+        return a->remainingTime < b->remainingTime;
+    return a->sequence < b->sequence;
+}
+
+void swapHeapEntries(readyQueue* queue, unsigned int i, unsigned int j) {
+    unsigned int slot = queue->heap[i];
+    queue->heap[i] = queue->heap[j];
+    queue->heap[j] = slot;
+    queue->tasks[queue->heap[i]].heapIndex = i;
+    queue->tasks[queue->heap[j]].heapIndex = j;
+}
+
+void siftUp(readyQueue* queue, unsigned int index) {
+    while (index > 0) {
+        unsigned int parent = (index - 1) / 2;
+        if (!isTaskBefore(&queue->tasks[queue->heap[index]], &queue->tasks[queue->heap[parent]]))
+            break;
+        swapHeapEntries(queue, index, parent);
+        index = parent;
+    }
+}
+
+void siftDown(readyQueue* queue, unsigned int index) {
+    while (true) {
+        unsigned int smallest = index;
+        unsigned int left = 2 * index + 1;
+        unsigned int right = 2 * index + 2;
+
+        if (left < queue->heapSize && isTaskBefore(&queue->tasks[queue->heap[left]], &queue->tasks[queue->heap[smallest]]))
+            smallest = left;
+        if (right < queue->heapSize && isTaskBefore(&queue->tasks[queue->heap[right]], &queue->tasks[queue->heap[smallest]]))
+            smallest = right;
+        if (smallest == index)
+            break;
+        swapHeapEntries(queue, index, smallest);
+        index = smallest;
+    }
+}
+
+// Function to make room for more tasks by doubling the number of slots
+int growReadyQueue(readyQueue* queue) {
+    unsigned int newCapacity = (queue->capacity == 0) ? 64 : queue->capacity * 2;
+    if (queue->borrowed) {
+        // The arrays are still in the checkpoint mapping, which cannot be resized
+        task* newTasks = malloc(newCapacity * sizeof(task));
+        unsigned int* newFreeSlots = malloc(newCapacity * sizeof(unsigned int));
+        unsigned int* newHeap = malloc(newCapacity * sizeof(unsigned int));
+        if (newTasks == NULL || newFreeSlots == NULL || newHeap == NULL) {
+            perror("malloc");
+            free(newTasks);
+            free(newFreeSlots);
+            free(newHeap);
+            return -1;
+        }
+        if (queue->capacity > 0) {
+            // Empty sections are not mapped: the arrays are NULL then
+            memcpy(newTasks, queue->tasks, queue->capacity * sizeof(task));
+            memcpy(newFreeSlots, queue->freeSlots, queue->numberOfFreeSlots * sizeof(unsigned int));
+            memcpy(newHeap, queue->heap, queue->heapSize * sizeof(unsigned int));
         }
+        queue->tasks = newTasks;
+        queue->freeSlots = newFreeSlots;
+        queue->heap = newHeap;
+        queue->borrowed = false;
+    } else {
+        task* newTasks = realloc(queue->tasks, newCapacity * sizeof(task));
+        unsigned int* newFreeSlots = realloc(queue->freeSlots, newCapacity * sizeof(unsigned int));
+        unsigned int* newHeap = realloc(queue->heap, newCapacity * sizeof(unsigned int));
+        if (newTasks != NULL)
+            queue->tasks = newTasks;
+        if (newFreeSlots != NULL)
+            queue->freeSlots = newFreeSlots;
+        if (newHeap != NULL)
+            queue->heap = newHeap;
+        if (newTasks == NULL || newFreeSlots == NULL || newHeap == NULL) {
+            perror("realloc");
+            return -1;
+        }
+    }
+
+    // Push the new slots so that the lowest one is used first
+    for (unsigned int slot = newCapacity; slot > queue->capacity; slot--)
+        queue->freeSlots[queue->numberOfFreeSlots++] = slot - 1;
+    queue->capacity = newCapacity;
+    return 0;
+}
+
+// Function to add a newly arrived task to the ready queue, O(log n)
+int admitTask(readyQueue* queue, const workloadRecord* record, unsigned long long sequence) {
+    if (queue->numberOfFreeSlots == 0 && growReadyQueue(queue) == -1)
+        return -1;
+
+    unsigned int slot = queue->freeSlots[--queue->numberOfFreeSlots];
+    task newTask = {record->id, record->cpuBurstTime, record->cpuBurstTime, record->arrivalTime, 0, 0, 0, false,
+                    sequence, queue->heapSize};
+    queue->tasks[slot] = newTask;
+    queue->heap[queue->heapSize++] = slot;
+    siftUp(queue, newTask.heapIndex);
+    return 0;
+}
+
+// Function to move a task up after its remaining time has decreased, O(log n)
+void decreaseKey(readyQueue* queue, unsigned int slot) {
+    siftUp(queue, queue->tasks[slot].heapIndex);
+}
+
+// Function to remove the task at the top of the heap and free its slot, O(log n)
+void removeFirstTask(readyQueue* queue) {
+    unsigned int slot = queue->heap[0];
+    queue->heapSize--;
+    if (queue->heapSize > 0) {
+        queue->heap[0] = queue->heap[queue->heapSize];
+        queue->tasks[queue->heap[0]].heapIndex = 0;
+        siftDown(queue, 0);
+    }
+    queue->freeSlots[queue->numberOfFreeSlots++] = slot;
+}
+
+void destroyReadyQueue(readyQueue* queue) {
+    if (queue->borrowed)
+        return;
+    free(queue->tasks);
+    free(queue->freeSlots);
+    free(queue->heap);
+}
+
+// Function to get the slot of the next task based on SRTF, O(1). Returns -1 if nothing is ready.
+int getNextTaskSRTF(const readyQueue* queue) {
+    if (queue->heapSize == 0)
+        return -1;
+    return (int)queue->heap[0];
+}
+
+// Function to write a snapshot of a run of runSRTF(). Returns 0 on success, -1 on failure.
+int saveSRTFCheckpoint(const char* path, const workloadTrace* trace, const readyQueue* queue,
+        const srtfCheckpointState* state, unsigned long long numberOfEvents) {
+    checkpointWriter writer;
+    size_t sectionLengths[4] = {sizeof(*state), queue->capacity * sizeof(task),
+                                queue->capacity * sizeof(unsigned int), queue->capacity * sizeof(unsigned int)};
+
+    if (beginCheckpoint(&writer, path, "srtf", sectionLengths, 4) == -1)
+        return -1;
+    memcpy(checkpointWriterSection(&writer, 0), state, sizeof(*state));
+    if (queue->capacity > 0) {
+        // Before the first arrival, the arrays are not allocated yet
+        memcpy(checkpointWriterSection(&writer, 1), queue->tasks, queue->capacity * sizeof(task));
+        memcpy(checkpointWriterSection(&writer, 2), queue->freeSlots, queue->numberOfFreeSlots * sizeof(unsigned int));
+        memcpy(checkpointWriterSection(&writer, 3), queue->heap, queue->heapSize * sizeof(unsigned int));
+    }
+    return commitCheckpoint(&writer, trace, state->currentTimestamp, numberOfEvents);
+}
+
+// Function to pick a run of runSRTF() up from a snapshot. The task slots, the free slots and the heap
+// are used in place, in the mapping of the snapshot. Returns 0 on success, -1 on failure.
+int resumeSRTF(checkpoint* snapshot, const char* path, workloadTrace* trace, readyQueue* queue, srtfCheckpointState* state) {
+    if (openCheckpoint(snapshot, path, "srtf") == -1)
+        return -1;
+
+    const srtfCheckpointState* savedState = checkpointSectionData(snapshot, 0);
+    bool valid = savedState != NULL && checkpointSectionLength(snapshot, 0) == sizeof(*savedState);
+    if (valid) {
+        unsigned int capacity = savedState->capacity;
+        valid = checkpointSectionLength(snapshot, 1) == capacity * sizeof(task)
+                && checkpointSectionLength(snapshot, 2) == capacity * sizeof(unsigned int)
+                && checkpointSectionLength(snapshot, 3) == capacity * sizeof(unsigned int)
+                && savedState->numberOfFreeSlots + savedState->heapSize == capacity
+                && savedState->currentTaskSlot >= -1 && savedState->currentTaskSlot < (long long)capacity;
     }
-    return minTaskIndex;
+    if (!valid) {
+        fprintf(stderr, "%s is not a valid srtf checkpoint\n", path);
+        closeCheckpoint(snapshot);
+        return -1;
+    }
+    if (resumeWorkloadTrace(trace, snapshot) == -1) {
+        closeCheckpoint(snapshot);
+        return -1;
+    }
+
+    *state = *savedState;
+    queue->tasks = checkpointSectionData(snapshot, 1);
+    queue->capacity = savedState->capacity;
+    queue->freeSlots = checkpointSectionData(snapshot, 2);
+    queue->numberOfFreeSlots = savedState->numberOfFreeSlots;
+    queue->heap = checkpointSectionData(snapshot, 3);
+    queue->heapSize = savedState->heapSize;
+    queue->borrowed = (queue->capacity > 0);
+    return 0;
+}
+
+// Function to release the ready queue, and the snapshot the run resumed from(if any)
+void finishSRTFRun(readyQueue* queue, checkpoint* snapshot) {
+    destroyReadyQueue(queue);
+    if (snapshot->mapping != NULL)
+        closeCheckpoint(snapshot);
 }
 
 // Function to run SRTF scheduling
-void runSRTF(task tasks[], unsigned int numberOfTasks) {
-    unsigned int currentTimestamp = 0;
-    unsigned int numberOfCompletedTasks = 0;
-    int currentTaskIndex = -1;
+// Only arrivals can change the decision(the running task only gets shorter), so the running task
+// keeps the CPU until either it completes or the next task arrives. The clock jumps between those events,
+// and a preemption can only happen right after an arrival pushed a shorter task onto the heap.
+// If recordedTimeline is not NULL, every run of a task is recorded into it.
+// If finishedTasks is not NULL, every completed task is copied into it.
+// If checkpoints is not NULL, the run may start from a snapshot and write snapshots as it goes(see
+// checkpointOptions). Returns 1 if the run stopped at checkpoints->stopTime(summary->totalTime is then the
+// clock where it stopped, which may be past stopTime if a run was under way), 0 once every task is completed.
+int runSRTF(workloadTrace* trace, bool printTimeline, timeline* recordedTimeline, task finishedTasks[], schedulingSummary* summary,
+        const checkpointOptions* checkpoints) {
+    readyQueue queue = {NULL, 0, NULL, 0, NULL, 0, false};
+    checkpoint snapshot = {NULL, 0, NULL};
+    unsigned long long currentTimestamp = 0;
+    unsigned long long numberOfAdmittedTasks = 0;
+    unsigned long long numberOfEvents = 0;
+    int currentTaskSlot = -1;
 
-    printf("Starting SRTF Scheduling...\n\n");
+    summary->numberOfTasks = 0;
+    summary->totalWaitingTime = 0;
+    summary->totalTime = 0;
+    initSchedulingMetrics(&summary->metrics);
+
+    if (checkpoints != NULL && checkpoints->resumePath != NULL) {
+        srtfCheckpointState state;
+        if (resumeSRTF(&snapshot, checkpoints->resumePath, trace, &queue, &state) == -1)
+            return -1;
+        currentTimestamp = state.currentTimestamp;
+        numberOfAdmittedTasks = state.numberOfAdmittedTasks;
+        currentTaskSlot = state.currentTaskSlot;
+        numberOfEvents = snapshot.header->numberOfEvents;
+        *summary = state.summary;
+    }
+    unsigned long long nextCheckpoint = (checkpoints != NULL) ? numberOfEvents + checkpoints->interval : ULLONG_MAX;
+
+    if (printTimeline)
+        printf("Starting SRTF Scheduling...\n\n");
+
+    while (true) {
+        // Between two events, the whole state of the simulation is in the queue and the summary
+        if (checkpoints != NULL && checkpoints->path != NULL &&
+                (numberOfEvents >= nextCheckpoint || currentTimestamp >= checkpoints->stopTime)) {
+            srtfCheckpointState state = {currentTimestamp, numberOfAdmittedTasks, currentTaskSlot,
+                                         queue.capacity, queue.numberOfFreeSlots, queue.heapSize, *summary};
+            if (saveSRTFCheckpoint(checkpoints->path, trace, &queue, &state, numberOfEvents) == -1) {
+                finishSRTFRun(&queue, &snapshot);
+                return -1;
+            }
+            nextCheckpoint = numberOfEvents + checkpoints->interval;
+            if (currentTimestamp >= checkpoints->stopTime) {
+                summary->totalTime = currentTimestamp;
+                finishSRTFRun(&queue, &snapshot);
+                return 1;
+            }
+        }
+
+        // Admit the tasks that have arrived by now
+        while (hasArrivalBy(trace, currentTimestamp)) {
+            if (admitTask(&queue, nextWorkloadRecord(trace), numberOfAdmittedTasks++) == -1) {
+                finishSRTFRun(&queue, &snapshot);
+                return -1;
+            }
+        }
 
-    while (numberOfCompletedTasks < numberOfTasks) {
         // Find the next task to run based on SRTF
-        int nextTaskIndex = getNextTaskSRTF(tasks, numberOfTasks, currentTimestamp);
+        int nextTaskSlot = getNextTaskSRTF(&queue);
+        const workloadRecord* nextArrival = peekWorkloadRecord(trace);
+        unsigned long long nextArrivalTime = (nextArrival != NULL) ? nextArrival->arrivalTime : ULLONG_MAX;
+
+        if (nextTaskSlot == -1) {
+            if (nextArrival == NULL)
+                break;  // Every task is completed
 
-        if (nextTaskIndex == -1) {
-            // No task is ready to run at the current timestamp
-            currentTimestamp++;
+            // No task is ready to run, so jump over the idle gap to the next arrival
+            currentTimestamp = nextArrivalTime;
             continue;
         }
 
         // If a different task is selected, decide on preemption
-        if (currentTaskIndex != nextTaskIndex) {
-            if (currentTaskIndex != -1 && tasks[currentTaskIndex].remainingTime > 0) {
-                printf("At timestamp %u, task %u was preempted by task %u.\n", 
-                       currentTimestamp, tasks[currentTaskIndex].id, tasks[nextTaskIndex].id);
-				printf(" - Remaining time of previous task(#%u): %u\n", tasks[currentTaskIndex].id, tasks[currentTaskIndex].remainingTime);
-				printf(" - Remaining time of new task(#%u): %u\n", tasks[nextTaskIndex].id, tasks[nextTaskIndex].remainingTime);
-			}
+        if (currentTaskSlot != nextTaskSlot) {
+            if (printTimeline && currentTaskSlot != -1) {
+                printf("At timestamp %llu, task %u was preempted by task %u.\n",
+                       currentTimestamp, queue.tasks[currentTaskSlot].id, queue.tasks[nextTaskSlot].id);
+                printf(" - Remaining time of previous task(#%u): %llu\n", queue.tasks[currentTaskSlot].id, queue.tasks[currentTaskSlot].remainingTime);
+                printf(" - Remaining time of new task(#%u): %llu\n", queue.tasks[nextTaskSlot].id, queue.tasks[nextTaskSlot].remainingTime);
+            }
 
-            currentTaskIndex = nextTaskIndex;
-            task* currentTask = &tasks[currentTaskIndex];
+            currentTaskSlot = nextTaskSlot;
+            task* currentTask = &queue.tasks[currentTaskSlot];
 
             if (!currentTask->started) {
                 // First time the task is running
                 currentTask->startTime = currentTimestamp;
-                currentTask->waitingTime = currentTimestamp - currentTask->arrivalTime;
                 currentTask->started = true;
             }
+            recordDispatch(&summary->metrics, currentTask->id);
         }
 
-        // Execute the current task for 1 time unit
-        printf("At timestamp %u, task %u is running.\n", currentTimestamp, tasks[currentTaskIndex].id);
-        tasks[currentTaskIndex].remainingTime--;
-        currentTimestamp++;
+        // Execute the current task until it completes or the next task arrives, whichever comes first
+        task* currentTask = &queue.tasks[currentTaskSlot];
+        unsigned long long runTime = currentTask->remainingTime;
+        if (nextArrivalTime - currentTimestamp < runTime)
+            runTime = nextArrivalTime - currentTimestamp;
+
+        if (printTimeline)
+            printf("From timestamp %llu to %llu, task %u is running.\n", currentTimestamp, currentTimestamp + runTime, currentTask->id);
+        if (recordedTimeline != NULL && recordRun(recordedTimeline, currentTask->id, currentTimestamp, runTime) == -1) {
+            finishSRTFRun(&queue, &snapshot);
+            return -1;
+        }
+        currentTask->remainingTime -= runTime;
+        currentTimestamp += runTime;
 
         // If the task is completed
-        if (tasks[currentTaskIndex].remainingTime == 0) {
-            tasks[currentTaskIndex].endTime = currentTimestamp;
-            numberOfCompletedTasks++;
-            printf("At timestamp %u, task %u has finished execution.\n\n", currentTimestamp, tasks[currentTaskIndex].id);
-            currentTaskIndex = -1; // No task is currently running
+        if (currentTask->remainingTime == 0) {
+            // Every moment between the arrival and the end that the task was not running, it was waiting
+            currentTask->endTime = currentTimestamp;
+            currentTask->waitingTime = currentTask->endTime - currentTask->arrivalTime - currentTask->cpuBurstTime;
+            if (printTimeline)
+                printf("At timestamp %llu, task %u has finished execution.\n\n", currentTimestamp, currentTask->id);
+
+            summary->totalWaitingTime += currentTask->waitingTime;
+            summary->totalTime = currentTimestamp;
+            recordCompletion(&summary->metrics, currentTask->arrivalTime, currentTask->startTime, currentTask->endTime, currentTask->waitingTime);
+            if (finishedTasks != NULL)
+                finishedTasks[summary->numberOfTasks] = *currentTask;
+            summary->numberOfTasks++;
+
+            removeFirstTask(&queue);
+            currentTaskSlot = -1; // No task is currently running
+        } else {
+            // The running task got shorter, so it can only move towards the top
+            decreaseKey(&queue, currentTaskSlot);
         }
+        numberOfEvents++;
+    }
 
-        // Increment waiting time for all other tasks that have arrived and are not completed
-        for (unsigned int index = 0; index < numberOfTasks; index++) {
-            if (tasks[index].arrivalTime <= currentTimestamp 
-                && index != currentTaskIndex 
-                && tasks[index].remainingTime > 0) {
-                tasks[index].waitingTime++;
+    finishSRTFRun(&queue, &snapshot);
+    return 0;
+}
+
+// Function to run SRTF the way it was done before the heap: every decision scans all ready tasks.
+// It is kept as the reference for the benchmark, and produces exactly the same schedule as runSRTF().
+int runSRTFByScan(workloadTrace* trace, schedulingSummary* summary) {
+    task* tasks = NULL;
+    unsigned int numberOfTasks = 0, capacity = 0;
+    unsigned long long currentTimestamp = 0;
+
+    summary->numberOfTasks = 0;
+    summary->totalWaitingTime = 0;
+    summary->totalTime = 0;
+
+    while (true) {
+        while (hasArrivalBy(trace, currentTimestamp)) {
+            const workloadRecord* record = nextWorkloadRecord(trace);
+            if (numberOfTasks == capacity) {
+                capacity = (capacity == 0) ? 64 : capacity * 2;
+                task* newTasks = realloc(tasks, capacity * sizeof(task));
+                if (newTasks == NULL) {
+                    perror("realloc");
+                    free(tasks);
+                    return -1;
+                }
+                tasks = newTasks;
             }
+            task newTask = {record->id, record->cpuBurstTime, record->cpuBurstTime, record->arrivalTime, 0, 0, 0, false, 0, 0};
+            tasks[numberOfTasks++] = newTask;
+        }
+
+        // Scan every ready task for the shortest remaining time(ties go to the earlier arrival)
+        int minTaskIndex = -1;
+        for (unsigned int index = 0; index < numberOfTasks; index++) {
+            if (minTaskIndex == -1 || tasks[index].remainingTime < tasks[minTaskIndex].remainingTime)
+                minTaskIndex = index;
+        }
+
+        const workloadRecord* nextArrival = peekWorkloadRecord(trace);
+        unsigned long long nextArrivalTime = (nextArrival != NULL) ? nextArrival->arrivalTime : ULLONG_MAX;
+        if (minTaskIndex == -1) {
+            if (nextArrival == NULL)
+                break;
+            currentTimestamp = nextArrivalTime;
+            continue;
+        }
+
+        task* currentTask = &tasks[minTaskIndex];
+        unsigned long long runTime = currentTask->remainingTime;
+        if (nextArrivalTime - currentTimestamp < runTime)
+            runTime = nextArrivalTime - currentTimestamp;
+        currentTask->remainingTime -= runTime;
+        currentTimestamp += runTime;
+
+        if (currentTask->remainingTime == 0) {
+            summary->totalWaitingTime += currentTimestamp - currentTask->arrivalTime - currentTask->cpuBurstTime;
+            summary->totalTime = currentTimestamp;
+            summary->numberOfTasks++;
+            memmove(&tasks[minTaskIndex], &tasks[minTaskIndex + 1], (numberOfTasks - minTaskIndex - 1) * sizeof(task));
+            numberOfTasks--;
+        }
+    }
+
+    free(tasks);
+    return 0;
+}
+
+double elapsedSeconds(const struct timespec* start, const struct timespec* end) {
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// Function to compare the heap against the scan on synthetic workloads of 10^3 to 10^7 tasks.
+// Tasks arrive a little faster than they can be served, so the number of ready tasks keeps growing
+// and the cost of each decision dominates. The scan is quadratic on such a workload, so a size is
+// skipped when the scan is expected to take longer than scanTimeBudget seconds.
+int runBenchmark(double scanTimeBudget) {
+    bool scanTooSlow = false;
+
+    printf("%10s %14s %14s %10s\n", "Tasks", "Heap(s)", "Scan(s)", "Speedup");
+    for (unsigned long long numberOfTasks = 1000; numberOfTasks <= 10000000; numberOfTasks *= 10) {
+        workloadRecord* records = malloc(numberOfTasks * sizeof(workloadRecord));
+        if (records == NULL) {
+            perror("malloc");
+            return -1;
+        }
+
+        srand(42);
+        unsigned long long arrivalTime = 0;
+        for (unsigned long long index = 0; index < numberOfTasks; index++) {
+            workloadRecord record = {arrivalTime, 1 + rand() % 20, (uint32_t)(index + 1), 0, 0, 0};
+            records[index] = record;
+            arrivalTime += rand() % 20;     // 9.5 units apart on average, against 10.5 units of work
+        }
+
+        workloadTrace trace;
+        schedulingSummary heapSummary, scanSummary;
+        struct timespec start, end;
+
+        openWorkloadTraceFromRecords(&trace, records, numberOfTasks);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        int result = runSRTF(&trace, false, NULL, NULL, &heapSummary, NULL);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double heapSeconds = elapsedSeconds(&start, &end);
+        if (result == -1) {
+            free(records);
+            return -1;
+        }
+
+        if (scanTooSlow) {
+            printf("%10llu %14.4f %14s %10s\n", numberOfTasks, heapSeconds, "skipped", "-");
+            free(records);
+            continue;
+        }
+
+        openWorkloadTraceFromRecords(&trace, records, numberOfTasks);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        result = runSRTFByScan(&trace, &scanSummary);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double scanSeconds = elapsedSeconds(&start, &end);
+        free(records);
+        if (result == -1)
+            return -1;
+
+        if (heapSummary.totalWaitingTime != scanSummary.totalWaitingTime || heapSummary.totalTime != scanSummary.totalTime) {
+            fprintf(stderr, "The heap and the scan disagree for %llu tasks\n", numberOfTasks);
+            return -1;
         }
+        printf("%10llu %14.4f %14.4f %9.1fx\n", numberOfTasks, heapSeconds, scanSeconds, scanSeconds / heapSeconds);
+        scanTooSlow = scanSeconds * 100 > scanTimeBudget;  // 10 times the tasks, 100 times the time
     }
+    return 0;
+}
+
+int compareTaskId(const void* a, const void* b) {
+    const task* taskA = a;
+    const task* taskB = b;
+    return (taskA->id > taskB->id) - (taskA->id < taskB->id);
 }
 
 // Function to display task status information after scheduling
 void displayTaskStatus(task tasks[], int numberOfTasks) {
-    unsigned int totalWaitingTime = 0;
+    // Tasks are stored in the order they completed. Show them in the order of their ID.
+    qsort(tasks, numberOfTasks, sizeof(task), compareTaskId);
+
     printf("\nFinal Task Status:\n");
     printf("TaskID  BurstTime       ArrivalTime     WaitingTime     StartTime       EndTime\n");
     for (int index = 0; index < numberOfTasks; index++) {
-        printf("%d\t%d\t\t%d\t\t%d\t\t%d\t\t%d\n", 
+        printf("%u\t%llu\t\t%llu\t\t%llu\t\t%llu\t\t%llu\n",
                 tasks[index].id, 
                 tasks[index].cpuBurstTime, 
                 tasks[index].arrivalTime, 
                 tasks[index].waitingTime, 
                 tasks[index].startTime, 
                 tasks[index].endTime);
-        totalWaitingTime += tasks[index].waitingTime;
     }
-    double averageWaitingTime = (double)totalWaitingTime / numberOfTasks;
-    unsigned int totalTime = 0;
-    for (int i = 0; i < numberOfTasks; i++) {
-        if (tasks[i].endTime > totalTime) {
-            totalTime = tasks[i].endTime;
-        }
+}
+
+// Function to display the summary of the scheduling
+void displaySummary(const schedulingSummary* summary) {
+    if (summary->numberOfTasks == 0) {
+        printf("\nNo tasks\n");
+        return;
     }
-    double throughput = (double)numberOfTasks / totalTime;
+    double averageWaitingTime = (double)summary->totalWaitingTime / summary->numberOfTasks;
+    double throughput = (double)summary->numberOfTasks / summary->totalTime;
 
     printf("\nAverage waiting time: %.2f units\n", averageWaitingTime);
     printf("Throughput: %.2f tasks per unit time\n", throughput);
-    printf("Total time taken: %u units\n", totalTime);
+    printf("Total time taken: %llu units\n", summary->totalTime);
+    printLatencyReport(&summary->metrics);
 }
 
-int main(void) {
-    unsigned int numberOfTasks = 10;
+int main(int argc, char* argv[]) {
+    workloadTrace trace;
+    schedulingSummary summary;
+
+    if (argc > 1 && strcmp(argv[1], "--benchmark") == 0)
+        return runBenchmark((argc > 2) ? strtod(argv[2], NULL) : 300.0) == 0 ? 0 : 1;
+
+    if (argc > 1) {
+        bool printMetrics = false;
+        bool recordTimeline = false;
+        timelineFormat format = TIMELINE_GANTT;
+        const char* timelinePath = NULL;
+        checkpointOptions checkpoints;
+        initCheckpointOptions(&checkpoints);
+        bool validArguments = true;
+        for (int index = 2; index < argc && validArguments; index++) {
+            if (strcmp(argv[index], "--metrics") == 0) {
+                printMetrics = true;
+            } else if (strcmp(argv[index], "--timeline") == 0 && index + 1 < argc && parseTimelineFormat(argv[index + 1], &format) == 0) {
+                recordTimeline = true;
+                index++;
+            } else if (strcmp(argv[index], "--timeline-output") == 0 && index + 1 < argc) {
+                timelinePath = argv[++index];
+            } else if (strcmp(argv[index], "--checkpoint") == 0 && index + 1 < argc) {
+                checkpoints.path = argv[++index];
+            } else if (strcmp(argv[index], "--checkpoint-every") == 0 && index + 1 < argc) {
+                checkpoints.interval = strtoull(argv[++index], NULL, 10);
+            } else if (strcmp(argv[index], "--until") == 0 && index + 1 < argc) {
+                checkpoints.stopTime = strtoull(argv[++index], NULL, 10);
+            } else if (strcmp(argv[index], "--resume") == 0 && index + 1 < argc) {
+                checkpoints.resumePath = argv[++index];
+            } else {
+                validArguments = false;
+            }
+        }
+        if (!validArguments || checkpoints.interval == 0 || (checkpoints.stopTime != ULLONG_MAX && checkpoints.path == NULL)) {
+            fprintf(stderr, "Usage: %s <trace> [--metrics] [--timeline gantt|csv|json] [--timeline-output path]\n"
+                    "           [--checkpoint path] [--checkpoint-every events] [--until timestamp] [--resume path]\n", argv[0]);
+            return 1;
+        }
+
+        timeline recordedTimeline;
+        initTimeline(&recordedTimeline);
+        if (openWorkloadTrace(&trace, argv[1]) == -1)
+            return 1;
+        int result = runSRTF(&trace, false, recordTimeline ? &recordedTimeline : NULL, NULL, &summary, &checkpoints);
+        closeWorkloadTrace(&trace);
+        if (result == 1) {
+            printf("Stopped at timestamp %llu with %llu tasks completed. Resume with --resume %s\n",
+                   summary.totalTime, summary.numberOfTasks, checkpoints.path);
+            result = (recordTimeline) ? writeTimeline(&recordedTimeline, format, timelinePath) : 0;
+        } else if (result == 0) {
+            if (printMetrics)
+                printSchedulingMetrics(&summary.metrics, summary.numberOfTasks, summary.totalWaitingTime, summary.totalTime);
+            else
+                displaySummary(&summary);
+            if (recordTimeline)
+                result = writeTimeline(&recordedTimeline, format, timelinePath);
+        }
+        destroyTimeline(&recordedTimeline);
+        return (result == 0) ? 0 : 1;
+    }
 
     // Initialize tasks
-    task tasks[] = {
-        {1, 8, 8, 0, 0, 0, 0, false},   // Task 1: Burst Time = 8, Arrival Time = 0
-        {2, 4, 4, 1, 0, 0, 0, false},   // Task 2: Burst Time = 4, Arrival Time = 1
-        {3, 9, 9, 2, 0, 0, 0, false},   // Task 3: Burst Time = 9, Arrival Time = 2
-        {4, 5, 5, 3, 0, 0, 0, false},   // Task 4: Burst Time = 5, Arrival Time = 3
-        {5, 2, 2, 4, 0, 0, 0, false},   // Task 5: Burst Time = 2, Arrival Time = 4
-        {6, 6, 6, 5, 0, 0, 0, false},   // Task 6: Burst Time = 6, Arrival Time = 5
-        {7, 3, 3, 6, 0, 0, 0, false},   // Task 7: Burst Time = 3, Arrival Time = 6
-        {8, 7, 7, 7, 0, 0, 0, false},   // Task 8: Burst Time = 7, Arrival Time = 7
-        {9, 1, 1, 8, 0, 0, 0, false},   // Task 9: Burst Time = 1, Arrival Time = 8
-        {10, 4, 4, 9, 0, 0, 0, false}   // Task 10: Burst Time = 4, Arrival Time = 9
+    workloadRecord records[] = {
+        {.arrivalTime = 0, .cpuBurstTime = 8, .id = 1},    // Task 1: Burst Time = 8, Arrival Time = 0
+        {.arrivalTime = 1, .cpuBurstTime = 4, .id = 2},    // Task 2: Burst Time = 4, Arrival Time = 1
+        {.arrivalTime = 2, .cpuBurstTime = 9, .id = 3},    // Task 3: Burst Time = 9, Arrival Time = 2
+        {.arrivalTime = 3, .cpuBurstTime = 5, .id = 4},    // Task 4: Burst Time = 5, Arrival Time = 3
+        {.arrivalTime = 4, .cpuBurstTime = 2, .id = 5},    // Task 5: Burst Time = 2, Arrival Time = 4
+        {.arrivalTime = 5, .cpuBurstTime = 6, .id = 6},    // Task 6: Burst Time = 6, Arrival Time = 5
+        {.arrivalTime = 6, .cpuBurstTime = 3, .id = 7},    // Task 7: Burst Time = 3, Arrival Time = 6
+        {.arrivalTime = 7, .cpuBurstTime = 7, .id = 8},    // Task 8: Burst Time = 7, Arrival Time = 7
+        {.arrivalTime = 8, .cpuBurstTime = 1, .id = 9},    // Task 9: Burst Time = 1, Arrival Time = 8
+        {.arrivalTime = 9, .cpuBurstTime = 4, .id = 10}    // Task 10: Burst Time = 4, Arrival Time = 9
     };
+    unsigned int numberOfTasks = sizeof(records) / sizeof(records[0]);
+    task tasks[sizeof(records) / sizeof(records[0])];
 
-    runSRTF(tasks, numberOfTasks);
+    openWorkloadTraceFromRecords(&trace, records, numberOfTasks);
+    runSRTF(&trace, true, NULL, tasks, &summary, NULL);
     displayTaskStatus(tasks, numberOfTasks);
+    displaySummary(&summary);
 
     return 0;
 }
@@ -0,0 +1,314 @@
+// scheduling/simulation_checkpoint.h
+// Snapshots of a running simulation, so that a long replay can be stopped and resumed later,
+// on this machine or another one, instead of starting over.
+//
+// A snapshot is one file: a header page followed by up to CHECKPOINT_MAX_SECTIONS sections, each
+// starting on a page boundary. The header holds the clock, the number of events simulated so far and
+// the position in the workload trace(the state of the generator, for generated workloads). The sections
+// hold whatever the simulator keeps: its scalars and statistics, its task table, its ready queue.
+// Fields are stored in the host byte order, so a snapshot is resumed on the same kind of machine.
+//
+// Resuming does not read the snapshot into memory: the file is mapped copy-on-write and the simulator
+// uses its sections in place, so only the pages the simulation touches again are ever read, and only
+// the ones it modifies are copied. Pointers stored in a snapshot(e.g. the links of a red-black tree) are
+// written as if the file were mapped at CHECKPOINT_BASE_ADDRESS, where openCheckpoint() asks the kernel
+// to put it. If that range is taken, the file lands elsewhere and checkpointRelocation() tells the
+// simulator how far to move its pointers.
+//
+// A snapshot is written into a temporary file next to its path, synced, and renamed over the path,
+// so a crash while writing leaves the previous snapshot intact.
+#ifndef SIMULATION_CHECKPOINT_H
+#define SIMULATION_CHECKPOINT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "workload_trace.h"
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE 0x100000    // Linux 4.17. Older kernels ignore it and take the address as a hint,
+                                        // so the file may land elsewhere: checkpointRelocation() covers that.
+#endif
+
+#define CHECKPOINT_MAGIC "SCHEDCKP"
+#define CHECKPOINT_VERSION 1
+#define CHECKPOINT_MAX_SECTIONS 4
+#define CHECKPOINT_BASE_ADDRESS 0x5c0000000000ull   // Far from the heap, the stacks and the shared libraries
+#define CHECKPOINT_DEFAULT_INTERVAL 10000000ull     // Events between two snapshots
+
+typedef struct {
+    uint64_t offset;            // From the start of the file, a multiple of the page size
+    uint64_t length;
+} checkpointSection;
+
+typedef struct {
+    char magic[8];              // Always CHECKPOINT_MAGIC(not NUL-terminated)
+    uint32_t version;           // Format version
+    uint32_t headerSize;        // sizeof(checkpointHeader), to catch mismatched builds
+    char simulator[16];         // Which simulator wrote the snapshot, e.g. "srtf"
+    uint64_t baseAddress;       // Address the stored pointers assume the file is mapped at
+    uint64_t fileLength;
+    uint64_t numberOfEvents;    // Events simulated before the snapshot
+    uint64_t clock;             // Simulated time of the snapshot
+    uint64_t numberOfRecords;   // Length of the workload trace, to catch resuming on another trace
+    uint64_t nextRecord;        // Position in the workload trace
+    workloadRecord upcomingRecord;          // Record at nextRecord(if any), checked again on resume
+    uint8_t generated;                      // Whether the workload came from the generator
+    workloadGenerator generator;            // Generated workloads: the state of the generator
+    workloadRecord generatedRecords[2];
+    uint32_t numberOfSections;
+    checkpointSection sections[CHECKPOINT_MAX_SECTIONS];
+} checkpointHeader;
+
+// Settings of a simulation run regarding snapshots
+typedef struct {
+    const char* path;                   // Where to write snapshots(NULL for none)
+    unsigned long long interval;        // Events between two snapshots
+    unsigned long long stopTime;        // Once the clock reaches it, write a snapshot and stop(ULLONG_MAX for never)
+    const char* resumePath;             // Snapshot to resume from(NULL to start from the beginning)
+} checkpointOptions;
+
+// A snapshot being written: the temporary file is mapped, and the simulator fills the sections in place
+typedef struct {
+    char path[PATH_MAX];
+    char temporaryPath[PATH_MAX];
+    int fd;
+    void* mapping;
+    size_t length;
+} checkpointWriter;
+
+// A snapshot being resumed from. It stays mapped for as long as the simulation uses its sections.
+typedef struct {
+    void* mapping;
+    size_t length;
+    const checkpointHeader* header;
+} checkpoint;
+
+static inline void initCheckpointOptions(checkpointOptions* options) {
+    options->path = NULL;
+    options->interval = CHECKPOINT_DEFAULT_INTERVAL;
+    options->stopTime = ULLONG_MAX;
+    options->resumePath = NULL;
+}
+
+static inline size_t checkpointPageAlign(size_t length) {
+    size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    return (length + pageSize - 1) & ~(pageSize - 1);
+}
+
+// Function to create a snapshot file with sections of the given lengths, mapped for writing.
+// Returns 0 on success, -1 on failure.
+static inline int beginCheckpoint(checkpointWriter* writer, const char* path, const char* simulator,
+        const size_t sectionLengths[], unsigned int numberOfSections) {
+    if (numberOfSections > CHECKPOINT_MAX_SECTIONS || strlen(simulator) >= sizeof(((checkpointHeader*)0)->simulator) ||
+            snprintf(writer->path, sizeof(writer->path), "%s", path) >= (int)sizeof(writer->path) ||
+            snprintf(writer->temporaryPath, sizeof(writer->temporaryPath), "%s.tmp", path) >= (int)sizeof(writer->temporaryPath)) {
+        fprintf(stderr, "Invalid checkpoint %s\n", path);
+        return -1;
+    }
+
+    checkpointSection sections[CHECKPOINT_MAX_SECTIONS];
+    size_t length = checkpointPageAlign(sizeof(checkpointHeader));
+    for (unsigned int index = 0; index < numberOfSections; index++) {
+        sections[index].offset = length;
+        sections[index].length = sectionLengths[index];
+        length += checkpointPageAlign(sectionLengths[index]);
+    }
+
+    writer->fd = open(writer->temporaryPath, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (writer->fd == -1) {
+        perror("open");
+        return -1;
+    }
+    if (ftruncate(writer->fd, (off_t)length) == -1) {
+        perror("ftruncate");
+        close(writer->fd);
+        unlink(writer->temporaryPath);
+        return -1;
+    }
+    writer->mapping = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, writer->fd, 0);
+    if (writer->mapping == MAP_FAILED) {
+        perror("mmap");
+        close(writer->fd);
+        unlink(writer->temporaryPath);
+        return -1;
+    }
+    writer->length = length;
+
+    // The file starts out as zeros, so only the non-zero fields are set
+    checkpointHeader* header = writer->mapping;
+    memcpy(header->magic, CHECKPOINT_MAGIC, sizeof(header->magic));
+    header->version = CHECKPOINT_VERSION;
+    header->headerSize = sizeof(checkpointHeader);
+    strcpy(header->simulator, simulator);
+    header->baseAddress = CHECKPOINT_BASE_ADDRESS;
+    header->fileLength = length;
+    header->numberOfSections = numberOfSections;
+    memcpy(header->sections, sections, numberOfSections * sizeof(checkpointSection));
+    return 0;
+}
+
+// Function to get where a section of the snapshot being written is to be filled
+static inline void* checkpointWriterSection(const checkpointWriter* writer, unsigned int index) {
+    const checkpointHeader* header = writer->mapping;
+    return (char*)writer->mapping + header->sections[index].offset;
+}
+
+// Function to convert an address inside the snapshot being written into the pointer to store:
+// the address it will have once the snapshot is mapped at CHECKPOINT_BASE_ADDRESS
+static inline void* checkpointPointer(const checkpointWriter* writer, const void* address) {
+    if (address == NULL)
+        return NULL;
+    return (void*)(uintptr_t)(CHECKPOINT_BASE_ADDRESS + (uint64_t)((const char*)address - (const char*)writer->mapping));
+}
+
+static inline void abortCheckpoint(checkpointWriter* writer) {
+    munmap(writer->mapping, writer->length);
+    close(writer->fd);
+    unlink(writer->temporaryPath);
+}
+
+// Function to record the clock and the position in the trace, then make the snapshot durable and
+// put it in place of the previous one. Returns 0 on success, -1 on failure.
+static inline int commitCheckpoint(checkpointWriter* writer, const workloadTrace* trace,
+        unsigned long long clock, unsigned long long numberOfEvents) {
+    checkpointHeader* header = writer->mapping;
+    header->numberOfEvents = numberOfEvents;
+    header->clock = clock;
+    header->numberOfRecords = trace->numberOfRecords;
+    header->nextRecord = trace->nextRecord;
+    const workloadRecord* upcomingRecord = peekWorkloadRecord(trace);
+    if (upcomingRecord != NULL)
+        header->upcomingRecord = *upcomingRecord;
+    header->generated = trace->generated;
+    if (trace->generated) {
+        header->generator = trace->generator;
+        memcpy(header->generatedRecords, trace->generatedRecords, sizeof(header->generatedRecords));
+    }
+
+    int result = 0;
+    if (msync(writer->mapping, writer->length, MS_SYNC) == -1 || fsync(writer->fd) == -1) {
+        perror("fsync");
+        result = -1;
+    }
+    munmap(writer->mapping, writer->length);
+    close(writer->fd);
+    if (result == 0 && rename(writer->temporaryPath, writer->path) == -1) {
+        perror("rename");
+        result = -1;
+    }
+    if (result == -1)
+        unlink(writer->temporaryPath);
+    return result;
+}
+
+// Function to map a snapshot written by the given simulator. Returns 0 on success, -1 on failure.
+static inline int openCheckpoint(checkpoint* snapshot, const char* path, const char* simulator) {
+    struct stat fileStatus;
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        perror("open");
+        return -1;
+    }
+    if (fstat(fd, &fileStatus) == -1) {
+        perror("fstat");
+        close(fd);
+        return -1;
+    }
+    if ((size_t)fileStatus.st_size < sizeof(checkpointHeader)) {
+        fprintf(stderr, "%s is too small to be a checkpoint\n", path);
+        close(fd);
+        return -1;
+    }
+
+    // Copy-on-write: the simulation may modify the sections, the file never changes
+    void* mapping = mmap((void*)(uintptr_t)CHECKPOINT_BASE_ADDRESS, fileStatus.st_size, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_FIXED_NOREPLACE, fd, 0);
+    if (mapping == MAP_FAILED)
+        mapping = mmap(NULL, fileStatus.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);  // The mapping stays valid after the descriptor is closed
+    if (mapping == MAP_FAILED) {
+        perror("mmap");
+        return -1;
+    }
+
+    const checkpointHeader* header = mapping;
+    bool valid = memcmp(header->magic, CHECKPOINT_MAGIC, sizeof(header->magic)) == 0
+            && header->version == CHECKPOINT_VERSION
+            && header->headerSize == sizeof(checkpointHeader)
+            && header->fileLength == (uint64_t)fileStatus.st_size
+            && header->numberOfSections <= CHECKPOINT_MAX_SECTIONS;
+    for (uint32_t index = 0; valid && index < header->numberOfSections; index++)
+        valid = header->sections[index].offset <= header->fileLength
+                && header->sections[index].length <= header->fileLength - header->sections[index].offset;
+    if (!valid || strncmp(header->simulator, simulator, sizeof(header->simulator)) != 0) {
+        fprintf(stderr, "%s is not a valid %s checkpoint\n", path, simulator);
+        munmap(mapping, fileStatus.st_size);
+        return -1;
+    }
+
+    snapshot->mapping = mapping;
+    snapshot->length = fileStatus.st_size;
+    snapshot->header = header;
+    return 0;
+}
+
+// Function to get a section of a snapshot being resumed from(NULL if it is empty)
+static inline void* checkpointSectionData(const checkpoint* snapshot, unsigned int index) {
+    if (index >= snapshot->header->numberOfSections || snapshot->header->sections[index].length == 0)
+        return NULL;
+    return (char*)snapshot->mapping + snapshot->header->sections[index].offset;
+}
+
+static inline uint64_t checkpointSectionLength(const checkpoint* snapshot, unsigned int index) {
+    return (index < snapshot->header->numberOfSections) ? snapshot->header->sections[index].length : 0;
+}
+
+// Function to get how far the stored pointers must move: 0 unless the snapshot could not be mapped
+// at CHECKPOINT_BASE_ADDRESS
+static inline intptr_t checkpointRelocation(const checkpoint* snapshot) {
+    return (intptr_t)((uintptr_t)snapshot->mapping - (uintptr_t)CHECKPOINT_BASE_ADDRESS);
+}
+
+// Function to check whether memory belongs to the snapshot(it must not be freed)
+static inline bool isInCheckpoint(const checkpoint* snapshot, const void* address) {
+    return snapshot != NULL && (const char*)address >= (const char*)snapshot->mapping
+            && (const char*)address < (const char*)snapshot->mapping + snapshot->length;
+}
+
+// Function to move a freshly opened trace to where the snapshot left it.
+// Returns 0 on success, -1 if the trace is not the one the snapshot was taken on.
+static inline int resumeWorkloadTrace(workloadTrace* trace, const checkpoint* snapshot) {
+    const checkpointHeader* header = snapshot->header;
+    if (header->numberOfRecords != trace->numberOfRecords || header->generated != trace->generated
+            || header->nextRecord > trace->numberOfRecords) {
+        fprintf(stderr, "The checkpoint was taken on another workload trace\n");
+        return -1;
+    }
+
+    trace->nextRecord = header->nextRecord;
+    if (trace->generated) {
+        trace->generator = header->generator;
+        memcpy(trace->generatedRecords, header->generatedRecords, sizeof(trace->generatedRecords));
+    }
+    const workloadRecord* upcomingRecord = peekWorkloadRecord(trace);
+    if (upcomingRecord != NULL && memcmp(upcomingRecord, &header->upcomingRecord, sizeof(*upcomingRecord)) != 0) {
+        fprintf(stderr, "The checkpoint was taken on another workload trace\n");
+        return -1;
+    }
+    return 0;
+}
+
+static inline void closeCheckpoint(checkpoint* snapshot) {
+    munmap(snapshot->mapping, snapshot->length);
+    snapshot->mapping = NULL;
+    snapshot->header = NULL;
+}
+
+#endif
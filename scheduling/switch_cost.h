@@ -0,0 +1,333 @@
+// scheduling/switch_cost.h
+// A cost model of context switches for the simulators, which otherwise switch between tasks for free.
+// Every time the CPU switches to another task, it pays:
+//   - a fixed switch cost: saving and restoring the registers, the scheduler itself, the TLB, and
+//   - a refill penalty for the part of the working set of the incoming task that was evicted from the
+//     caches while it was off the CPU. What is still cached decays exponentially with the time off the
+//     CPU, warmth = exp(-offCpuTime / warmthDecay), and the penalty is refillCost * (1 - warmth).
+//     A task that comes back right away finds its working set warm, one that was away for long(or
+//     that never ran) refills all of it.
+//
+// Costs are in nanoseconds while the simulators count time in units, so the model knows the length of
+// a unit(unitLength, 0.1ms by default). The costs of the switches add up, and the clock moves by whole
+// units as the sum crosses them: a cost smaller than a unit is still charged on average, and a run
+// is still exactly reproducible. As the quantum shrinks towards the cost of a switch, the switches eat
+// a growing share of the CPU, and the throughput falls off a cliff.
+//
+// --calibrate measures the costs on the host instead of taking them from the command line:
+//   - switch cost: two threads pinned to the same CPU pass a byte back and forth through two pipes, so
+//     every round trip is two switches. The cost of the pipes alone, measured in one thread, is
+//     subtracted(like lmbench's lat_ctx).
+//   - refill cost: the time to read a working set(workingSetSize bytes, one load per cache line in a
+//     shuffled order so the prefetchers cannot hide the misses) after a sweep of a buffer four times the
+//     size of the last-level cache, minus the time to read it again right away.
+//   - warmth decay: the time to sweep the last-level cache once, i.e. how long a task running flat out
+//     takes to evict everything the others had cached.
+// The measurements pin the calling thread to one CPU for a moment. The CPU affinity calls need
+// _GNU_SOURCE, which this header defines itself when it comes before every system header.
+#ifndef SWITCH_COST_H
+#define SWITCH_COST_H
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+#include <sched.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#ifndef CPU_ZERO
+#error "switch_cost.h needs _GNU_SOURCE: define it, or include this header, before any system header"
+#endif
+
+#define SWITCH_COST_UNIT_LENGTH 100000ull       // Default length of a time unit(ns)
+#define SWITCH_COST_WARMTH_DECAY 1000000ull     // Default time off the CPU for a working set to cool down to 1/e(ns)
+#define SWITCH_COST_WORKING_SET (256u << 10)    // Default working set that --calibrate refills
+#define SWITCH_COST_ROUNDS 20000                // Ping-pong round trips of the calibration
+#define SWITCH_COST_REPETITIONS 5               // The best of this many cache measurements is taken
+#define SWITCH_COST_CACHE_LINE 64
+#define SWITCH_COST_DEFAULT_CACHE (8u << 20)    // Last-level cache size if the host does not tell
+
+typedef struct {
+    unsigned long long switchCost;          // Fixed cost of a switch(ns)
+    unsigned long long refillCost;          // Cost of refilling a cold working set(ns)
+    unsigned long long warmthDecay;         // Time off the CPU for the cached part of a working set to fall to 1/e(ns)
+    unsigned long long unitLength;          // Length of a simulated time unit(ns)
+    bool calibrate;                         // Measure the costs on the host(--calibrate)
+    unsigned long long workingSetSize;      // Working set the calibration refills(bytes)
+    unsigned long long pendingCost;         // Cost charged but not yet turned into whole units(ns)
+    unsigned long long numberOfSwitches;    // Switches charged
+    double totalSwitchCost;                 // ns
+    double totalRefillCost;                 // ns
+    unsigned long long totalOverhead;       // Units the clock moved for switches
+} switchCostModel;
+
+static inline void initSwitchCostModel(switchCostModel* model) {
+    memset(model, 0, sizeof(*model));
+    model->warmthDecay = SWITCH_COST_WARMTH_DECAY;
+    model->unitLength = SWITCH_COST_UNIT_LENGTH;
+    model->workingSetSize = SWITCH_COST_WORKING_SET;
+}
+
+// Function to check whether switches cost anything. Without costs, the simulators skip the model entirely.
+static inline bool isSwitchCostEnabled(const switchCostModel* model) {
+    return model->switchCost > 0 || model->refillCost > 0;
+}
+
+// Function to charge a switch to a task that last left the CPU at lastRunEnd(if it ever ran).
+// Returns how many units the clock moves before the task runs.
+static inline unsigned long long chargeSwitch(switchCostModel* model, unsigned long long currentTimestamp,
+        bool hasRun, unsigned long long lastRunEnd) {
+    double refillCost = (double)model->refillCost;
+    if (hasRun && model->warmthDecay > 0) {
+        double offCpuTime = (double)(currentTimestamp - lastRunEnd) * model->unitLength;
+        refillCost *= 1 - exp(-offCpuTime / model->warmthDecay);
+    }
+
+    model->numberOfSwitches++;
+    model->totalSwitchCost += model->switchCost;
+    model->totalRefillCost += refillCost;
+    model->pendingCost += model->switchCost + (unsigned long long)(refillCost + 0.5);
+
+    unsigned long long overhead = model->pendingCost / model->unitLength;
+    model->pendingCost -= overhead * model->unitLength;
+    model->totalOverhead += overhead;
+    return overhead;
+}
+
+static inline unsigned long long switchCostClock(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (unsigned long long)time.tv_sec * 1000000000ull + time.tv_nsec;
+}
+
+// The two ends of the ping-pong
+typedef struct {
+    int toPartner[2];
+    int fromPartner[2];
+    int cpu;
+} pingPong;
+
+static inline void pinToCpu(int cpu) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+}
+
+static inline void* pingPongPartner(void* param) {
+    pingPong* game = param;
+    char token;
+
+    pinToCpu(game->cpu);
+    while (read(game->toPartner[0], &token, 1) == 1) {
+        if (write(game->fromPartner[1], &token, 1) != 1)
+            break;
+    }
+    return NULL;
+}
+
+// Function to measure the cost of one switch between two threads on the same CPU(ns). Returns -1 on failure.
+static inline double measureSwitchCost(void) {
+    pingPong game;
+    pthread_t partner;
+    cpu_set_t previousCpus;
+    char token = 0;
+
+    if (pipe(game.toPartner) == -1) {
+        perror("pipe");
+        return -1;
+    }
+    if (pipe(game.fromPartner) == -1) {
+        perror("pipe");
+        close(game.toPartner[0]);
+        close(game.toPartner[1]);
+        return -1;
+    }
+    game.cpu = sched_getcpu();
+    if (game.cpu < 0)
+        game.cpu = 0;
+    pthread_getaffinity_np(pthread_self(), sizeof(previousCpus), &previousCpus);
+    pinToCpu(game.cpu);
+
+    // The pipes alone: a byte written and read back by the same thread, so no switch
+    unsigned long long start = switchCostClock();
+    for (unsigned int round = 0; round < SWITCH_COST_ROUNDS; round++) {
+        if (write(game.fromPartner[1], &token, 1) != 1 || read(game.fromPartner[0], &token, 1) != 1)
+            break;
+    }
+    double pipeTime = (double)(switchCostClock() - start) / SWITCH_COST_ROUNDS;
+
+    double roundTripTime = -1;
+    if (pthread_create(&partner, NULL, pingPongPartner, &game) == 0) {
+        start = switchCostClock();
+        for (unsigned int round = 0; round < SWITCH_COST_ROUNDS; round++) {
+            if (write(game.toPartner[1], &token, 1) != 1 || read(game.fromPartner[0], &token, 1) != 1)
+                break;
+        }
+        roundTripTime = (double)(switchCostClock() - start) / SWITCH_COST_ROUNDS;
+        close(game.toPartner[1]);   // The partner reads the end of the pipe and returns
+        pthread_join(partner, NULL);
+    } else {
+        close(game.toPartner[1]);
+    }
+    close(game.toPartner[0]);
+    close(game.fromPartner[0]);
+    close(game.fromPartner[1]);
+    pthread_setaffinity_np(pthread_self(), sizeof(previousCpus), &previousCpus);
+    if (roundTripTime < 0)
+        return -1;
+
+    // A round trip is two switches and two pipe transfers
+    double switchCost = (roundTripTime - 2 * pipeTime) / 2;
+    return (switchCost > 0) ? switchCost : 0;
+}
+
+static volatile unsigned int switchCostSink;    // Keeps the reads of the cache measurements from being optimized away
+
+// Function to read one byte from every cache line of a buffer, in the given order of lines(ns)
+static inline double readCacheLines(const volatile char* buffer, const unsigned int* order, size_t numberOfLines) {
+    unsigned long long start = switchCostClock();
+    unsigned int sum = 0;
+    for (size_t index = 0; index < numberOfLines; index++)
+        sum += buffer[(size_t)order[index] * SWITCH_COST_CACHE_LINE];
+    unsigned long long end = switchCostClock();
+    switchCostSink = sum;
+    return (double)(end - start);
+}
+
+// Function to read one byte from every cache line of a buffer, front to back(ns)
+static inline double sweepCacheLines(const volatile char* buffer, size_t length) {
+    unsigned long long start = switchCostClock();
+    unsigned int sum = 0;
+    for (size_t offset = 0; offset < length; offset += SWITCH_COST_CACHE_LINE)
+        sum += buffer[offset];
+    unsigned long long end = switchCostClock();
+    switchCostSink = sum;
+    return (double)(end - start);
+}
+
+// Function to measure the refill cost of a working set and how fast a cache is swept(ns).
+// Returns 0 on success, -1 on failure.
+static inline int measureRefillCost(size_t workingSetSize, double* refillCost, double* warmthDecay) {
+    long cacheSize = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if (cacheSize <= 0)
+        cacheSize = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    if (cacheSize <= 0)
+        cacheSize = SWITCH_COST_DEFAULT_CACHE;
+    size_t flushSize = 4 * (size_t)cacheSize;
+    size_t numberOfLines = (workingSetSize + SWITCH_COST_CACHE_LINE - 1) / SWITCH_COST_CACHE_LINE;
+
+    char* workingSet = malloc(numberOfLines * SWITCH_COST_CACHE_LINE);
+    char* flush = malloc(flushSize);
+    unsigned int* order = malloc(numberOfLines * sizeof(unsigned int));
+    if (workingSet == NULL || flush == NULL || order == NULL) {
+        perror("malloc");
+        free(workingSet);
+        free(flush);
+        free(order);
+        return -1;
+    }
+    memset(workingSet, 1, numberOfLines * SWITCH_COST_CACHE_LINE);
+    memset(flush, 1, flushSize);
+
+    // Shuffled lines(Fisher-Yates with xorshift), so every load is a miss the prefetchers cannot predict
+    unsigned long long randomState = 0x9E3779B97F4A7C15ull;
+    for (size_t index = 0; index < numberOfLines; index++)
+        order[index] = (unsigned int)index;
+    for (size_t index = numberOfLines - 1; index > 0; index--) {
+        randomState ^= randomState << 13;
+        randomState ^= randomState >> 7;
+        randomState ^= randomState << 17;
+        size_t other = randomState % (index + 1);
+        unsigned int line = order[index];
+        order[index] = order[other];
+        order[other] = line;
+    }
+
+    double bestCold = -1, bestWarm = -1, bestSweep = -1;
+    for (unsigned int repetition = 0; repetition < SWITCH_COST_REPETITIONS; repetition++) {
+        double sweepTime = sweepCacheLines(flush, flushSize);
+        double coldTime = readCacheLines(workingSet, order, numberOfLines);
+        double warmTime = readCacheLines(workingSet, order, numberOfLines);
+        if (bestSweep < 0 || sweepTime < bestSweep)
+            bestSweep = sweepTime;
+        if (bestCold < 0 || coldTime < bestCold)
+            bestCold = coldTime;
+        if (bestWarm < 0 || warmTime < bestWarm)
+            bestWarm = warmTime;
+    }
+    free(workingSet);
+    free(flush);
+    free(order);
+
+    *refillCost = (bestCold > bestWarm) ? bestCold - bestWarm : 0;
+    *warmthDecay = bestSweep / 4;   // The flush buffer is four caches long
+    return 0;
+}
+
+// Function to measure the switch cost, the refill cost and the warmth decay on the host.
+// Returns 0 on success, -1 on failure.
+static inline int calibrateSwitchCost(switchCostModel* model) {
+    double switchCost = measureSwitchCost();
+    double refillCost, warmthDecay;
+    if (switchCost < 0 || measureRefillCost(model->workingSetSize, &refillCost, &warmthDecay) == -1)
+        return -1;
+
+    model->switchCost = (unsigned long long)(switchCost + 0.5);
+    model->refillCost = (unsigned long long)(refillCost + 0.5);
+    model->warmthDecay = (unsigned long long)(warmthDecay + 0.5);
+    fprintf(stderr, "Calibrated on this host: switch cost %llu ns, refill cost %llu ns(%llu KiB working set), warmth decay %llu ns\n",
+            model->switchCost, model->refillCost, model->workingSetSize >> 10, model->warmthDecay);
+    return 0;
+}
+
+// Function to parse the command line option at argv[*index] if it belongs to the cost model, moving
+// *index past its value. Returns 1 if it did, 0 if the option is not one of the model, -1 if its value is invalid.
+static inline int parseSwitchCostOption(switchCostModel* model, int argc, char* argv[], int* index) {
+    static const char* const names[] = {"--switch-cost", "--refill-cost", "--warmth-decay", "--unit-length", "--working-set"};
+    unsigned long long* const values[] = {&model->switchCost, &model->refillCost, &model->warmthDecay,
+                                          &model->unitLength, &model->workingSetSize};
+
+    if (strcmp(argv[*index], "--calibrate") == 0) {
+        model->calibrate = true;
+        return 1;
+    }
+    for (unsigned int option = 0; option < sizeof(names) / sizeof(names[0]); option++) {
+        if (strcmp(argv[*index], names[option]) != 0 || *index + 1 >= argc)
+            continue;
+        char* end;
+        const char* text = argv[++*index];
+        *values[option] = strtoull(text, &end, 10);
+        return (end != text && *end == '\0') ? 1 : -1;
+    }
+    return 0;
+}
+
+// Function to finish setting up the model once the command line is parsed. Returns 0 on success, -1 on failure.
+static inline int prepareSwitchCostModel(switchCostModel* model) {
+    if (model->unitLength == 0 || model->workingSetSize == 0) {
+        fprintf(stderr, "The unit length and the working set must not be 0\n");
+        return -1;
+    }
+    if (model->calibrate)
+        return calibrateSwitchCost(model);
+    return 0;
+}
+
+// Function to print what the switches cost over a run of totalTime units
+static inline void printSwitchCostReport(const switchCostModel* model, unsigned long long totalTime) {
+    printf("Switch costs: %llu switches, %.3f ms switching and %.3f ms refilling caches, %llu units(%.2f%% of the time)\n",
+            model->numberOfSwitches, model->totalSwitchCost / 1e6, model->totalRefillCost / 1e6,
+            model->totalOverhead, totalTime > 0 ? 100.0 * model->totalOverhead / totalTime : 0.0);
+}
+
+// Usage text of the options of the model
+#define SWITCH_COST_USAGE "[--switch-cost ns] [--refill-cost ns] [--warmth-decay ns] [--unit-length ns] [--calibrate [--working-set bytes]]"
+
+#endif
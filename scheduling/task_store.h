@@ -0,0 +1,124 @@
+// scheduling/task_store.h
+// Structure-of-arrays storage for the tasks of the scheduling engine(see scheduling_engine.h).
+//
+// Every field of every task lives in its own array, indexed by the slot of the task. The fields
+// that policies read on every decision(remaining time, vruntime, predicted burst) are therefore
+// contiguous, instead of being spread across one large struct per task. Only tasks that have
+// arrived but not completed occupy a slot, and the slot of a completed task is reused by a later
+// arrival, so the store stays as small as the ready set.
+#ifndef TASK_STORE_H
+#define TASK_STORE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "workload_trace.h"
+
+typedef struct {
+    unsigned int capacity;                  // Number of slots
+    unsigned int numberOfTasks;             // Number of slots in use
+    unsigned int* freeSlots;                // Stack of unused slots
+    unsigned int numberOfFreeSlots;
+
+    // Read by the policies on every decision
+    unsigned long long* remainingTime;      // Time left for the task to finish
+    unsigned long long* vruntime;           // Virtual runtime(CFS), in nanoseconds
+    unsigned long long* predictedBurst;     // Predicted burst time(approximated SJF)
+
+    // Only read when a task is admitted, starts or completes
+    unsigned int* id;
+    unsigned long long* arrivalTime;
+    unsigned long long* cpuBurstTime;
+    unsigned long long* startTime;
+    unsigned long long* sequence;           // Order of admission, used to break ties
+    int16_t* priority;
+    int8_t* nice;
+    bool* started;
+} taskStore;
+
+static inline void initTaskStore(taskStore* store) {
+    memset(store, 0, sizeof(*store));
+}
+
+// Function to grow one field array to the new capacity
+static inline int growTaskField(void** field, unsigned int newCapacity, size_t fieldSize) {
+    void* newField = realloc(*field, (size_t)newCapacity * fieldSize);
+    if (newField == NULL) {
+        perror("realloc");
+        return -1;
+    }
+    *field = newField;
+    return 0;
+}
+
+// Function to double the number of slots. The new slots are pushed onto the free stack.
+static inline int growTaskStore(taskStore* store) {
+    unsigned int newCapacity = (store->capacity == 0) ? 64 : store->capacity * 2;
+
+    if (growTaskField((void**)&store->freeSlots, newCapacity, sizeof(unsigned int)) == -1 ||
+            growTaskField((void**)&store->remainingTime, newCapacity, sizeof(unsigned long long)) == -1 ||
+            growTaskField((void**)&store->vruntime, newCapacity, sizeof(unsigned long long)) == -1 ||
+            growTaskField((void**)&store->predictedBurst, newCapacity, sizeof(unsigned long long)) == -1 ||
+            growTaskField((void**)&store->id, newCapacity, sizeof(unsigned int)) == -1 ||
+            growTaskField((void**)&store->arrivalTime, newCapacity, sizeof(unsigned long long)) == -1 ||
+            growTaskField((void**)&store->cpuBurstTime, newCapacity, sizeof(unsigned long long)) == -1 ||
+            growTaskField((void**)&store->startTime, newCapacity, sizeof(unsigned long long)) == -1 ||
+            growTaskField((void**)&store->sequence, newCapacity, sizeof(unsigned long long)) == -1 ||
+            growTaskField((void**)&store->priority, newCapacity, sizeof(int16_t)) == -1 ||
+            growTaskField((void**)&store->nice, newCapacity, sizeof(int8_t)) == -1 ||
+            growTaskField((void**)&store->started, newCapacity, sizeof(bool)) == -1)
+        return -1;
+
+    // Pushed in reverse, so that the lowest new slot is used first
+    for (unsigned int slot = newCapacity; slot > store->capacity; slot--)
+        store->freeSlots[store->numberOfFreeSlots++] = slot - 1;
+    store->capacity = newCapacity;
+    return 0;
+}
+
+// Function to store a newly arrived task. Returns its slot, or -1 if the store could not grow.
+static inline int addTask(taskStore* store, const workloadRecord* record, unsigned long long sequence) {
+    if (store->numberOfFreeSlots == 0 && growTaskStore(store) == -1)
+        return -1;
+
+    unsigned int slot = store->freeSlots[--store->numberOfFreeSlots];
+    store->remainingTime[slot] = record->cpuBurstTime;
+    store->vruntime[slot] = 0;
+    store->predictedBurst[slot] = record->cpuBurstTime;  // Without any history, the prediction is the burst
+    store->id[slot] = record->id;
+    store->arrivalTime[slot] = record->arrivalTime;
+    store->cpuBurstTime[slot] = record->cpuBurstTime;
+    store->startTime[slot] = 0;
+    store->sequence[slot] = sequence;
+    store->priority[slot] = record->priority;
+    store->nice[slot] = record->nice;
+    store->started[slot] = false;
+    store->numberOfTasks++;
+    return (int)slot;
+}
+
+// Function to release the slot of a completed task
+static inline void removeTask(taskStore* store, unsigned int slot) {
+    store->freeSlots[store->numberOfFreeSlots++] = slot;
+    store->numberOfTasks--;
+}
+
+static inline void destroyTaskStore(taskStore* store) {
+    free(store->freeSlots);
+    free(store->remainingTime);
+    free(store->vruntime);
+    free(store->predictedBurst);
+    free(store->id);
+    free(store->arrivalTime);
+    free(store->cpuBurstTime);
+    free(store->startTime);
+    free(store->sequence);
+    free(store->priority);
+    free(store->nice);
+    free(store->started);
+    initTaskStore(store);
+}
+
+#endif
@@ -0,0 +1,179 @@
+// scheduling/timeline.h
+// A run-length-encoded timeline of a simulation: which task held the CPU from when and for how long.
+//
+// The simulators append one segment per run of a task. A run that continues the previous segment
+// (same task, no gap) extends it instead, so a task that keeps the CPU across several decisions
+// takes one segment. Nothing is formatted while the simulation runs. Once it is over, a renderer
+// writes the timeline as a Gantt chart, as CSV, or as a Chrome trace(JSON for chrome://tracing or
+// Perfetto, one time unit shown as one microsecond).
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef struct {
+    uint64_t start;         // Time when the task got the CPU
+    uint64_t length;        // How long it kept it
+    uint32_t taskId;
+} timelineSegment;
+
+typedef struct {
+    timelineSegment* segments;
+    size_t numberOfSegments;
+    size_t capacity;
+} timeline;
+
+typedef enum {
+    TIMELINE_GANTT,
+    TIMELINE_CSV,
+    TIMELINE_CHROME_TRACE
+} timelineFormat;
+
+static inline void initTimeline(timeline* recordedTimeline) {
+    memset(recordedTimeline, 0, sizeof(*recordedTimeline));
+}
+
+// Function to record that a task ran from start for length. Returns 0 on success, -1 on failure.
+static inline int recordRun(timeline* recordedTimeline, uint32_t taskId, uint64_t start, uint64_t length) {
+    if (length == 0)
+        return 0;
+
+    if (recordedTimeline->numberOfSegments > 0) {
+        timelineSegment* last = &recordedTimeline->segments[recordedTimeline->numberOfSegments - 1];
+        if (last->taskId == taskId && last->start + last->length == start) {
+            last->length += length;
+            return 0;
+        }
+    }
+
+    if (recordedTimeline->numberOfSegments == recordedTimeline->capacity) {
+        size_t newCapacity = (recordedTimeline->capacity == 0) ? 1024 : recordedTimeline->capacity * 2;
+        timelineSegment* newSegments = realloc(recordedTimeline->segments, newCapacity * sizeof(timelineSegment));
+        if (newSegments == NULL) {
+            perror("realloc");
+            return -1;
+        }
+        recordedTimeline->segments = newSegments;
+        recordedTimeline->capacity = newCapacity;
+    }
+
+    timelineSegment segment = {start, length, taskId};
+    recordedTimeline->segments[recordedTimeline->numberOfSegments++] = segment;
+    return 0;
+}
+
+static inline void destroyTimeline(timeline* recordedTimeline) {
+    free(recordedTimeline->segments);
+    initTimeline(recordedTimeline);
+}
+
+// Function to parse the name of a format("gantt", "csv" or "json"). Returns 0 on success, -1 if unknown.
+static inline int parseTimelineFormat(const char* name, timelineFormat* format) {
+    if (strcmp(name, "gantt") == 0)
+        *format = TIMELINE_GANTT;
+    else if (strcmp(name, "csv") == 0)
+        *format = TIMELINE_CSV;
+    else if (strcmp(name, "json") == 0)
+        *format = TIMELINE_CHROME_TRACE;
+    else
+        return -1;
+    return 0;
+}
+
+// Function to render the timeline as a Gantt chart, in the layout of the demos' charts:
+// two columns per time unit, and idle gaps shown as "idle"
+static inline void renderGanttChart(const timeline* recordedTimeline, FILE* output) {
+    uint64_t end = 0;
+
+    fprintf(output, "\nGantt Chart:\n");
+
+    // Display the task IDs in Gantt chart format
+    fprintf(output, "Task ID:   ");
+    for (size_t index = 0; index < recordedTimeline->numberOfSegments; index++) {
+        const timelineSegment* segment = &recordedTimeline->segments[index];
+        if (segment->start > end) {
+            fprintf(output, "idle ");
+            for (uint64_t time = 1; time < segment->start - end; time++)
+                fputs("  ", output);
+        }
+        fprintf(output, "T%u ", segment->taskId);
+        for (uint64_t time = 1; time < segment->length; time++)
+            fputs("  ", output);    // Add spaces for the duration of the task
+        end = segment->start + segment->length;
+    }
+    fprintf(output, "\n");
+
+    // Display the timeline (start and end times) beneath the task IDs
+    end = 0;
+    fprintf(output, "Time:      ");
+    for (size_t index = 0; index < recordedTimeline->numberOfSegments; index++) {
+        const timelineSegment* segment = &recordedTimeline->segments[index];
+        if (segment->start > end) {
+            fprintf(output, "%llu", (unsigned long long)end);
+            for (uint64_t time = 1; time <= segment->start - end; time++)
+                fputs("  ", output);
+        }
+        fprintf(output, "%llu", (unsigned long long)segment->start);
+        for (uint64_t time = 1; time <= segment->length; time++)
+            fputs("--", output);
+        end = segment->start + segment->length;
+    }
+    fprintf(output, "%llu\n", (unsigned long long)end);
+}
+
+// Function to render the timeline as CSV, one segment per line
+static inline void renderTimelineCsv(const timeline* recordedTimeline, FILE* output) {
+    fprintf(output, "task,start,length\n");
+    for (size_t index = 0; index < recordedTimeline->numberOfSegments; index++) {
+        const timelineSegment* segment = &recordedTimeline->segments[index];
+        fprintf(output, "%u,%llu,%llu\n", segment->taskId,
+                (unsigned long long)segment->start, (unsigned long long)segment->length);
+    }
+}
+
+// Function to render the timeline in the Chrome trace event format, one complete("X") event per segment
+static inline void renderChromeTrace(const timeline* recordedTimeline, FILE* output) {
+    fprintf(output, "{\"traceEvents\":[\n");
+    fprintf(output, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"CPU 0\"}}");
+    for (size_t index = 0; index < recordedTimeline->numberOfSegments; index++) {
+        const timelineSegment* segment = &recordedTimeline->segments[index];
+        fprintf(output, ",\n{\"name\":\"task %u\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":%llu,\"dur\":%llu}", segment->taskId,
+                (unsigned long long)segment->start, (unsigned long long)segment->length);
+    }
+    fprintf(output, "\n]}\n");
+}
+
+// Function to write the timeline in a format to a file, or to stdout if path is NULL
+static inline int writeTimeline(const timeline* recordedTimeline, timelineFormat format, const char* path) {
+    FILE* output = stdout;
+    if (path != NULL) {
+        output = fopen(path, "w");
+        if (output == NULL) {
+            perror("fopen");
+            return -1;
+        }
+    }
+
+    switch (format) {
+    case TIMELINE_GANTT:
+        renderGanttChart(recordedTimeline, output);
+        break;
+    case TIMELINE_CSV:
+        renderTimelineCsv(recordedTimeline, output);
+        break;
+    case TIMELINE_CHROME_TRACE:
+        renderChromeTrace(recordedTimeline, output);
+        break;
+    }
+
+    if (path != NULL && fclose(output) != 0) {
+        perror("fclose");
+        return -1;
+    }
+    return 0;
+}
+
+#endif
@@ -0,0 +1,248 @@
+// scheduling/workload_generator.h
+// A synthetic workload generator that yields tasks one at a time, so a workload of any length
+// takes constant memory. The same spec and seed always yield the same tasks.
+//
+// A workload is described by a spec string, which openWorkloadTrace(workload_trace.h) accepts in
+// place of a trace path, so every simulator can run on a generated workload:
+//
+//   gen:tasks=100000000,arrivals=bursty,bursts=pareto,shape=1.2,mean=10,load=0.9,nice=-5:5,seed=7
+//
+//   tasks       number of tasks(default 1000000)
+//   arrivals    poisson: exponential gaps between arrivals(default)
+//               bursty: arrivals only during ON periods, none during OFF periods. ON and OFF periods
+//               last exponential times of mean on= and off=(default 50 and 200 mean bursts), and the
+//               arrival rate during ON periods keeps the average load at load=
+//   load        mean burst / mean gap between arrivals(default 0.9)
+//   bursts      exponential(default), pareto(shape= above 1, default 1.5), or bimodal(a fraction
+//               long= of the tasks are ratio= times longer than the others, default 0.1 and 20)
+//   mean        mean CPU burst(default 10)
+//   nice        a nice value, or a range min:max drawn uniformly(default 0)
+//   seed        seed of the random numbers(default 42)
+//
+// The distributions use log and pow: programs that open generated workloads link with -lm.
+#ifndef WORKLOAD_GENERATOR_H
+#define WORKLOAD_GENERATOR_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+#define WORKLOAD_GENERATOR_PREFIX "gen:"
+#define WORKLOAD_GENERATOR_MAX_BURST 1e15      // Keeps the tail of a Pareto distribution in range
+
+typedef enum {
+    ARRIVALS_POISSON,
+    ARRIVALS_BURSTY
+} arrivalProcess;
+
+typedef enum {
+    BURSTS_EXPONENTIAL,
+    BURSTS_PARETO,
+    BURSTS_BIMODAL
+} burstDistribution;
+
+typedef struct {
+    uint64_t numberOfTasks;
+    arrivalProcess arrivals;
+    double load;
+    double meanOnTime;              // Bursty arrivals only
+    double meanOffTime;
+    burstDistribution bursts;
+    double meanBurst;
+    double paretoShape;             // Pareto bursts only
+    double longFraction;            // Bimodal bursts only
+    double longRatio;
+    int minNice;
+    int maxNice;
+    uint64_t seed;
+} workloadGeneratorSpec;
+
+typedef struct {
+    workloadGeneratorSpec spec;
+    uint64_t randomState;
+    double clock;                   // Arrival time of the last task, before rounding
+    double onEnd;                   // End of the current ON period(bursty arrivals)
+    double arrivalRate;             // Arrivals per time unit(during ON periods, if bursty)
+    double shortBurst;              // Bimodal bursts only
+    double paretoScale;             // Smallest Pareto burst
+    uint64_t numberOfGeneratedTasks;
+} workloadGenerator;
+
+static inline bool isWorkloadGeneratorSpec(const char* text) {
+    return strncmp(text, WORKLOAD_GENERATOR_PREFIX, strlen(WORKLOAD_GENERATOR_PREFIX)) == 0;
+}
+
+// Function to parse a spec string(see above). Returns 0 on success, -1 on failure.
+static inline int parseWorkloadGeneratorSpec(const char* text, workloadGeneratorSpec* spec) {
+    workloadGeneratorSpec defaults = {1000000, ARRIVALS_POISSON, 0.9, -1, -1, BURSTS_EXPONENTIAL, 10, 1.5, 0.1, 20, 0, 0, 42};
+    char buffer[512];
+
+    *spec = defaults;
+    if (!isWorkloadGeneratorSpec(text) || strlen(text) >= sizeof(buffer)) {
+        fprintf(stderr, "%s is not a workload generator spec\n", text);
+        return -1;
+    }
+    strcpy(buffer, text + strlen(WORKLOAD_GENERATOR_PREFIX));
+
+    char* savePointer;
+    for (char* option = strtok_r(buffer, ",", &savePointer); option != NULL; option = strtok_r(NULL, ",", &savePointer)) {
+        char* value = strchr(option, '=');
+        if (value == NULL) {
+            fprintf(stderr, "Workload generator option %s has no value\n", option);
+            return -1;
+        }
+        *value++ = '\0';
+
+        bool valid = true;
+        if (strcmp(option, "tasks") == 0)
+            spec->numberOfTasks = strtoull(value, NULL, 10);
+        else if (strcmp(option, "arrivals") == 0 && strcmp(value, "poisson") == 0)
+            spec->arrivals = ARRIVALS_POISSON;
+        else if (strcmp(option, "arrivals") == 0 && strcmp(value, "bursty") == 0)
+            spec->arrivals = ARRIVALS_BURSTY;
+        else if (strcmp(option, "load") == 0)
+            spec->load = strtod(value, NULL);
+        else if (strcmp(option, "on") == 0)
+            spec->meanOnTime = strtod(value, NULL);
+        else if (strcmp(option, "off") == 0)
+            spec->meanOffTime = strtod(value, NULL);
+        else if (strcmp(option, "bursts") == 0 && strcmp(value, "exponential") == 0)
+            spec->bursts = BURSTS_EXPONENTIAL;
+        else if (strcmp(option, "bursts") == 0 && strcmp(value, "pareto") == 0)
+            spec->bursts = BURSTS_PARETO;
+        else if (strcmp(option, "bursts") == 0 && strcmp(value, "bimodal") == 0)
+            spec->bursts = BURSTS_BIMODAL;
+        else if (strcmp(option, "mean") == 0)
+            spec->meanBurst = strtod(value, NULL);
+        else if (strcmp(option, "shape") == 0)
+            spec->paretoShape = strtod(value, NULL);
+        else if (strcmp(option, "long") == 0)
+            spec->longFraction = strtod(value, NULL);
+        else if (strcmp(option, "ratio") == 0)
+            spec->longRatio = strtod(value, NULL);
+        else if (strcmp(option, "nice") == 0) {
+            int numberOfValues = sscanf(value, "%d:%d", &spec->minNice, &spec->maxNice);
+            if (numberOfValues == 1)
+                spec->maxNice = spec->minNice;
+            valid = (numberOfValues >= 1);
+        } else if (strcmp(option, "seed") == 0)
+            spec->seed = strtoull(value, NULL, 10);
+        else
+            valid = false;
+
+        if (!valid) {
+            fprintf(stderr, "Invalid workload generator option %s=%s\n", option, value);
+            return -1;
+        }
+    }
+
+    if (spec->meanOnTime < 0)
+        spec->meanOnTime = 50 * spec->meanBurst;
+    if (spec->meanOffTime < 0)
+        spec->meanOffTime = 200 * spec->meanBurst;
+
+    if (spec->numberOfTasks == 0 || spec->load <= 0 || spec->meanBurst < 1 ||
+            spec->meanOnTime <= 0 || spec->meanOffTime <= 0 || spec->paretoShape <= 1 ||
+            spec->longFraction < 0 || spec->longFraction > 1 || spec->longRatio < 1 ||
+            spec->minNice < -20 || spec->maxNice > 19 || spec->minNice > spec->maxNice) {
+        fprintf(stderr, "Workload generator spec %s is out of range\n", text);
+        return -1;
+    }
+    return 0;
+}
+
+// Function to get the next 64 random bits(xorshift64*)
+static inline uint64_t nextGeneratorRandom(workloadGenerator* generator) {
+    generator->randomState ^= generator->randomState >> 12;
+    generator->randomState ^= generator->randomState << 25;
+    generator->randomState ^= generator->randomState >> 27;
+    return generator->randomState * 0x2545F4914F6CDD1Dull;
+}
+
+// Function to draw a number uniformly from (0, 1]
+static inline double drawUniform(workloadGenerator* generator) {
+    return ((nextGeneratorRandom(generator) >> 11) + 1) * (1.0 / 9007199254740992.0);
+}
+
+static inline double drawExponential(workloadGenerator* generator, double mean) {
+    return -mean * log(drawUniform(generator));
+}
+
+static inline void initWorkloadGenerator(workloadGenerator* generator, const workloadGeneratorSpec* spec) {
+    memset(generator, 0, sizeof(*generator));
+    generator->spec = *spec;
+
+    // splitmix64 of the seed, so that neighbouring seeds give unrelated streams(and never the zero state)
+    uint64_t seed = spec->seed + 0x9E3779B97F4A7C15ull;
+    seed = (seed ^ (seed >> 30)) * 0xBF58476D1CE4E5B9ull;
+    seed = (seed ^ (seed >> 27)) * 0x94D049BB133111EBull;
+    generator->randomState = (seed ^ (seed >> 31)) | 1;
+
+    generator->arrivalRate = spec->load / spec->meanBurst;
+    if (spec->arrivals == ARRIVALS_BURSTY) {
+        // Only a fraction of the time is ON, so arrivals come faster while it is
+        generator->arrivalRate *= (spec->meanOnTime + spec->meanOffTime) / spec->meanOnTime;
+        generator->onEnd = drawExponential(generator, spec->meanOnTime);
+    }
+
+    // Mean of the bimodal mix: (1 - long) * short + long * ratio * short
+    generator->shortBurst = spec->meanBurst / (1 + spec->longFraction * (spec->longRatio - 1));
+    generator->paretoScale = spec->meanBurst * (spec->paretoShape - 1) / spec->paretoShape;
+}
+
+// Function to draw the time of the next arrival
+static inline double drawArrival(workloadGenerator* generator) {
+    const workloadGeneratorSpec* spec = &generator->spec;
+    double arrival = generator->clock + drawExponential(generator, 1 / generator->arrivalRate);
+
+    // Gaps are memoryless: an arrival that would fall after the ON period is drawn again from the next one
+    while (spec->arrivals == ARRIVALS_BURSTY && arrival > generator->onEnd) {
+        double onStart = generator->onEnd + drawExponential(generator, spec->meanOffTime);
+        generator->onEnd = onStart + drawExponential(generator, spec->meanOnTime);
+        arrival = onStart + drawExponential(generator, 1 / generator->arrivalRate);
+    }
+    return arrival;
+}
+
+static inline double drawBurst(workloadGenerator* generator) {
+    const workloadGeneratorSpec* spec = &generator->spec;
+
+    switch (spec->bursts) {
+    case BURSTS_PARETO: {
+        double burst = generator->paretoScale * pow(drawUniform(generator), -1 / spec->paretoShape);
+        return (burst < WORKLOAD_GENERATOR_MAX_BURST) ? burst : WORKLOAD_GENERATOR_MAX_BURST;
+    }
+    case BURSTS_BIMODAL:
+        if (drawUniform(generator) <= spec->longFraction)
+            return generator->shortBurst * spec->longRatio;
+        return generator->shortBurst;
+    default:
+        return drawExponential(generator, spec->meanBurst);
+    }
+}
+
+// Function to yield the next task. Returns false once every task has been yielded.
+static inline bool nextGeneratedTask(workloadGenerator* generator, uint64_t* arrivalTime, uint64_t* cpuBurstTime, int* nice) {
+    const workloadGeneratorSpec* spec = &generator->spec;
+    if (generator->numberOfGeneratedTasks >= spec->numberOfTasks)
+        return false;
+
+    generator->clock = drawArrival(generator);
+    *arrivalTime = (uint64_t)generator->clock;
+
+    // Rounded up with the probability of the fraction, so that rounding keeps the mean, but at least one
+    double burst = drawBurst(generator) + (1 - drawUniform(generator));
+    *cpuBurstTime = (burst < 1) ? 1 : (uint64_t)burst;
+
+    *nice = spec->minNice;
+    if (spec->maxNice > spec->minNice)
+        *nice += (int)(nextGeneratorRandom(generator) % (uint64_t)(spec->maxNice - spec->minNice + 1));
+
+    generator->numberOfGeneratedTasks++;
+    return true;
+}
+
+#endif
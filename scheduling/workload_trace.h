@@ -0,0 +1,312 @@
+// scheduling/workload_trace.h
+// A compact binary workload trace shared by the scheduling simulators.
+//
+// A trace file is a 32-byte header followed by fixed-size 24-byte records, one per task,
+// sorted by arrival time. Fields are stored in the host byte order.
+//
+//   header: magic "SCHEDTRC" | version(u32) | recordSize(u32) | numberOfRecords(u64) | reserved(u64)
+//   record: arrivalTime(u64) | cpuBurstTime(u64) | id(u32) | priority(i16) | nice(i8) | reserved(u8)
+//
+// The reader maps the file, checks once that the records are sorted by arrival time(every simulator
+// depends on it, and the writer enforces it), and hands out records one at a time. Pages that have been consumed
+// are released as the cursor moves forward, so replaying a trace of any length takes bounded memory.
+// Instead of a path, the reader also accepts a workload generator spec("gen:...", see
+// workload_generator.h): the records are then generated one ahead of the cursor, in constant memory.
+// Everything is static inline so that every simulator can still be compiled as a single file.
+#ifndef WORKLOAD_TRACE_H
+#define WORKLOAD_TRACE_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "workload_generator.h"
+
+#define WORKLOAD_TRACE_MAGIC "SCHEDTRC"
+#define WORKLOAD_TRACE_VERSION 1
+#define WORKLOAD_TRACE_RELEASE_CHUNK (16u << 20)   // Release consumed pages every 16MiB
+
+typedef struct {
+    char magic[8];              // Always WORKLOAD_TRACE_MAGIC(not NUL-terminated)
+    uint32_t version;           // Format version
+    uint32_t recordSize;        // sizeof(workloadRecord), to catch mismatched builds
+    uint64_t numberOfRecords;   // Number of records following the header
+    uint64_t reserved;
+} workloadTraceHeader;
+
+typedef struct {
+    uint64_t arrivalTime;       // Time when the task arrives in the system
+    uint64_t cpuBurstTime;      // Time the task needs on the CPU
+    uint32_t id;                // Task ID
+    int16_t priority;           // Static priority(smaller is more important)
+    int8_t nice;                // Nice value, -20 to 19
+    uint8_t reserved;
+} workloadRecord;
+
+// Streaming reader. It either maps a trace file, walks over records that are already in memory,
+// or generates the records as they are consumed.
+typedef struct {
+    const workloadRecord* records;  // First record
+    uint64_t numberOfRecords;       // Number of records in the trace
+    uint64_t nextRecord;            // Index of the next record to hand out
+    void* mapping;                  // Start of the file mapping(NULL for in-memory records)
+    size_t mappingLength;           // Length of the file mapping
+    size_t releasedLength;          // Length of the mapping prefix already released
+    bool generated;                 // Whether the records come from the generator
+    workloadGenerator generator;
+    workloadRecord generatedRecords[2];     // Record i is in generatedRecords[i & 1]
+} workloadTrace;
+
+// Writer. Records are appended through stdio and the header is completed when the writer is closed.
+typedef struct {
+    FILE* file;
+    uint64_t numberOfRecords;
+    uint64_t lastArrivalTime;
+} workloadTraceWriter;
+
+// Function to open a trace file for writing. Returns 0 on success, -1 on failure.
+static inline int openWorkloadTraceWriter(workloadTraceWriter* writer, const char* path) {
+    workloadTraceHeader header = {0};
+
+    writer->file = fopen(path, "wb");
+    if (writer->file == NULL) {
+        perror("fopen");
+        return -1;
+    }
+    writer->numberOfRecords = 0;
+    writer->lastArrivalTime = 0;
+
+    // A placeholder header, rewritten with the real record count on close
+    memcpy(header.magic, WORKLOAD_TRACE_MAGIC, sizeof(header.magic));
+    header.version = WORKLOAD_TRACE_VERSION;
+    header.recordSize = sizeof(workloadRecord);
+    if (fwrite(&header, sizeof(header), 1, writer->file) != 1) {
+        perror("fwrite");
+        fclose(writer->file);
+        return -1;
+    }
+    return 0;
+}
+
+// Function to append a record. Records must be appended in the order of their arrival time.
+static inline int writeWorkloadRecord(workloadTraceWriter* writer, const workloadRecord* record) {
+    if (writer->numberOfRecords > 0 && record->arrivalTime < writer->lastArrivalTime) {
+        fprintf(stderr, "Task %u arrives at %llu, before the previous task(%llu). Records must be sorted by arrival time.\n",
+                record->id, (unsigned long long)record->arrivalTime, (unsigned long long)writer->lastArrivalTime);
+        return -1;
+    }
+    if (fwrite(record, sizeof(*record), 1, writer->file) != 1) {
+        perror("fwrite");
+        return -1;
+    }
+    writer->numberOfRecords++;
+    writer->lastArrivalTime = record->arrivalTime;
+    return 0;
+}
+
+// Function to complete the header and close the file. Returns 0 on success, -1 on failure.
+static inline int closeWorkloadTraceWriter(workloadTraceWriter* writer) {
+    workloadTraceHeader header = {0};
+    int result = 0;
+
+    memcpy(header.magic, WORKLOAD_TRACE_MAGIC, sizeof(header.magic));
+    header.version = WORKLOAD_TRACE_VERSION;
+    header.recordSize = sizeof(workloadRecord);
+    header.numberOfRecords = writer->numberOfRecords;
+
+    if (fseek(writer->file, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, writer->file) != 1) {
+        perror("fwrite");
+        result = -1;
+    }
+    if (fclose(writer->file) != 0) {
+        perror("fclose");
+        result = -1;
+    }
+    return result;
+}
+
+// Function to generate record index into its slot. The slot of the previous record is left alone,
+// so a record handed out stays valid while the next one is peeked at.
+static inline void generateWorkloadRecord(workloadTrace* trace, uint64_t index) {
+    workloadRecord* record = &trace->generatedRecords[index & 1];
+    uint64_t arrivalTime = 0, cpuBurstTime = 0;
+    int nice = 0;
+
+    nextGeneratedTask(&trace->generator, &arrivalTime, &cpuBurstTime, &nice);
+    memset(record, 0, sizeof(*record));
+    record->arrivalTime = arrivalTime;
+    record->cpuBurstTime = cpuBurstTime;
+    record->id = (uint32_t)(index + 1);
+    record->nice = (int8_t)nice;
+}
+
+// Function to stream over a generated workload. Returns 0 on success, -1 on failure.
+// The records point into the trace, so it must not be moved while it is open.
+static inline int openGeneratedWorkloadTrace(workloadTrace* trace, const char* spec) {
+    workloadGeneratorSpec generatorSpec;
+    if (parseWorkloadGeneratorSpec(spec, &generatorSpec) == -1)
+        return -1;
+
+    initWorkloadGenerator(&trace->generator, &generatorSpec);
+    trace->records = NULL;
+    trace->numberOfRecords = generatorSpec.numberOfTasks;
+    trace->nextRecord = 0;
+    trace->mapping = NULL;
+    trace->mappingLength = 0;
+    trace->releasedLength = 0;
+    trace->generated = true;
+    generateWorkloadRecord(trace, 0);
+    return 0;
+}
+
+// Function to find the first record of a mapped trace that arrives before the one ahead of it.
+// Returns numberOfRecords if they are sorted. The pages are released as the scan moves forward,
+// like the reader does, so the check takes bounded memory too.
+static inline uint64_t findUnsortedRecord(void* mapping, const workloadRecord records[], uint64_t numberOfRecords) {
+    size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    size_t releasedLength = 0;
+
+    for (uint64_t index = 1; index < numberOfRecords; index++) {
+        if (records[index].arrivalTime < records[index - 1].arrivalTime)
+            return index;
+        size_t scannedLength = (const char*)&records[index - 1] - (const char*)mapping;
+        if (scannedLength - releasedLength >= WORKLOAD_TRACE_RELEASE_CHUNK) {
+            size_t releaseEnd = scannedLength & ~(pageSize - 1);
+            madvise((char*)mapping + releasedLength, releaseEnd - releasedLength, MADV_DONTNEED);
+            releasedLength = releaseEnd;
+        }
+    }
+    return numberOfRecords;
+}
+
+// Function to open a trace file(or a generator spec) for streaming. Returns 0 on success, -1 on failure.
+static inline int openWorkloadTrace(workloadTrace* trace, const char* path) {
+    struct stat fileStatus;
+    if (isWorkloadGeneratorSpec(path))
+        return openGeneratedWorkloadTrace(trace, path);
+
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        perror("open");
+        return -1;
+    }
+    if (fstat(fd, &fileStatus) == -1) {
+        perror("fstat");
+        close(fd);
+        return -1;
+    }
+    if ((size_t)fileStatus.st_size < sizeof(workloadTraceHeader)) {
+        fprintf(stderr, "%s is too small to be a workload trace\n", path);
+        close(fd);
+        return -1;
+    }
+
+    void* mapping = mmap(NULL, fileStatus.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);  // The mapping stays valid after the descriptor is closed
+    if (mapping == MAP_FAILED) {
+        perror("mmap");
+        return -1;
+    }
+
+    const workloadTraceHeader* header = mapping;
+    if (memcmp(header->magic, WORKLOAD_TRACE_MAGIC, sizeof(header->magic)) != 0
+            || header->version != WORKLOAD_TRACE_VERSION
+            || header->recordSize != sizeof(workloadRecord)
+            || header->numberOfRecords > (fileStatus.st_size - sizeof(workloadTraceHeader)) / sizeof(workloadRecord)) {
+        fprintf(stderr, "%s is not a valid workload trace\n", path);
+        munmap(mapping, fileStatus.st_size);
+        return -1;
+    }
+
+    // The trace is read from the front to the back: once to check its order, once to replay it
+    madvise(mapping, fileStatus.st_size, MADV_SEQUENTIAL);
+
+    const workloadRecord* records = (const workloadRecord*)((const char*)mapping + sizeof(workloadTraceHeader));
+    uint64_t unsortedRecord = findUnsortedRecord(mapping, records, header->numberOfRecords);
+    if (unsortedRecord != header->numberOfRecords) {
+        fprintf(stderr, "%s is not sorted by arrival time(record %llu arrives at %llu, before the previous one at %llu)\n",
+                path, (unsigned long long)unsortedRecord, (unsigned long long)records[unsortedRecord].arrivalTime,
+                (unsigned long long)records[unsortedRecord - 1].arrivalTime);
+        munmap(mapping, fileStatus.st_size);
+        return -1;
+    }
+
+    trace->records = records;
+    trace->numberOfRecords = header->numberOfRecords;
+    trace->nextRecord = 0;
+    trace->mapping = mapping;
+    trace->mappingLength = fileStatus.st_size;
+    trace->releasedLength = 0;
+    trace->generated = false;
+    return 0;
+}
+
+// Function to stream over records that are already in memory(e.g. a small built-in demo workload)
+static inline void openWorkloadTraceFromRecords(workloadTrace* trace, const workloadRecord records[], uint64_t numberOfRecords) {
+    trace->records = records;
+    trace->numberOfRecords = numberOfRecords;
+    trace->nextRecord = 0;
+    trace->mapping = NULL;
+    trace->mappingLength = 0;
+    trace->releasedLength = 0;
+    trace->generated = false;
+}
+
+// Function to look at the next record without consuming it. Returns NULL at the end of the trace.
+static inline const workloadRecord* peekWorkloadRecord(const workloadTrace* trace) {
+    if (trace->nextRecord >= trace->numberOfRecords)
+        return NULL;
+    if (trace->generated)
+        return &trace->generatedRecords[trace->nextRecord & 1];
+    return &trace->records[trace->nextRecord];
+}
+
+// Function to consume the next record. Returns NULL at the end of the trace.
+// The returned record stays valid until the next call.
+static inline const workloadRecord* nextWorkloadRecord(workloadTrace* trace) {
+    if (trace->nextRecord >= trace->numberOfRecords)
+        return NULL;
+
+    if (trace->generated) {
+        const workloadRecord* record = &trace->generatedRecords[trace->nextRecord & 1];
+        if (++trace->nextRecord < trace->numberOfRecords)
+            generateWorkloadRecord(trace, trace->nextRecord);
+        return record;
+    }
+
+    const workloadRecord* record = &trace->records[trace->nextRecord++];
+
+    // Give back the pages behind the cursor, so the resident part of the trace stays small
+    if (trace->mapping != NULL) {
+        size_t consumedLength = (const char*)record - (const char*)trace->mapping;
+        if (consumedLength - trace->releasedLength >= WORKLOAD_TRACE_RELEASE_CHUNK) {
+            size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+            size_t releaseEnd = consumedLength & ~(pageSize - 1);
+            madvise((char*)trace->mapping + trace->releasedLength, releaseEnd - trace->releasedLength, MADV_DONTNEED);
+            trace->releasedLength = releaseEnd;
+        }
+    }
+    return record;
+}
+
+// Function to check whether another task arrives by the given time
+static inline bool hasArrivalBy(const workloadTrace* trace, uint64_t timestamp) {
+    const workloadRecord* record = peekWorkloadRecord(trace);
+    return record != NULL && record->arrivalTime <= timestamp;
+}
+
+// Function to release the trace
+static inline void closeWorkloadTrace(workloadTrace* trace) {
+    if (trace->mapping != NULL)
+        munmap(trace->mapping, trace->mappingLength);
+    trace->mapping = NULL;
+    trace->records = NULL;
+    trace->numberOfRecords = 0;
+    trace->nextRecord = 0;
+}
+
+#endif
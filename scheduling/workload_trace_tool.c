@@ -0,0 +1,143 @@
+// scheduling/workload_trace_tool.c
+// Creates and inspects binary workload traces(see workload_trace.h) for the scheduling simulators.
+//
+// Usage: ./workload_trace_tool.out write <trace>                       (text records from stdin)
+//        ./workload_trace_tool.out generate <trace> <numberOfTasks> [seed]
+//        ./workload_trace_tool.out generate <trace> gen:<spec>             (see workload_generator.h)
+//        ./workload_trace_tool.out dump <trace>
+//
+// Text records are one task per line: "id arrivalTime cpuBurstTime [priority [nice]]".
+// Empty lines and lines starting with '#' are ignored.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "workload_trace.h"
+
+// Function to convert text records from stdin into a binary trace
+int writeTraceFromText(const char* path) {
+    workloadTraceWriter writer;
+    char line[256];
+    unsigned long long lineNumber = 0;
+
+    if (openWorkloadTraceWriter(&writer, path) == -1)
+        return 1;
+
+    while (fgets(line, sizeof(line), stdin) != NULL) {
+        unsigned int id;
+        unsigned long long arrivalTime, cpuBurstTime;
+        int priority = 0, nice = 0;
+
+        lineNumber++;
+        if (line[0] == '#' || line[0] == '\n')
+            continue;
+
+        int numberOfFields = sscanf(line, "%u %llu %llu %d %d", &id, &arrivalTime, &cpuBurstTime, &priority, &nice);
+        if (numberOfFields < 3 || cpuBurstTime == 0 || nice < -20 || nice > 19) {
+            fprintf(stderr, "Line %llu: invalid record\n", lineNumber);
+            closeWorkloadTraceWriter(&writer);
+            return 1;
+        }
+
+        workloadRecord record = {arrivalTime, cpuBurstTime, id, (int16_t)priority, (int8_t)nice, 0};
+        if (writeWorkloadRecord(&writer, &record) == -1) {
+            closeWorkloadTraceWriter(&writer);
+            return 1;
+        }
+    }
+
+    printf("Wrote %llu tasks to %s\n", (unsigned long long)writer.numberOfRecords, path);
+    return closeWorkloadTraceWriter(&writer) == 0 ? 0 : 1;
+}
+
+// Function to write a synthetic workload, so that the schedulers can be tried with a huge number of tasks
+int generateTrace(const char* path, unsigned long long numberOfTasks, unsigned int seed) {
+    workloadTraceWriter writer;
+    unsigned long long arrivalTime = 0;
+
+    if (openWorkloadTraceWriter(&writer, path) == -1)
+        return 1;
+
+    srand(seed);  // Fixed seed, so that every run generates the same workload
+    for (unsigned long long index = 0; index < numberOfTasks; index++) {
+        workloadRecord record = {0};
+        record.id = (uint32_t)(index + 1);
+        record.arrivalTime = arrivalTime;
+        record.cpuBurstTime = 1 + rand() % 20;
+        record.nice = (int8_t)(rand() % 40 - 20);
+        if (writeWorkloadRecord(&writer, &record) == -1) {
+            closeWorkloadTraceWriter(&writer);
+            return 1;
+        }
+        arrivalTime += rand() % 24;    // About 11.5 units apart, so the CPU is busy ~90% of the time
+    }
+
+    printf("Wrote %llu tasks to %s\n", numberOfTasks, path);
+    return closeWorkloadTraceWriter(&writer) == 0 ? 0 : 1;
+}
+
+// Function to write the workload of a generator spec, e.g. to replay it without generating it again
+int generateTraceFromSpec(const char* path, const char* spec) {
+    workloadTrace generatedTrace;
+    workloadTraceWriter writer;
+    const workloadRecord* record;
+
+    if (openWorkloadTrace(&generatedTrace, spec) == -1 || openWorkloadTraceWriter(&writer, path) == -1)
+        return 1;
+
+    while ((record = nextWorkloadRecord(&generatedTrace)) != NULL) {
+        if (writeWorkloadRecord(&writer, record) == -1) {
+            closeWorkloadTraceWriter(&writer);
+            return 1;
+        }
+    }
+
+    printf("Wrote %llu tasks to %s\n", (unsigned long long)writer.numberOfRecords, path);
+    return closeWorkloadTraceWriter(&writer) == 0 ? 0 : 1;
+}
+
+// Function to print a binary trace in the text format accepted by "write"
+int dumpTrace(const char* path) {
+    workloadTrace trace;
+    const workloadRecord* record;
+
+    if (openWorkloadTrace(&trace, path) == -1)
+        return 1;
+
+    printf("# %llu tasks\n", (unsigned long long)trace.numberOfRecords);
+    printf("# id arrivalTime cpuBurstTime priority nice\n");
+    while ((record = nextWorkloadRecord(&trace)) != NULL) {
+        printf("%u %llu %llu %d %d\n",
+                record->id,
+                (unsigned long long)record->arrivalTime,
+                (unsigned long long)record->cpuBurstTime,
+                record->priority,
+                record->nice);
+    }
+
+    closeWorkloadTrace(&trace);
+    return 0;
+}
+
+void printUsage(const char* programName) {
+    fprintf(stderr, "Usage: %s write <trace>\n", programName);
+    fprintf(stderr, "       %s generate <trace> <numberOfTasks> [seed]\n", programName);
+    fprintf(stderr, "       %s generate <trace> gen:<spec>\n", programName);
+    fprintf(stderr, "       %s dump <trace>\n", programName);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 3 && strcmp(argv[1], "write") == 0)
+        return writeTraceFromText(argv[2]);
+    if (argc == 4 && strcmp(argv[1], "generate") == 0 && isWorkloadGeneratorSpec(argv[3]))
+        return generateTraceFromSpec(argv[2], argv[3]);
+    if ((argc == 4 || argc == 5) && strcmp(argv[1], "generate") == 0) {
+        unsigned long long numberOfTasks = strtoull(argv[3], NULL, 10);
+        unsigned int seed = (argc == 5) ? (unsigned int)strtoul(argv[4], NULL, 10) : 42;
+        return generateTrace(argv[2], numberOfTasks, seed);
+    }
+    if (argc == 3 && strcmp(argv[1], "dump") == 0)
+        return dumpTrace(argv[2]);
+
+    printUsage(argv[0]);
+    return 1;
+}